@@ -5,6 +5,7 @@
 
 #include "addresultdialog.hpp"
 #include "handdialog.hpp"
+#include "handdictionary.hpp"
 #include "howtoscoredialog.hpp"
 #include "winning_hand.hpp"
 
@@ -308,6 +309,66 @@ unsigned AddResultDialog::FanScore() const { return fan_selector_->value(); }
 
 const WinningHand *AddResultDialog::winningHand() const { return hand_; }
 
+TurnResult AddResultDialog::turnResult() const {
+    if (RonVictory() == 2) { // Manual score
+        return TurnResult(ManualScores());
+    } else if (RonVictory() == 3) { // Draw
+        return TurnResult(DrawResult());
+    }
+    return TurnResult(EastPlayer(), Winner(), RonVictory(), Loser(),
+                      Player1DidRiichi(), Player2DidRiichi(),
+                      Player3DidRiichi(), Player4DidRiichi(), FuScore(),
+                      FanScore(), winningHand());
+}
+
+void AddResultDialog::setTurnResult(const TurnResult &turn_result) {
+    setWindowTitle(tr("Editing a round result"));
+
+    if (turn_result.isManualScore()) {
+        const std::vector<int> &scores = turn_result.manualScores();
+        score_manual_player_1_->setValue(scores[0]);
+        score_manual_player_2_->setValue(scores[1]);
+        score_manual_player_3_->setValue(scores[2]);
+        if (scores.size() == 4) {
+            score_manual_player_4_->setValue(scores[3]);
+        }
+        tabs_->setCurrentWidget(manual_tab_);
+        return;
+    } else if (turn_result.isDraw()) {
+        const std::vector<bool> &players_tenpai = turn_result.playersTenpai();
+        tenpai_player_1_->setChecked(players_tenpai[0]);
+        tenpai_player_2_->setChecked(players_tenpai[1]);
+        tenpai_player_3_->setChecked(players_tenpai[2]);
+        if (players_tenpai.size() == 4) {
+            tenpai_player_4_->setChecked(players_tenpai[3]);
+        }
+        tabs_->setCurrentWidget(draw_tab_);
+        return;
+    }
+
+    east_selector_->setCurrentIndex(turn_result.eastPlayer());
+    winner_selector_->setCurrentIndex(turn_result.winner());
+    ron_button_->setChecked(turn_result.ronVictory());
+    tsumo_button_->setChecked(!turn_result.ronVictory());
+    refreshLoserSelector();
+    if (turn_result.ronVictory()) {
+        loser_selector_->setCurrentText(player_names_[turn_result.loser()]);
+    }
+    riichi_player_1_->setChecked(turn_result.riichiPlayer1());
+    riichi_player_2_->setChecked(turn_result.riichiPlayer2());
+    riichi_player_3_->setChecked(turn_result.riichiPlayer3());
+    riichi_player_4_->setChecked(turn_result.riichiPlayer4());
+    fu_selector_->setValue(turn_result.fuScore());
+    fan_selector_->setValue(turn_result.fanScore());
+    if (turn_result.hand() != nullptr) {
+        // Shared with the turn results, rather than copied per edit
+        hand_ = HandDictionary::instance().intern(*turn_result.hand());
+        hand_dialog_button_->setIcon(hand_dialog_button_->style()->standardIcon(
+            QStyle::SP_FileDialogContentsView));
+    }
+    tabs_->setCurrentWidget(ron_tsumo_tab_);
+}
+
 void AddResultDialog::refreshLoserSelector() {
     // If ron button is not checked, loser selector is disabled
     if (!ron_button_->isChecked()) {
@@ -346,10 +407,7 @@ void AddResultDialog::showHandDialog() {
                                winner_selector_->currentText(),
                            WinnerDidRiichi());
     if (hand_dialog.exec() == QDialog::Accepted) {
-        if (hand_ != nullptr) {
-            delete hand_;
-        }
-        hand_ = new WinningHand(hand_dialog.hand());
+        hand_ = HandDictionary::instance().intern(hand_dialog.hand());
         hand_dialog_button_->setIcon(hand_dialog_button_->style()->standardIcon(
             QStyle::SP_FileDialogContentsView));
         HandScore score = hand_->computeScore();
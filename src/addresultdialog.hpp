@@ -105,6 +105,15 @@ class AddResultDialog : public QDialog {
 
     const WinningHand *winningHand() const;
 
+    /**
+     * @brief Build the turn result corresponding to the entered information
+     */
+    TurnResult turnResult() const;
+    /**
+     * @brief Fill the dialog with an existing turn result, for edition
+     */
+    void setTurnResult(const TurnResult &turn_result);
+
   private slots:
     /**
      * @brief Refresh the list of potential losers depending on the selected
@@ -194,5 +203,5 @@ class AddResultDialog : public QDialog {
     QPushButton *cancel_button_;      /**< Cancel button */
     QPushButton *help_button_;        /**< Help button */
 
-    WinningHand *hand_ = nullptr;
+    const WinningHand *hand_ = nullptr; /**< Hand of the dictionary */
 };
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include <QtEndian>
+
+#include "analysiswriter.hpp"
+
+static const char *const OUTCOME_NAMES[4] = {"tsumo", "ron", "manual", "draw"};
+static const char CSV_HEADER[] =
+    "file,turn,player_1,player_2,player_3,player_4,east,outcome,winner,loser,"
+    "fu,fan,hand,change_1,change_2,change_3,change_4\n";
+
+static bool isVictory(TurnOutcome outcome) {
+    return outcome == TurnOutcome::TSUMO || outcome == TurnOutcome::RON;
+}
+
+static QByteArray handString(const TurnResult &turn_result) {
+    if (turn_result.hand() == nullptr) {
+        return QByteArray();
+    }
+    const std::string hand = turn_result.hand()->toString();
+    return QByteArray(hand.data(), static_cast<int>(hand.size()));
+}
+
+static void appendCsvField(QByteArray &out, const QByteArray &utf8) {
+    if (utf8.contains(',') || utf8.contains('"') || utf8.contains('\n') ||
+        utf8.contains('\r')) {
+        out.append('"');
+        for (const char c : utf8) {
+            if (c == '"') {
+                out.append('"');
+            }
+            out.append(c);
+        }
+        out.append('"');
+    } else {
+        out.append(utf8);
+    }
+}
+
+template <typename T> static void appendLittleEndian(QByteArray &out, T value) {
+    const T little_endian = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&little_endian), sizeof(T));
+}
+
+static void appendBinaryString(QByteArray &out, const QByteArray &utf8) {
+    appendLittleEndian<quint16>(out, utf8.size());
+    out.append(utf8);
+}
+
+AnalysisWriter::AnalysisWriter(Format format, QIODevice &device)
+    : device_(device), failed_(false) {
+    buffer_.reserve(BUFFER_SIZE);
+    if (format == Format::CSV) {
+        buffer_.append(CSV_HEADER);
+    } else if (format == Format::BINARY) {
+        buffer_.append(MSSX_MAGIC, sizeof(MSSX_MAGIC));
+        appendLittleEndian<quint16>(buffer_, MSSX_VERSION);
+    }
+}
+
+AnalysisWriter::~AnalysisWriter() { flush(); }
+
+bool AnalysisWriter::formatFromString(const QString &name, Format &format) {
+    if (name == "text") {
+        format = Format::TEXT;
+    } else if (name == "jsonl") {
+        format = Format::JSONL;
+    } else if (name == "csv") {
+        format = Format::CSV;
+    } else if (name == "binary") {
+        format = Format::BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QByteArray AnalysisWriter::encode(Format format, const QString &file_name,
+                                  const ScoresheetData &data, bool named) {
+    QByteArray out;
+    switch (format) {
+    case Format::TEXT:
+        encodeText(file_name, data, named, out);
+        break;
+    case Format::JSONL:
+        encodeJsonl(file_name, data, out);
+        break;
+    case Format::CSV:
+        encodeCsv(file_name, data, out);
+        break;
+    case Format::BINARY:
+        encodeBinary(file_name, data, out);
+        break;
+    }
+    return out;
+}
+
+void AnalysisWriter::appendJsonString(QByteArray &out,
+                                      const QByteArray &utf8) {
+    out.append('"');
+    for (const char c : utf8) {
+        if (c == '"' || c == '\\') {
+            out.append('\\').append(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out.append("\\u00")
+                .append(QByteArray::number(static_cast<int>(c), 16)
+                            .rightJustified(2, '0'));
+        } else {
+            out.append(c);
+        }
+    }
+    out.append('"');
+}
+
+void AnalysisWriter::write(const QByteArray &analysis) {
+    if (buffer_.size() + analysis.size() > BUFFER_SIZE) {
+        // A failure is recorded, and reported by the next flush()
+        flush();
+    }
+    if (analysis.size() >= BUFFER_SIZE) {
+        if (device_.write(analysis) != analysis.size()) {
+            failed_ = true;
+        }
+    } else {
+        buffer_.append(analysis);
+    }
+}
+
+bool AnalysisWriter::flush() {
+    if (!buffer_.isEmpty()) {
+        if (device_.write(buffer_) != buffer_.size()) {
+            failed_ = true;
+        }
+        buffer_.clear();
+    }
+    return !failed_;
+}
+
+void AnalysisWriter::encodeText(const QString &file_name,
+                                const ScoresheetData &data, bool named,
+                                QByteArray &out) {
+    if (named) {
+        out.append("# ").append(file_name.toUtf8()).append('\n');
+    }
+    out.append(QByteArray::number(data.n_players)).append('\n');
+    for (int i = 0; i < data.n_players; i++) {
+        out.append(data.player_names[i].toUtf8()).append('\n');
+    }
+    for (const TurnResult &result : data.turn_results) {
+        const std::vector<int> score_change =
+            result.computeScoreChange(data.n_players);
+        out.append(QByteArray::number(score_change[0]));
+        for (size_t i = 1; i < score_change.size(); i++) {
+            out.append(' ').append(QByteArray::number(score_change[i]));
+        }
+        out.append('\n');
+    }
+}
+
+void AnalysisWriter::encodeJsonl(const QString &file_name,
+                                 const ScoresheetData &data, QByteArray &out) {
+    out.append("{\"file\":");
+    appendJsonString(out, file_name.toUtf8());
+    out.append(",\"players\":[");
+    for (int i = 0; i < data.n_players; i++) {
+        if (i > 0) {
+            out.append(',');
+        }
+        appendJsonString(out, data.player_names[i].toUtf8());
+    }
+    out.append("],\"beginning_score\":")
+        .append(QByteArray::number(data.beginning_score))
+        .append(",\"turns\":[");
+    for (size_t turn = 0; turn < data.turn_results.size(); turn++) {
+        const TurnResult &result = data.turn_results[turn];
+        const TurnOutcome outcome = result.outcome();
+        if (turn > 0) {
+            out.append(',');
+        }
+        out.append("{\"east\":")
+            .append(QByteArray::number(result.eastPlayer()))
+            .append(",\"outcome\":\"")
+            .append(OUTCOME_NAMES[static_cast<int>(outcome)])
+            .append('"');
+        if (isVictory(outcome)) {
+            out.append(",\"winner\":")
+                .append(QByteArray::number(result.winner()))
+                .append(",\"loser\":")
+                .append(outcome == TurnOutcome::RON
+                            ? QByteArray::number(result.loser())
+                            : QByteArray("null"))
+                .append(",\"fu\":")
+                .append(QByteArray::number(result.fuScore()))
+                .append(",\"fan\":")
+                .append(QByteArray::number(result.fanScore()))
+                .append(",\"hand\":");
+            if (result.hand() != nullptr) {
+                appendJsonString(out, handString(result));
+            } else {
+                out.append("null");
+            }
+        }
+        out.append(",\"score_change\":[");
+        const std::vector<int> score_change =
+            result.computeScoreChange(data.n_players);
+        for (size_t i = 0; i < score_change.size(); i++) {
+            if (i > 0) {
+                out.append(',');
+            }
+            out.append(QByteArray::number(score_change[i]));
+        }
+        out.append("]}");
+    }
+    out.append("]}\n");
+}
+
+void AnalysisWriter::encodeCsv(const QString &file_name,
+                               const ScoresheetData &data, QByteArray &out) {
+    // The columns shared by the rows of the scoresheet
+    QByteArray prefix;
+    appendCsvField(prefix, file_name.toUtf8());
+    QByteArray players;
+    for (int i = 0; i < 4; i++) {
+        players.append(',');
+        if (i < data.n_players) {
+            appendCsvField(players, data.player_names[i].toUtf8());
+        }
+    }
+
+    for (size_t turn = 0; turn < data.turn_results.size(); turn++) {
+        const TurnResult &result = data.turn_results[turn];
+        const TurnOutcome outcome = result.outcome();
+        out.append(prefix)
+            .append(',')
+            .append(QByteArray::number(static_cast<qint64>(turn)))
+            .append(players)
+            .append(',')
+            .append(QByteArray::number(result.eastPlayer()))
+            .append(',')
+            .append(OUTCOME_NAMES[static_cast<int>(outcome)])
+            .append(',');
+        if (isVictory(outcome)) {
+            out.append(QByteArray::number(result.winner())).append(',');
+            if (outcome == TurnOutcome::RON) {
+                out.append(QByteArray::number(result.loser()));
+            }
+            out.append(',')
+                .append(QByteArray::number(result.fuScore()))
+                .append(',')
+                .append(QByteArray::number(result.fanScore()))
+                .append(',')
+                .append(handString(result));
+        } else {
+            out.append(",,,,");
+        }
+        const std::vector<int> score_change =
+            result.computeScoreChange(data.n_players);
+        for (int i = 0; i < 4; i++) {
+            out.append(',');
+            if (i < static_cast<int>(score_change.size())) {
+                out.append(QByteArray::number(score_change[i]));
+            }
+        }
+        out.append('\n');
+    }
+}
+
+void AnalysisWriter::encodeBinary(const QString &file_name,
+                                  const ScoresheetData &data,
+                                  QByteArray &out) {
+    appendBinaryString(out, file_name.toUtf8());
+    appendLittleEndian<quint8>(out, data.n_players);
+    for (int i = 0; i < data.n_players; i++) {
+        appendBinaryString(out, data.player_names[i].toUtf8());
+    }
+    const int n_turns = data.turn_results.size();
+    appendLittleEndian<quint32>(out, n_turns);
+
+    // Turns are written column by column, so that readers can load a column
+    // at once
+    std::vector<TurnOutcome> outcomes;
+    outcomes.reserve(n_turns);
+    for (const TurnResult &result : data.turn_results) {
+        outcomes.push_back(result.outcome());
+    }
+    out.reserve(out.size() + n_turns * (8 + 4 * data.n_players));
+    for (const TurnResult &result : data.turn_results) {
+        appendLittleEndian<quint8>(out, result.eastPlayer());
+    }
+    for (const TurnOutcome outcome : outcomes) {
+        appendLittleEndian<quint8>(out, static_cast<quint8>(outcome));
+    }
+    for (int turn = 0; turn < n_turns; turn++) {
+        appendLittleEndian<quint8>(out, isVictory(outcomes[turn])
+                                            ? data.turn_results[turn].winner()
+                                            : 0xFF);
+    }
+    for (int turn = 0; turn < n_turns; turn++) {
+        appendLittleEndian<quint8>(out, outcomes[turn] == TurnOutcome::RON
+                                            ? data.turn_results[turn].loser()
+                                            : 0xFF);
+    }
+    for (int turn = 0; turn < n_turns; turn++) {
+        appendLittleEndian<quint16>(
+            out, isVictory(outcomes[turn]) ? data.turn_results[turn].fuScore()
+                                           : 0);
+    }
+    for (int turn = 0; turn < n_turns; turn++) {
+        appendLittleEndian<quint16>(
+            out, isVictory(outcomes[turn]) ? data.turn_results[turn].fanScore()
+                                           : 0);
+    }
+
+    // Score changes, player by player
+    std::vector<qint32> score_changes(n_turns * data.n_players);
+    for (int turn = 0; turn < n_turns; turn++) {
+        const std::vector<int> score_change =
+            data.turn_results[turn].computeScoreChange(data.n_players);
+        for (int i = 0; i < data.n_players; i++) {
+            score_changes[i * n_turns + turn] = score_change[i];
+        }
+    }
+    for (const qint32 score_change : score_changes) {
+        appendLittleEndian<qint32>(out, score_change);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QtGlobal>
+
+#include "scoresheetdata.hpp"
+
+/*
+ * Analysis output formats
+ *
+ * text: the number of players, the player names and the score changes of
+ *       every turn, one line each (several analyses are separated by a
+ *       "# <file>" line)
+ * jsonl: one JSON object per scoresheet, with its file, its players and its
+ *        turns (east player, outcome, winner, loser, fu, fan, hand and score
+ *        changes)
+ * csv: one row per turn, with the same fields as jsonl and the player names,
+ *      after a header row
+ * binary: columnar dump, all integers little-endian. The output starts with
+ *         "MSSX" and a 16-bit version, then each scoresheet is made of:
+ *          - its file name and player names, each one as a 16-bit length
+ *            followed by UTF-8 bytes (preceded by the 8-bit number of
+ *            players)
+ *          - the 32-bit number of turns n_turns
+ *          - the columns of the turns, n_turns values each: east player,
+ *            outcome, winner and loser (8-bit), fu and fan (16-bit), then the
+ *            score changes of each player (32-bit)
+ *         Hands are not stored in the binary format.
+ */
+
+static const char MSSX_MAGIC[4] = {'M', 'S', 'S', 'X'};
+static const quint16 MSSX_VERSION = 1;
+
+/**
+ * @brief Buffered writer of scoresheet analyses
+ *
+ * The analyses are encoded independently (possibly on several threads) by
+ * encode(), then appended in order to a large buffer which is only written
+ * to the device when full, so that the output costs a few system calls
+ * whatever the number of turns.
+ */
+class AnalysisWriter {
+  public:
+    enum class Format { TEXT, JSONL, CSV, BINARY };
+
+    /**
+     * @brief Writes the header of the format (if any) to the buffer
+     */
+    AnalysisWriter(Format format, QIODevice &device);
+    /**
+     * @brief Flushes the buffer (call flush() before to know whether the
+     * output is complete)
+     */
+    ~AnalysisWriter();
+
+    /**
+     * @brief Parse a format name (text, jsonl, csv or binary)
+     *
+     * @return false if the name is unknown
+     */
+    static bool formatFromString(const QString &name, Format &format);
+
+    /**
+     * @brief Encode the analysis of a scoresheet in the given format
+     *
+     * @param named whether the text format starts with the file name
+     */
+    static QByteArray encode(Format format, const QString &file_name,
+                             const ScoresheetData &data, bool named = false);
+
+    /**
+     * @brief Append a string to JSON output, quoted and escaped
+     */
+    static void appendJsonString(QByteArray &out, const QByteArray &utf8);
+
+    /**
+     * @brief Append an encoded analysis to the buffer
+     */
+    void write(const QByteArray &analysis);
+    /**
+     * @brief Write the buffer to the device
+     *
+     * @return false if the device failed, now or since the writer was
+     * created (the output is then truncated)
+     */
+    bool flush();
+
+  private:
+    static const int BUFFER_SIZE = 1 << 20;
+
+    static void encodeText(const QString &file_name,
+                           const ScoresheetData &data, bool named,
+                           QByteArray &out);
+    static void encodeJsonl(const QString &file_name,
+                            const ScoresheetData &data, QByteArray &out);
+    static void encodeCsv(const QString &file_name,
+                          const ScoresheetData &data, QByteArray &out);
+    static void encodeBinary(const QString &file_name,
+                             const ScoresheetData &data, QByteArray &out);
+
+    QIODevice &device_; /**< Output device */
+    QByteArray buffer_; /**< Analyses not written to the device yet */
+    bool failed_;       /**< Whether a write to the device failed */
+};
@@ -0,0 +1,140 @@
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include "autosaver.hpp"
+
+AutoSaver::AutoSaver(ScoreModel *score_model, ScoresheetJournal *journal,
+                     QObject *parent)
+    : QObject(parent), score_model_(score_model), journal_(journal),
+      saving_(false), pending_(false), generation_(0), started_generation_(0),
+      n_records_(0) {
+    delay_timer_.setSingleShot(true);
+    delay_timer_.setInterval(AUTOSAVE_DELAY_MS);
+    connect(&delay_timer_, &QTimer::timeout, this, &AutoSaver::saveNow);
+    connect(&encode_watcher_, &QFutureWatcher<EncodedScoresheet>::finished,
+            this, &AutoSaver::encodingFinished);
+    connect(&write_watcher_, &QFutureWatcher<QString>::finished, this,
+            &AutoSaver::writingFinished);
+
+    connect(score_model_, &ScoreModel::turnResultInserted, this,
+            &AutoSaver::schedule);
+    connect(score_model_, &ScoreModel::turnResultReplaced, this,
+            &AutoSaver::schedule);
+    connect(score_model_, &ScoreModel::turnResultDeleted, this,
+            &AutoSaver::schedule);
+    connect(score_model_, &ScoreModel::modelReset, this, &AutoSaver::cancel);
+    connect(journal_, &ScoresheetJournal::compactionNeeded, this,
+            &AutoSaver::saveNow);
+}
+
+AutoSaver::~AutoSaver() { cancel(); }
+
+bool AutoSaver::isSaving() const { return saving_; }
+
+void AutoSaver::schedule() {
+    if (journal_->isOpen()) {
+        delay_timer_.start();
+    }
+}
+
+void AutoSaver::saveNow() {
+    delay_timer_.stop();
+    if (saving_) {
+        pending_ = true;
+    } else {
+        start();
+    }
+}
+
+void AutoSaver::cancel() {
+    delay_timer_.stop();
+    pending_ = false;
+    generation_++;
+    // A file being replaced must be replaced before anything else writes it
+    encode_watcher_.waitForFinished();
+    write_watcher_.waitForFinished();
+    saving_ = false;
+}
+
+void AutoSaver::start() {
+    if (!journal_->isOpen()) {
+        return;
+    }
+    saving_ = true;
+    started_generation_ = generation_;
+    latency_timer_.start();
+    file_name_ = journal_->fileName();
+    n_records_ = journal_->recordCount();
+
+    // Turn results are copied (their hands are immutable and shared), the
+    // serialization happens on the thread pool
+    const bool binary = ScoresheetData::isBinaryFileName(file_name_);
+    ScoresheetData data = score_model_->toScoresheetData();
+    encode_watcher_.setFuture(
+        QtConcurrent::run([data = std::move(data), binary]() {
+            EncodedScoresheet encoded;
+            if (data.encode(encoded.content, binary,
+                            &encoded.error_message)) {
+                encoded.hash = QCryptographicHash::hash(
+                                   encoded.content, QCryptographicHash::Sha1)
+                                   .toHex();
+            }
+            return encoded;
+        }));
+}
+
+void AutoSaver::encodingFinished() {
+    if (started_generation_ != generation_) {
+        return;
+    }
+    EncodedScoresheet encoded = encode_watcher_.result();
+    if (!encoded.error_message.isEmpty()) {
+        emit saveFailed(file_name_, encoded.error_message);
+        finish();
+        return;
+    }
+
+    // The journal must know which records the new snapshot holds before the
+    // snapshot replaces the file
+    if (!journal_->checkpoint(encoded.hash, n_records_)) {
+        emit saveFailed(file_name_, tr("Unable to write the journal"));
+        finish();
+        return;
+    }
+    hash_ = encoded.hash;
+
+    const QString file_name = file_name_;
+    write_watcher_.setFuture(QtConcurrent::run(
+        [file_name, content = std::move(encoded.content)]() {
+            QSaveFile file(file_name);
+            if (!file.open(QIODevice::WriteOnly) ||
+                file.write(content) != content.size() || !file.commit()) {
+                return file.errorString();
+            }
+            return QString();
+        }));
+}
+
+void AutoSaver::writingFinished() {
+    if (started_generation_ != generation_) {
+        return;
+    }
+    const QString error_message = write_watcher_.result();
+    if (!error_message.isEmpty()) {
+        emit saveFailed(file_name_, error_message);
+    } else {
+        // Drop the records now held by the snapshot from the journal
+        journal_->rebase(hash_, n_records_);
+        emit saved(file_name_, latency_timer_.elapsed());
+    }
+    finish();
+}
+
+void AutoSaver::finish() {
+    saving_ = false;
+    if (pending_) {
+        pending_ = false;
+        start();
+    }
+}
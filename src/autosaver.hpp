@@ -0,0 +1,98 @@
+#pragma once
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include "scoremodel.hpp"
+#include "scoresheetjournal.hpp"
+
+/**
+ * @brief Serialized snapshot of a scoresheet, produced on a worker thread
+ */
+struct EncodedScoresheet {
+    QByteArray content;    /**< Content of the scoresheet file */
+    QByteArray hash;       /**< SHA-1 of the content */
+    QString error_message; /**< Empty if the scoresheet could be encoded */
+};
+
+/**
+ * @brief Debounced background rewriting of the journaled scoresheet file
+ *
+ * A while after the last change, the turn list of the score model is copied
+ * and the copy is serialized then written on the thread pool, to a temporary
+ * file atomically renamed over the scoresheet file. The GUI thread only
+ * copies the turns and writes the journal checkpoint in between, so the
+ * interface stays responsive whatever the size of the scoresheet and the
+ * speed of the storage.
+ */
+class AutoSaver : public QObject {
+    Q_OBJECT
+  public:
+    static const int AUTOSAVE_DELAY_MS = 2000; /**< Delay after a change */
+
+    AutoSaver(ScoreModel *score_model, ScoresheetJournal *journal,
+              QObject *parent = nullptr);
+    /**
+     * @brief Waits for the autosave in progress, if any
+     */
+    ~AutoSaver();
+
+    bool isSaving() const;
+
+  public slots:
+    /**
+     * @brief Autosave once no change happened for AUTOSAVE_DELAY_MS
+     */
+    void schedule();
+    /**
+     * @brief Autosave right away (or after the autosave in progress)
+     */
+    void saveNow();
+    /**
+     * @brief Drop the scheduled autosave and wait for the one in progress,
+     * whose result is discarded
+     */
+    void cancel();
+
+  signals:
+    /**
+     * @brief Emitted when an autosave is complete
+     *
+     * @param latency_ms time from the start of the autosave to the
+     * replacement of the file
+     */
+    void saved(const QString &file_name, qint64 latency_ms);
+    void saveFailed(const QString &file_name, const QString &error_message);
+
+  private slots:
+    void encodingFinished();
+    void writingFinished();
+
+  private:
+    /**
+     * @brief Snapshot the score model and start encoding it
+     */
+    void start();
+    /**
+     * @brief End the autosave in progress and start the next one if changes
+     * happened meanwhile
+     */
+    void finish();
+
+    ScoreModel *score_model_;     /**< Saved score model */
+    ScoresheetJournal *journal_;  /**< Journal of the saved scoresheet */
+    QTimer delay_timer_;          /**< Debounces the changes */
+    QElapsedTimer latency_timer_; /**< Measures the autosave in progress */
+    QFutureWatcher<EncodedScoresheet> encode_watcher_;
+    QFutureWatcher<QString> write_watcher_; /**< Error, empty on success */
+    bool saving_;     /**< An autosave is in progress */
+    bool pending_;    /**< Changes happened during the autosave */
+    int generation_;  /**< Incremented when cancelled */
+    int started_generation_; /**< Generation of the autosave in progress */
+    QString file_name_;      /**< File of the autosave in progress */
+    QByteArray hash_;        /**< SHA-1 of the autosave in progress */
+    int n_records_; /**< Journal records held by the autosave in progress */
+};
@@ -0,0 +1,401 @@
+#include <QtEndian>
+#include <cstring>
+
+#include "binaryscoresheet.hpp"
+#include "handdictionary.hpp"
+
+static const char SUITS[5] = {0, BAMBOO, CHARACTER, DOT, HONOR};
+
+/** Offset of the turn records: after the names, aligned on 8 bytes */
+static quint32 turnsOffset(quint32 names_offset, quint32 names_size) {
+    return (names_offset + names_size + 7) & ~static_cast<quint32>(7);
+}
+
+/** Whether a code is a tile, as accepted by Tile::fromString */
+static bool isTileCode(quint8 code) {
+    return (code >> 4) >= 1 && (code >> 4) <= 4 && (code & 0xf) >= 1 &&
+           (code & 0xf) <= 9;
+}
+
+/** Whether an encoded hand decodes to a hand the text format can hold */
+static bool isValidHand(const MssbHand &h) {
+    if (h.ippatsu > 1 ||
+        (h.prevailing_wind != 0 && !isTileCode(h.prevailing_wind)) ||
+        (h.player_wind != 0 && !isTileCode(h.player_wind))) {
+        return false;
+    }
+    int n_tiles;
+    if (h.type == static_cast<quint8>(HandType::CLASSIC)) {
+        for (int i = 0; i < 4; i++) {
+            if ((h.groups[i] & 0x3) > static_cast<int>(ClassicGroupType::KAN)) {
+                return false;
+            }
+        }
+        n_tiles = 5;
+    } else if (h.type == static_cast<quint8>(HandType::PAIRS)) {
+        n_tiles = 7;
+    } else if (h.type == static_cast<quint8>(HandType::ORPHANS)) {
+        n_tiles = 1;
+    } else {
+        return false;
+    }
+    for (int i = 0; i < n_tiles; i++) {
+        if (!isTileCode(h.tiles[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Whether a turn record holds the values MssParser accepts, so that
+ * the turn results can index the players with them
+ */
+static bool isValidRecord(const MssbTurnRecord &record, int n_players) {
+    // Bits of the riichi or tenpai flags of the missing players
+    const quint8 missing_players = 0xf & ~((1 << n_players) - 1);
+    if (record.outcome > 3 || (record.flags & missing_players) != 0) {
+        return false;
+    }
+    if (record.outcome >= 2) { // Manual result or draw
+        return true;
+    }
+    return record.east_player < n_players && record.winner < n_players &&
+           (record.outcome == 0 || record.loser < n_players) &&
+           ((record.flags & MSSB_HAS_HAND) == 0 || isValidHand(record.hand));
+}
+
+BinaryScoresheet::BinaryScoresheet(const uchar *data, qint64 size)
+    : data_(data), size_(size) {
+    if (data_ == nullptr || size_ < static_cast<qint64>(sizeof(MssbHeader))) {
+        error_string_ = "File too small for a binary scoresheet";
+        return;
+    }
+    const MssbHeader *header = reinterpret_cast<const MssbHeader *>(data_);
+    if (std::memcmp(header->magic, MSSB_MAGIC, sizeof(MSSB_MAGIC)) != 0) {
+        error_string_ = "Not a binary scoresheet";
+        return;
+    }
+    if (qFromLittleEndian(header->version) != MSSB_VERSION) {
+        error_string_ = QString("Unsupported binary scoresheet version %1")
+                            .arg(qFromLittleEndian(header->version));
+        return;
+    }
+    if (header->n_players < 3 || header->n_players > 4) {
+        error_string_ = "Number of players must be 3 or 4";
+        return;
+    }
+    const qint64 names_end =
+        static_cast<qint64>(qFromLittleEndian(header->names_offset)) +
+        qFromLittleEndian(header->names_size);
+    const qint64 turns_end =
+        static_cast<qint64>(qFromLittleEndian(header->turns_offset)) +
+        static_cast<qint64>(qFromLittleEndian(header->n_turns)) *
+            sizeof(MssbTurnRecord);
+    if (names_end > size_ || turns_end > size_ ||
+        qFromLittleEndian(header->turns_offset) % 8 != 0) {
+        error_string_ = "Truncated or corrupted binary scoresheet";
+        return;
+    }
+    // Check that the names block holds one name per player
+    qint64 offset = qFromLittleEndian(header->names_offset);
+    for (int i = 0; i < header->n_players; i++) {
+        if (offset + 2 > names_end) {
+            error_string_ = "Truncated player names";
+            return;
+        }
+        offset += 2 + qFromLittleEndian<quint16>(data_ + offset);
+    }
+    if (offset > names_end) {
+        error_string_ = "Truncated player names";
+        return;
+    }
+    // Check the turn records once, so that they can be decoded as is
+    const int n_turns = turnCount();
+    for (int i = 0; i < n_turns; i++) {
+        if (!isValidRecord(turnRecord(i), header->n_players)) {
+            error_string_ = QString("Corrupted turn record %1").arg(i + 1);
+            return;
+        }
+    }
+}
+
+bool BinaryScoresheet::isValid() const { return error_string_.isEmpty(); }
+const QString &BinaryScoresheet::errorString() const { return error_string_; }
+
+int BinaryScoresheet::nPlayers() const {
+    return reinterpret_cast<const MssbHeader *>(data_)->n_players;
+}
+
+QString BinaryScoresheet::playerName(int player) const {
+    const MssbHeader *header = reinterpret_cast<const MssbHeader *>(data_);
+    const uchar *name = data_ + qFromLittleEndian(header->names_offset);
+    for (int i = 0; i < player; i++) {
+        name += 2 + qFromLittleEndian<quint16>(name);
+    }
+    return QString::fromUtf8(reinterpret_cast<const char *>(name + 2),
+                             qFromLittleEndian<quint16>(name));
+}
+
+int BinaryScoresheet::beginningScore() const {
+    return qFromLittleEndian(
+        reinterpret_cast<const MssbHeader *>(data_)->beginning_score);
+}
+
+int BinaryScoresheet::turnCount() const {
+    return qFromLittleEndian(
+        reinterpret_cast<const MssbHeader *>(data_)->n_turns);
+}
+
+const MssbTurnRecord &BinaryScoresheet::turnRecord(int turn_index) const {
+    const MssbHeader *header = reinterpret_cast<const MssbHeader *>(data_);
+    return reinterpret_cast<const MssbTurnRecord *>(
+        data_ + qFromLittleEndian(header->turns_offset))[turn_index];
+}
+
+TurnResult BinaryScoresheet::turnResult(int turn_index) const {
+    const MssbTurnRecord &record = turnRecord(turn_index);
+    const int n_players = nPlayers();
+
+    if (record.outcome == 2) { // Manual result
+        std::vector<int> scores(n_players, 0);
+        for (int i = 0; i < n_players; i++) {
+            scores[i] = qFromLittleEndian(record.manual_scores[i]);
+        }
+        return TurnResult(scores, record.east_player, record.winner);
+    } else if (record.outcome == 3) { // Draw
+        std::vector<bool> players_tenpai(n_players, false);
+        for (int i = 0; i < n_players; i++) {
+            players_tenpai[i] = (record.flags >> i) & 1;
+        }
+        return TurnResult(players_tenpai, record.east_player, record.winner);
+    }
+
+    const bool winner_riichi = (record.flags >> record.winner) & 1;
+    const WinningHand *hand = nullptr;
+    if (record.flags & MSSB_HAS_HAND) {
+        // Decoded once per distinct hand, then shared by the turns
+        hand = HandDictionary::instance().internEncoded(
+            record.hand, winner_riichi, record.outcome == 1);
+    }
+
+    return TurnResult(record.east_player, record.winner, record.outcome,
+                      record.loser, record.flags & 1, (record.flags >> 1) & 1,
+                      (record.flags >> 2) & 1, (record.flags >> 3) & 1,
+                      record.fu_score, record.fan_score, hand);
+}
+
+bool BinaryScoresheet::read(ScoresheetData &data,
+                            const ProgressCallback &progress) const {
+    data.n_players = nPlayers();
+    data.player_names = std::vector<QString>(4, QString());
+    for (int i = 0; i < data.n_players; i++) {
+        data.player_names[i] = playerName(i);
+    }
+    data.beginning_score = beginningScore();
+
+    const int n_turns = turnCount();
+    data.turn_results.clear();
+    data.turn_results.reserve(n_turns);
+    for (int i = 0; i < n_turns; i++) {
+        if (progress && i % PROGRESS_INTERVAL == 0 && !progress(i, n_turns)) {
+            return false;
+        }
+        data.turn_results.push_back(turnResult(i));
+    }
+    return true;
+}
+
+bool BinaryScoresheet::encode(const ScoresheetData &data, QByteArray &out,
+                              QString *error_message) {
+    /* Player names */
+    QByteArray names;
+    for (int i = 0; i < data.n_players; i++) {
+        QByteArray name = data.player_names[i].toUtf8();
+        if (name.size() > 0xffff) {
+            if (error_message != nullptr) {
+                *error_message = "Player name too long";
+            }
+            return false;
+        }
+        uchar length[2];
+        qToLittleEndian<quint16>(name.size(), length);
+        names.append(reinterpret_cast<const char *>(length), 2);
+        names.append(name);
+    }
+
+    MssbHeader header;
+    std::memcpy(header.magic, MSSB_MAGIC, sizeof(MSSB_MAGIC));
+    header.version = qToLittleEndian(MSSB_VERSION);
+    header.n_players = data.n_players;
+    header.reserved = 0;
+    header.beginning_score = qToLittleEndian<qint32>(data.beginning_score);
+    header.n_turns = qToLittleEndian<quint32>(data.turn_results.size());
+    header.names_offset = qToLittleEndian<quint32>(sizeof(MssbHeader));
+    header.names_size = qToLittleEndian<quint32>(names.size());
+    const quint32 turns_offset = turnsOffset(sizeof(MssbHeader), names.size());
+    header.turns_offset = qToLittleEndian(turns_offset);
+    header.reserved2 = 0;
+
+    out.clear();
+    out.reserve(turns_offset + data.turn_results.size() * sizeof(MssbTurnRecord));
+    out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.append(names);
+    out.append(QByteArray(turns_offset - out.size(), '\0'));
+
+    /* Turn records */
+    for (const TurnResult &turn_result : data.turn_results) {
+        MssbTurnRecord record;
+        std::memset(&record, 0, sizeof(record));
+        // East and winner columns are meaningless for manual and draw turns
+        record.east_player = static_cast<quint8>(turn_result.eastPlayer());
+        record.winner = static_cast<quint8>(turn_result.winner());
+
+        if (turn_result.isManualScore()) {
+            record.outcome = 2;
+            const std::vector<int> &scores = turn_result.manualScores();
+            for (size_t i = 0; i < scores.size() && i < 4; i++) {
+                record.manual_scores[i] = qToLittleEndian<qint32>(scores[i]);
+            }
+        } else if (turn_result.isDraw()) {
+            record.outcome = 3;
+            const std::vector<bool> &players_tenpai =
+                turn_result.playersTenpai();
+            for (size_t i = 0; i < players_tenpai.size() && i < 4; i++) {
+                record.flags |= (players_tenpai[i] ? 1 : 0) << i;
+            }
+        } else {
+            if (turn_result.fuScore() < 0 || turn_result.fuScore() > 255 ||
+                turn_result.fanScore() < 0 || turn_result.fanScore() > 255) {
+                if (error_message != nullptr) {
+                    *error_message = "Fu or fan score out of range";
+                }
+                return false;
+            }
+            record.outcome = turn_result.ronVictory() ? 1 : 0;
+            record.loser = static_cast<quint8>(turn_result.loser());
+            record.flags = (turn_result.riichiPlayer1() ? 1 : 0) |
+                           (turn_result.riichiPlayer2() ? 2 : 0) |
+                           (turn_result.riichiPlayer3() ? 4 : 0) |
+                           (turn_result.riichiPlayer4() ? 8 : 0);
+            record.fu_score = turn_result.fuScore();
+            record.fan_score = turn_result.fanScore();
+
+            const WinningHand *hand = turn_result.hand();
+            if (hand != nullptr &&
+                (hand->totalDoras() < 0 || hand->totalDoras() > 255)) {
+                if (error_message != nullptr) {
+                    *error_message = "Number of doras out of range";
+                }
+                return false;
+            }
+            if (hand != nullptr) {
+                record.flags |= MSSB_HAS_HAND;
+                encodeHand(*hand, record.hand);
+            }
+        }
+        out.append(reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+
+    return true;
+}
+
+bool BinaryScoresheet::readFile(QFile &file, ScoresheetData &data,
+                                QString *error_message,
+                                const ProgressCallback &progress) {
+    // Map the file when possible, otherwise read it whole
+    QByteArray content;
+    const qint64 size = file.size();
+    uchar *mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (mapped == nullptr) {
+        content = file.readAll();
+    }
+
+    BinaryScoresheet scoresheet(
+        mapped != nullptr ? mapped
+                          : reinterpret_cast<const uchar *>(content.constData()),
+        mapped != nullptr ? size : content.size());
+    bool success = scoresheet.isValid();
+    if (success) {
+        success = scoresheet.read(data, progress);
+        if (!success && error_message != nullptr) {
+            *error_message = "Reading cancelled";
+        }
+    } else if (error_message != nullptr) {
+        *error_message = scoresheet.errorString();
+    }
+
+    if (mapped != nullptr) {
+        file.unmap(mapped);
+    }
+    return success;
+}
+
+void BinaryScoresheet::encodeHand(const WinningHand &hand, MssbHand &h) {
+    std::memset(&h, 0, sizeof(h));
+    h.type = static_cast<quint8>(hand.type());
+    h.ippatsu = hand.isIppatsu() ? 1 : 0;
+    h.total_doras = hand.totalDoras();
+    h.prevailing_wind = encodeTile(hand.prevailingWind());
+    h.player_wind = encodeTile(hand.playerWind());
+    const HandTiles tiles = hand.hand();
+    if (hand.type() == HandType::CLASSIC) {
+        for (int i = 0; i < 4; i++) {
+            const ClassicGroup &group = tiles.classic_hand.groups[i];
+            h.tiles[i] = encodeTile(group.tile);
+            h.groups[i] = static_cast<quint8>(group.type) |
+                          (group.melded ? 4 : 0) | (group.ron_meld ? 8 : 0);
+        }
+        h.tiles[4] = encodeTile(tiles.classic_hand.duo_tile);
+    } else if (hand.type() == HandType::PAIRS) {
+        for (int i = 0; i < 7; i++) {
+            h.tiles[i] = encodeTile(tiles.seven_pairs_hand[i]);
+        }
+    } else {
+        h.tiles[0] = encodeTile(tiles.duo_orphans_hand);
+    }
+}
+
+WinningHand BinaryScoresheet::decodeHand(const MssbHand &h, bool riichi,
+                                         bool ron) {
+    const Tile prevailing_wind = decodeTile(h.prevailing_wind);
+    const Tile player_wind = decodeTile(h.player_wind);
+    if (h.type == static_cast<quint8>(HandType::CLASSIC)) {
+        ClassicGroup groups[4];
+        for (int i = 0; i < 4; i++) {
+            groups[i] =
+                ClassicGroup(static_cast<ClassicGroupType>(h.groups[i] & 0x3),
+                             decodeTile(h.tiles[i]), (h.groups[i] >> 2) & 1,
+                             (h.groups[i] >> 3) & 1);
+        }
+        return WinningHand(ClassicHand(groups[0], groups[1], groups[2],
+                                       groups[3], decodeTile(h.tiles[4])),
+                           prevailing_wind, player_wind, riichi,
+                           h.ippatsu != 0, ron, h.total_doras);
+    } else if (h.type == static_cast<quint8>(HandType::PAIRS)) {
+        Tile pairs[7];
+        for (int i = 0; i < 7; i++) {
+            pairs[i] = decodeTile(h.tiles[i]);
+        }
+        return WinningHand(pairs, prevailing_wind, player_wind, riichi,
+                           h.ippatsu != 0, ron, h.total_doras);
+    }
+    return WinningHand(decodeTile(h.tiles[0]), prevailing_wind, player_wind,
+                       riichi, h.ippatsu != 0, ron, h.total_doras);
+}
+
+quint8 BinaryScoresheet::encodeTile(const Tile &tile) {
+    for (quint8 suit = 1; suit < 5; suit++) {
+        if (SUITS[suit] == tile.suit()) {
+            return (suit << 4) | (tile.value() & 0xf);
+        }
+    }
+    return 0;
+}
+
+Tile BinaryScoresheet::decodeTile(quint8 code) {
+    if (code == 0 || (code >> 4) > 4) {
+        return Tile();
+    }
+    return Tile(SUITS[code >> 4], code & 0xf);
+}
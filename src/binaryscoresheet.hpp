@@ -0,0 +1,165 @@
+#pragma once
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+#include "scoresheetdata.hpp"
+
+/*
+ * Binary scoresheet format (.mssb), version 1
+ *
+ * All integers are little-endian. The file is made of:
+ *  - a fixed-size header (MssbHeader)
+ *  - the player names, each one as a 16-bit length followed by UTF-8 bytes
+ *  - padding up to a multiple of 8 bytes
+ *  - n_turns fixed-size turn records (MssbTurnRecord)
+ *
+ * Every record can therefore be accessed in place from a memory mapping.
+ */
+
+static const char MSSB_MAGIC[4] = {'M', 'S', 'S', 'B'};
+static const quint16 MSSB_VERSION = 1;
+
+/**
+ * @brief Header of a binary scoresheet
+ */
+struct MssbHeader {
+    char magic[4];          /**< "MSSB" */
+    quint16 version;        /**< Format version */
+    quint8 n_players;       /**< Number of players (3 or 4) */
+    quint8 reserved;        /**< Always 0 */
+    qint32 beginning_score; /**< Initial score of each player */
+    quint32 n_turns;        /**< Number of turn records */
+    quint32 names_offset;   /**< Offset of the player names */
+    quint32 names_size;     /**< Size of the player names block */
+    quint32 turns_offset;   /**< Offset of the first turn record */
+    quint32 reserved2;      /**< Always 0 */
+};
+static_assert(sizeof(MssbHeader) == 32, "Unexpected MssbHeader layout");
+
+/**
+ * @brief Compact encoding of a winning hand
+ *
+ * Tiles are encoded on one byte: suit index (1 bamboo, 2 character, 3 dot,
+ * 4 honor) in the high nibble and value in the low nibble, 0 meaning none.
+ * The riichi and ron flags are not stored: they come from the turn.
+ */
+struct MssbHand {
+    quint8 type;            /**< HandType */
+    quint8 ippatsu;         /**< 1 if ippatsu */
+    quint8 total_doras;     /**< Number of doras */
+    quint8 prevailing_wind; /**< Encoded prevailing wind tile */
+    quint8 player_wind;     /**< Encoded player wind tile */
+    /** Classic: the 4 group tiles then the duo tile; seven pairs: the 7
+     * pair tiles; thirteen orphans: the duo tile */
+    quint8 tiles[7];
+    /** Classic only: ClassicGroupType in bits 0-1, melded in bit 2 and ron
+     * meld in bit 3 */
+    quint8 groups[4];
+};
+static_assert(sizeof(MssbHand) == 16, "Unexpected MssbHand layout");
+
+/** Turn record flag: a winning hand is stored in the record */
+static const quint8 MSSB_HAS_HAND = 0x80;
+
+/**
+ * @brief Fixed-size turn record
+ */
+struct MssbTurnRecord {
+    quint8 outcome;     /**< 0 tsumo, 1 ron, 2 manual score, 3 draw */
+    quint8 east_player; /**< Number of the East player */
+    quint8 winner;      /**< Number of the winner */
+    quint8 loser;       /**< Number of the loser */
+    /** Bits 0-3: riichi players (victory) or tenpai players (draw);
+     * bit 7: MSSB_HAS_HAND */
+    quint8 flags;
+    quint8 fu_score;  /**< Fu score */
+    quint8 fan_score; /**< Fan score */
+    quint8 reserved;  /**< Always 0 */
+    union {
+        MssbHand hand;             /**< Winning hand if MSSB_HAS_HAND */
+        qint32 manual_scores[4];   /**< Score changes of a manual result */
+    };
+};
+static_assert(sizeof(MssbTurnRecord) == 24, "Unexpected MssbTurnRecord layout");
+
+/**
+ * @brief Read-only view over a binary scoresheet held in memory
+ *
+ * The view does not copy nor parse the data: accessors read the header and
+ * the turn records in place, so the memory can come from a file mapping.
+ */
+class BinaryScoresheet {
+  public:
+    /**
+     * @brief Construct a view over size bytes starting at data, and check
+     * that they hold a valid binary scoresheet
+     *
+     * Every turn record is checked as MssParser checks the turn lines
+     * (outcome, player numbers, riichi of missing players, hand), so that
+     * the decoded turn results can be scored without further checks.
+     */
+    BinaryScoresheet(const uchar *data = nullptr, qint64 size = 0);
+
+    bool isValid() const;
+    const QString &errorString() const;
+
+    /* Getters */
+    int nPlayers() const;
+    QString playerName(int player) const;
+    int beginningScore() const;
+    int turnCount() const;
+    const MssbTurnRecord &turnRecord(int turn_index) const;
+
+    /**
+     * @brief Decode a turn record into a turn result
+     */
+    TurnResult turnResult(int turn_index) const;
+    /** Number of turns decoded between two progress reports */
+    static const int PROGRESS_INTERVAL = 16384;
+
+    /**
+     * @brief Decode the whole scoresheet
+     *
+     * @param progress if set, receives the number of decoded turns
+     * @return false if cancelled by the progress callback
+     */
+    bool read(ScoresheetData &data,
+              const ProgressCallback &progress = nullptr) const;
+
+    /**
+     * @brief Encode a scoresheet into the binary format
+     *
+     * @return false if the scoresheet holds values that do not fit in the
+     * format (the error is described in error_message if not null)
+     */
+    static bool encode(const ScoresheetData &data, QByteArray &out,
+                       QString *error_message = nullptr);
+    /**
+     * @brief Read a whole opened binary scoresheet file, mapping it in memory
+     * if possible
+     */
+    static bool readFile(QFile &file, ScoresheetData &data,
+                         QString *error_message = nullptr,
+                         const ProgressCallback &progress = nullptr);
+
+    /* Encoding utils */
+    /**
+     * @brief Encode a hand, whose number of doras must fit in a byte (as
+     * checked by encode())
+     */
+    static void encodeHand(const WinningHand &hand, MssbHand &encoded);
+    /**
+     * @brief Decode a hand, with the riichi and ron flags of its turn
+     */
+    static WinningHand decodeHand(const MssbHand &encoded, bool riichi,
+                                  bool ron);
+    static quint8 encodeTile(const Tile &tile);
+    static Tile decodeTile(quint8 code);
+
+  private:
+    const uchar *data_;    /**< Beginning of the scoresheet */
+    qint64 size_;          /**< Size of the scoresheet in bytes */
+    QString error_string_; /**< Why the data is invalid, empty if valid */
+};
@@ -0,0 +1,31 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+#include "../commandline.hpp"
+
+/*
+ * Headless command line executable: it only depends on QtCore, so it starts
+ * quickly and runs without display.
+ */
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCoreApplication::setOrganizationName("RiichiMahjongScoring");
+    QCoreApplication::setApplicationName("RiichiMahjongScoringCli");
+    QCoreApplication::setApplicationVersion("0.1");
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QCoreApplication::applicationName());
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    CommandLine command_line;
+    command_line.addOptions(parser);
+
+    parser.process(app);
+
+    int exit_code;
+    if (!command_line.run(parser, exit_code)) {
+        parser.showHelp(1);
+    }
+    return exit_code;
+}
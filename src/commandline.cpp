@@ -0,0 +1,970 @@
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <iostream>
+
+#include "commandline.hpp"
+#include "gamearchive.hpp"
+#include "seasonwatcher.hpp"
+
+CommandLine::CommandLine()
+    : analyze_option_(
+          QStringList() << "a" << "analyze",
+          tr("Analyze a scoresheet file, along with the scoresheet files, "
+             "directories and wildcard patterns given as arguments."),
+          "file"),
+      convert_option_(QStringList() << "c" << "convert",
+                      tr("Convert the scoresheet file given as argument to "
+                         "the output file (.mss or .mssb)."),
+                      "output"),
+      archive_append_option_(
+          "archive-append",
+          tr("Append the scoresheet files given as arguments to the archive, "
+             "replacing the games with the same name."),
+          "archive"),
+      archive_list_option_("archive-list",
+                           tr("List the games of the archive."), "archive"),
+      archive_compact_option_("archive-compact",
+                              tr("Remove the replaced games from the archive."),
+                              "archive"),
+      game_option_(QStringList() << "g" << "game",
+                   tr("Name of the game to use in an archive (every game "
+                      "by default)."),
+                   "name"),
+      format_option_(QStringList() << "f" << "format",
+                     tr("Format of the analysis: text, jsonl, csv or binary "
+                        "(text or jsonl for the statistics and the audit)."),
+                     "format", "text"),
+      stats_option_("stats",
+                    tr("Print the statistics of the players over the "
+                       "scoresheet files, directories and wildcard patterns "
+                       "given as arguments, in chronological order.")),
+      rolling_option_(
+          "rolling",
+          tr("With --stats, print the trend of the players instead: after "
+             "each session, the mean gain, the tsumo and ron rates and the "
+             "mean hand value of its players over their last n sessions."),
+          "n"),
+      rolling_turns_option_(
+          "rolling-turns",
+          tr("Like --rolling, over the last sessions of each player holding "
+             "at least n turns."),
+          "n"),
+      cache_option_("cache",
+                    tr("Reuse the analyses and statistics of the unchanged "
+                       "scoresheets, cached in the given index file."),
+                    "file"),
+      players_option_(
+          "players",
+          tr("Identify the players by the given registry file, which maps "
+             "their names and aliases to a single player, in the statistics, "
+             "the archive listing and the corpus store. The new players of "
+             "the statistics and the corpus store are added to the file."),
+          "file"),
+      watch_option_("watch",
+                    tr("Print the statistics of the scoresheets of the "
+                       "directory, then print them again whenever "
+                       "scoresheets are added, modified or removed."),
+                    "directory"),
+      audit_option_("audit",
+                    tr("Check the scoresheet files, directories, wildcard "
+                       "patterns and archives given as arguments: validity "
+                       "and score of the recorded hands, and balance of the "
+                       "score changes of every turn.")),
+      bundle_create_option_(
+          "bundle-create",
+          tr("Bundle the scoresheet files, directories and wildcard patterns "
+             "given as arguments into a compressed bundle (.mssz), which "
+             "--analyze, --stats and --audit accept as input."),
+          "bundle"),
+      bundle_list_option_("bundle-list",
+                          tr("List the scoresheet files of the bundle."),
+                          "bundle")
+#ifdef WITH_CORPUS_STORE
+      ,
+      store_ingest_option_(
+          "store-ingest",
+          tr("Add the scoresheet files, directories, wildcard patterns, "
+             "bundles and archives given as arguments to the SQLite corpus "
+             "store, replacing the games with the same name."),
+          "store"),
+      store_query_option_("store-query",
+                          tr("Run the SQL query given as argument on the "
+                             "corpus store and print the rows, "
+                             "tab-separated."),
+                          "store")
+#endif
+{
+}
+
+void CommandLine::addOptions(QCommandLineParser &parser) const {
+    parser.addOption(analyze_option_);
+    parser.addOption(convert_option_);
+    parser.addPositionalArgument(
+        "file",
+        tr("Scoresheet file(s) to convert, archive, bundle, analyze, "
+           "summarize or audit."),
+        "[file...]");
+    parser.addOption(archive_append_option_);
+    parser.addOption(archive_list_option_);
+    parser.addOption(archive_compact_option_);
+    parser.addOption(game_option_);
+    parser.addOption(format_option_);
+    parser.addOption(stats_option_);
+    parser.addOption(rolling_option_);
+    parser.addOption(rolling_turns_option_);
+    parser.addOption(cache_option_);
+    parser.addOption(players_option_);
+    parser.addOption(watch_option_);
+    parser.addOption(audit_option_);
+    parser.addOption(bundle_create_option_);
+    parser.addOption(bundle_list_option_);
+#ifdef WITH_CORPUS_STORE
+    parser.addOption(store_ingest_option_);
+    parser.addOption(store_query_option_);
+#endif
+}
+
+bool CommandLine::run(const QCommandLineParser &parser, int &exit_code) const {
+    if (parser.isSet(convert_option_)) {
+        if (parser.positionalArguments().size() != 1) {
+            std::cerr << "Conversion requires exactly one input file"
+                      << std::endl;
+            exit_code = -1;
+        } else {
+            exit_code = convert(parser.positionalArguments()[0],
+                                parser.value(convert_option_));
+        }
+    } else if (parser.isSet(archive_append_option_)) {
+        exit_code = archiveAppend(parser.value(archive_append_option_),
+                                  parser.positionalArguments());
+    } else if (parser.isSet(archive_compact_option_)) {
+        exit_code = archiveCompact(parser.value(archive_compact_option_));
+    } else if (parser.isSet(archive_list_option_)) {
+        exit_code = archiveList(parser.value(archive_list_option_),
+                                parser.value(players_option_));
+    } else if (parser.isSet(bundle_create_option_)) {
+        exit_code = bundleCreate(parser.value(bundle_create_option_),
+                                 parser.positionalArguments());
+    } else if (parser.isSet(bundle_list_option_)) {
+        exit_code = bundleList(parser.value(bundle_list_option_));
+#ifdef WITH_CORPUS_STORE
+    } else if (parser.isSet(store_ingest_option_)) {
+        exit_code = storeIngest(parser.value(store_ingest_option_),
+                                parser.positionalArguments(),
+                                parser.value(game_option_),
+                                parser.value(players_option_));
+    } else if (parser.isSet(store_query_option_)) {
+        exit_code = storeQuery(parser.value(store_query_option_),
+                               parser.positionalArguments());
+#endif
+    } else if (parser.isSet(audit_option_)) {
+        AnalysisWriter::Format format;
+        if (!AnalysisWriter::formatFromString(parser.value(format_option_),
+                                              format) ||
+            (format != AnalysisWriter::Format::TEXT &&
+             format != AnalysisWriter::Format::JSONL)) {
+            std::cerr << "Unknown audit format" << std::endl;
+            exit_code = -1;
+        } else {
+            exit_code = audit(parser.positionalArguments(),
+                              parser.value(game_option_), format);
+        }
+    } else if (parser.isSet(stats_option_) || parser.isSet(watch_option_)) {
+        AnalysisWriter::Format format;
+        if (!AnalysisWriter::formatFromString(parser.value(format_option_),
+                                              format) ||
+            (format != AnalysisWriter::Format::TEXT &&
+             format != AnalysisWriter::Format::JSONL)) {
+            std::cerr << "Unknown statistics format" << std::endl;
+            exit_code = -1;
+        } else if (parser.isSet(watch_option_)) {
+            exit_code = watch(parser.value(watch_option_), format,
+                              parser.value(players_option_));
+        } else {
+            const bool by_turns = parser.isSet(rolling_turns_option_);
+            int rolling_size = 0;
+            bool valid_size = true;
+            if (by_turns || parser.isSet(rolling_option_)) {
+                rolling_size = parser
+                                   .value(by_turns ? rolling_turns_option_
+                                                   : rolling_option_)
+                                   .toInt(&valid_size);
+                valid_size = valid_size && rolling_size > 0;
+            }
+            if (!valid_size) {
+                std::cerr << "Invalid rolling window size" << std::endl;
+                exit_code = -1;
+            } else {
+                exit_code = stats(
+                    parser.positionalArguments(), parser.value(game_option_),
+                    format, parser.value(cache_option_),
+                    parser.value(players_option_),
+                    by_turns ? RollingStats::Unit::TURNS
+                             : RollingStats::Unit::SESSIONS,
+                    rolling_size);
+            }
+        }
+    } else if (parser.isSet(analyze_option_)) {
+        AnalysisWriter::Format format;
+        if (!AnalysisWriter::formatFromString(parser.value(format_option_),
+                                              format)) {
+            std::cerr << "Unknown analysis format" << std::endl;
+            exit_code = -1;
+        } else {
+            exit_code = analyze(QStringList() << parser.value(analyze_option_)
+                                              << parser.positionalArguments(),
+                                parser.value(game_option_), format,
+                                parser.value(cache_option_));
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QStringList CommandLine::expandAnalysisInputs(const QStringList &inputs) {
+    const QStringList scoresheet_filters = QStringList() << "*.mss"
+                                                         << "*.mssb";
+    QStringList files;
+    for (const QString &input : inputs) {
+        const QFileInfo input_info(input);
+        QFileInfoList matches;
+        if (input_info.isDir()) {
+            matches = QDir(input).entryInfoList(scoresheet_filters, QDir::Files,
+                                                QDir::Name);
+        } else if (input_info.fileName().contains('*') ||
+                   input_info.fileName().contains('?') ||
+                   input_info.fileName().contains('[')) {
+            // Wildcards that the shell did not expand (e.g. quoted ones)
+            matches = input_info.dir().entryInfoList(
+                QStringList() << input_info.fileName(), QDir::Files,
+                QDir::Name);
+        } else {
+            files << input;
+            continue;
+        }
+        for (const QFileInfo &match : matches) {
+            files << match.filePath();
+        }
+    }
+    return files;
+}
+
+bool CommandLine::addTasks(const QString &file_name, const AnalysisTask &task,
+                           BundleList &bundles,
+                           std::vector<AnalysisTask> &tasks) {
+    if (!file_name.endsWith(".mssz", Qt::CaseInsensitive)) {
+        tasks.push_back(task);
+        tasks.back().file_name = file_name;
+        return true;
+    }
+    std::unique_ptr<ScoresheetBundle> bundle(new ScoresheetBundle);
+    if (!bundle->open(file_name)) {
+        std::cerr << file_name.toStdString() << ": Error when opening bundle ("
+                  << bundle->errorString().toStdString() << ")" << std::endl;
+        return false;
+    }
+    // The files are read in the order of the bundle, so that each block is
+    // decompressed once
+    for (int file = 0; file < bundle->fileCount(); file++) {
+        tasks.push_back(task);
+        tasks.back().file_name = file_name + "/" + bundle->fileName(file);
+        tasks.back().bundle = bundle.get();
+        tasks.back().bundle_file = file;
+    }
+    bundles.push_back(std::move(bundle));
+    return true;
+}
+
+bool CommandLine::addGameTasks(const QString &file_name,
+                               const QString &game_name,
+                               const AnalysisTask &task, BundleList &bundles,
+                               ArchiveList &archives,
+                               std::vector<AnalysisTask> &tasks) {
+    if (!file_name.endsWith(".mssa", Qt::CaseInsensitive)) {
+        return addTasks(file_name, task, bundles, tasks);
+    }
+    std::unique_ptr<GameArchive> archive(new GameArchive);
+    if (!archive->open(file_name)) {
+        std::cerr << file_name.toStdString() << ": Error when opening archive ("
+                  << archive->errorString().toStdString() << ")" << std::endl;
+        return false;
+    }
+    // The games are looked up once, the tasks read them by number
+    int first_game = 0;
+    int last_game = archive->gameCount();
+    if (!game_name.isEmpty()) {
+        first_game = archive->findGame(game_name);
+        if (first_game < 0) {
+            std::cerr << file_name.toStdString() << " ("
+                      << game_name.toStdString()
+                      << "): No such game in archive" << std::endl;
+            return false;
+        }
+        last_game = first_game + 1;
+    }
+    for (int game = first_game; game < last_game; game++) {
+        tasks.push_back(task);
+        tasks.back().file_name = file_name;
+        tasks.back().game_name = archive->gameName(game);
+        tasks.back().archive = archive.get();
+        tasks.back().archive_game = game;
+    }
+    archives.push_back(std::move(archive));
+    return true;
+}
+
+CommandLine::LoadStatus CommandLine::loadScoresheet(
+    const AnalysisTask &task, const QByteArray &result_kind,
+    ScoresheetData &data, QByteArray &cache_key, QByteArray &cached_result,
+    QString *error_message) {
+    if (task.archive != nullptr) {
+        // Load a game of an archive, read in place (not cached)
+        if (!task.archive->readGame(task.archive_game, data)) {
+            *error_message = "Error when reading game (" +
+                             task.archive->game(task.archive_game)
+                                 .errorString() +
+                             ")";
+            return LoadStatus::FAILED;
+        }
+        return LoadStatus::LOADED;
+    }
+
+    if (task.bundle != nullptr && task.cache == nullptr) {
+        // Parsed in place from the decompressed block, as no content is
+        // needed for a cache key
+        QString bundle_error;
+        if (!task.bundle->readFile(task.bundle_file, data, &bundle_error)) {
+            *error_message =
+                "Error when reading bundle file (" + bundle_error + ")";
+            return LoadStatus::FAILED;
+        }
+        return LoadStatus::LOADED;
+    }
+
+    QByteArray content;
+    if (task.bundle != nullptr) {
+        // Copied out of the decompressed block, to be hashed
+        QString bundle_error;
+        if (!task.bundle->readContent(task.bundle_file, content,
+                                      &bundle_error)) {
+            *error_message = "Error when reading bundle (" + bundle_error + ")";
+            return LoadStatus::FAILED;
+        }
+    } else {
+        QFile file(task.file_name);
+        if (!file.open(QIODevice::ReadOnly)) {
+            *error_message = "Error when opening scoresheet file (" +
+                             file.errorString() + ")";
+            return LoadStatus::FAILED;
+        }
+        content = file.readAll();
+    }
+    if (task.cache != nullptr) {
+        cache_key = ResultCache::key(result_kind, content);
+        if (task.cache->find(cache_key, cached_result)) {
+            return LoadStatus::CACHED;
+        }
+    }
+    QString parse_error;
+    if (!ScoresheetData::read(content.constData(),
+                              content.constData() + content.size(), data,
+                              &parse_error)) {
+        *error_message =
+            "Error when parsing scoresheet file (" + parse_error + ")";
+        return LoadStatus::FAILED;
+    }
+    return LoadStatus::LOADED;
+}
+
+CommandLine::AnalysisResult
+CommandLine::analyzeTask(const AnalysisTask &task) {
+    AnalysisResult result;
+    // The games of an archive are named like the files of the bundles
+    result.file_name = task.game_name.isEmpty()
+                           ? task.file_name
+                           : task.file_name + "/" + task.game_name;
+    // The output depends on the format and, in most formats, on the file
+    // name
+    const QByteArray result_kind =
+        "analysis " + QByteArray::number(static_cast<int>(task.format)) + " " +
+        QByteArray::number(task.named ? 1 : 0) + " " +
+        result.file_name.toUtf8();
+    ScoresheetData data;
+    const LoadStatus status =
+        loadScoresheet(task, result_kind, data, result.cache_key,
+                       result.output, &result.error_message);
+    if (status == LoadStatus::FAILED) {
+        return result;
+    }
+    if (status == LoadStatus::CACHED) {
+        result.cached = true;
+    } else {
+        result.output = AnalysisWriter::encode(task.format, result.file_name,
+                                               data, task.named);
+    }
+    result.ok = true;
+    return result;
+}
+
+CommandLine::SummaryResult
+CommandLine::summarizeTask(const AnalysisTask &task) {
+    SummaryResult result;
+    result.file_name = task.file_name;
+    ScoresheetData data;
+    LoadStatus status =
+        loadScoresheet(task, "summary", data, result.cache_key,
+                       result.encoded_session, &result.error_message);
+    if (status == LoadStatus::CACHED &&
+        !SeasonStats::decodeSession(result.encoded_session, result.session)) {
+        // Unreadable cached summary: summarize the scoresheet again, the
+        // cache entry is replaced
+        AnalysisTask uncached_task = task;
+        uncached_task.cache = nullptr;
+        QByteArray unused;
+        status = loadScoresheet(uncached_task, "summary", data, unused, unused,
+                                &result.error_message);
+    }
+    if (status == LoadStatus::FAILED) {
+        return result;
+    }
+    if (status == LoadStatus::CACHED) {
+        result.cached = true;
+    } else {
+        result.session = SeasonStats::summarize(data);
+        result.encoded_session = SeasonStats::encodeSession(result.session);
+    }
+    result.ok = true;
+    return result;
+}
+
+CommandLine::AuditResult CommandLine::auditTask(const AnalysisTask &task) {
+    AuditResult result;
+    result.file_name = task.file_name;
+    result.game_name = task.game_name;
+    ScoresheetData data;
+    QByteArray unused;
+    if (loadScoresheet(task, "audit", data, unused, unused,
+                       &result.error_message) == LoadStatus::FAILED) {
+        return result;
+    }
+    result.discrepancies = ScoresheetAudit::check(data);
+    result.ok = true;
+    return result;
+}
+
+#ifdef WITH_CORPUS_STORE
+CommandLine::LoadResult CommandLine::loadTask(const AnalysisTask &task) {
+    LoadResult result;
+    result.file_name = task.file_name;
+    result.game_name = task.game_name;
+    QByteArray unused;
+    if (loadScoresheet(task, "store", result.data, unused, unused,
+                       &result.error_message) == LoadStatus::FAILED) {
+        return result;
+    }
+    result.ok = true;
+    return result;
+}
+#endif
+
+bool CommandLine::loadCache(const QString &cache_file, ResultCache &cache) {
+    if (cache_file.isEmpty()) {
+        return false;
+    }
+    QString error_message;
+    if (!cache.load(cache_file, &error_message)) {
+        std::cerr << "Ignoring the cache " << cache_file.toStdString() << " ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void CommandLine::saveCache(const QString &cache_file, ResultCache &cache) {
+    QString error_message;
+    if (!cache.save(&error_message)) {
+        std::cerr << "Error when saving the cache " << cache_file.toStdString()
+                  << " (" << error_message.toStdString() << ")" << std::endl;
+    }
+}
+
+bool CommandLine::loadRegistry(const QString &registry_file,
+                               PlayerRegistry &registry) {
+    if (registry_file.isEmpty()) {
+        return false;
+    }
+    QString error_message;
+    if (!registry.load(registry_file, &error_message)) {
+        std::cerr << "Ignoring the player registry "
+                  << registry_file.toStdString() << " ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void CommandLine::saveRegistry(const QString &registry_file,
+                               PlayerRegistry &registry) {
+    QString error_message;
+    if (!registry.save(&error_message)) {
+        std::cerr << "Error when saving the player registry "
+                  << registry_file.toStdString() << " ("
+                  << error_message.toStdString() << ")" << std::endl;
+    }
+}
+
+int CommandLine::analyze(const QStringList &inputs, const QString &game_name,
+                         AnalysisWriter::Format format,
+                         const QString &cache_file) const {
+    ResultCache cache;
+    const bool use_cache = loadCache(cache_file, cache);
+    std::vector<AnalysisTask> tasks;
+    BundleList bundles;
+    ArchiveList archives;
+    int exit_code = 0;
+    // Every game of an archive is analyzed, unless a game is selected
+    for (const QString &file_name : expandAnalysisInputs(inputs)) {
+        if (!addGameTasks(file_name, game_name,
+                          AnalysisTask{QString(), QString(), format, false,
+                                       use_cache ? &cache : nullptr},
+                          bundles, archives, tasks)) {
+            exit_code = -1;
+        }
+    }
+    // Several text analyses are separated by the name of their scoresheet
+    for (AnalysisTask &task : tasks) {
+        task.named = tasks.size() > 1;
+    }
+
+    // The scoresheets are analyzed on the thread pool, the results are
+    // written in the order of the inputs as soon as they are available
+    const QFuture<AnalysisResult> results =
+        QtConcurrent::mapped(tasks, &CommandLine::analyzeTask);
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+    AnalysisWriter writer(format, out);
+    for (int i = 0; i < static_cast<int>(tasks.size()); i++) {
+        const AnalysisResult result = results.resultAt(i);
+        if (!result.ok) {
+            std::cerr << result.file_name.toStdString() << ": "
+                      << result.error_message.toStdString() << std::endl;
+            exit_code = -1;
+            continue;
+        }
+        writer.write(result.output);
+    }
+    if (use_cache) {
+        // The cache is only updated once the workers are done reading it
+        for (int i = 0; i < static_cast<int>(tasks.size()); i++) {
+            const AnalysisResult result = results.resultAt(i);
+            if (result.cached) {
+                cache.use(result.cache_key);
+            } else if (result.ok && !result.cache_key.isEmpty()) {
+                cache.insert(result.cache_key, result.output);
+            }
+        }
+        saveCache(cache_file, cache);
+    }
+    if (!writer.flush()) {
+        std::cerr << "Error when writing the analysis ("
+                  << out.errorString().toStdString() << ")" << std::endl;
+        return -1;
+    }
+    return exit_code;
+}
+
+int CommandLine::stats(const QStringList &inputs, const QString &game_name,
+                       AnalysisWriter::Format format,
+                       const QString &cache_file,
+                       const QString &registry_file,
+                       RollingStats::Unit rolling_unit,
+                       int rolling_size) const {
+    ResultCache cache;
+    const bool use_cache = loadCache(cache_file, cache);
+    PlayerRegistry registry;
+    const bool use_registry = loadRegistry(registry_file, registry);
+    std::vector<AnalysisTask> tasks;
+    BundleList bundles;
+    ArchiveList archives;
+    int exit_code = 0;
+    for (const QString &file_name : expandAnalysisInputs(inputs)) {
+        if (!addGameTasks(file_name, game_name,
+                          AnalysisTask{QString(), QString(),
+                                       AnalysisWriter::Format::TEXT, false,
+                                       use_cache ? &cache : nullptr},
+                          bundles, archives, tasks)) {
+            exit_code = -1;
+        }
+    }
+
+    // The scoresheets are summarized on the thread pool, the sessions are
+    // added in the order of the inputs
+    const QFuture<SummaryResult> results =
+        QtConcurrent::mapped(tasks, &CommandLine::summarizeTask);
+    SeasonStats season_stats(use_registry ? &registry : nullptr);
+    // The trend is written as the sessions are added
+    const bool json = format == AnalysisWriter::Format::JSONL;
+    RollingStats rolling_stats(rolling_unit, rolling_size,
+                               use_registry ? &registry : nullptr);
+    QByteArray trend;
+    if (rolling_size > 0 && !json) {
+        RollingStats::writeTextHeader(trend);
+    }
+    for (int i = 0; i < static_cast<int>(tasks.size()); i++) {
+        const SummaryResult result = results.resultAt(i);
+        if (!result.ok) {
+            std::cerr << result.file_name.toStdString() << ": "
+                      << result.error_message.toStdString() << std::endl;
+            exit_code = -1;
+            continue;
+        }
+        season_stats.addSession(result.session);
+        if (rolling_size > 0) {
+            rolling_stats.addSession(result.session);
+            rolling_stats.writeLastSession(json, trend);
+        }
+    }
+    if (use_cache) {
+        // The cache is only updated once the workers are done reading it
+        for (int i = 0; i < static_cast<int>(tasks.size()); i++) {
+            const SummaryResult result = results.resultAt(i);
+            if (result.cached) {
+                cache.use(result.cache_key);
+            } else if (result.ok && !result.cache_key.isEmpty()) {
+                cache.insert(result.cache_key, result.encoded_session);
+            }
+        }
+        saveCache(cache_file, cache);
+    }
+    if (use_registry) {
+        saveRegistry(registry_file, registry);
+    }
+    if (season_stats.sessionCount() == 0) {
+        std::cerr << "No scoresheet to summarize" << std::endl;
+        return -1;
+    }
+
+    if (rolling_size > 0) {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+        out.write(trend);
+        return exit_code;
+    }
+    if (json) {
+        QByteArray json_stats;
+        season_stats.writeJson(json_stats);
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+        out.write(json_stats);
+        return exit_code;
+    }
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+    season_stats.writeReport(out);
+    return exit_code;
+}
+
+int CommandLine::watch(const QString &directory,
+                       AnalysisWriter::Format format,
+                       const QString &registry_file) const {
+    // The new players are not registered while watching
+    PlayerRegistry registry;
+    const bool use_registry = loadRegistry(registry_file, registry);
+    SeasonWatcher watcher(directory, format,
+                          use_registry ? &registry : nullptr);
+    QString error_message;
+    if (!watcher.start(&error_message)) {
+        std::cerr << error_message.toStdString() << std::endl;
+        return -1;
+    }
+    // Runs until interrupted
+    return QCoreApplication::exec();
+}
+
+int CommandLine::audit(const QStringList &inputs, const QString &game_name,
+                       AnalysisWriter::Format format) const {
+    // Every game of an archive is audited, unless a game is selected
+    std::vector<AnalysisTask> tasks;
+    BundleList bundles;
+    ArchiveList archives;
+    int exit_code = 0;
+    for (const QString &file_name : expandAnalysisInputs(inputs)) {
+        if (!addGameTasks(file_name, game_name,
+                          AnalysisTask{QString(), QString(), format, false,
+                                       nullptr},
+                          bundles, archives, tasks)) {
+            exit_code = -1;
+        }
+    }
+
+    // The scoresheets are audited on the thread pool, the discrepancies are
+    // written in the order of the inputs
+    const QFuture<AuditResult> results =
+        QtConcurrent::mapped(tasks, &CommandLine::auditTask);
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+    const bool json = format == AnalysisWriter::Format::JSONL;
+    int n_discrepancies = 0;
+    int n_inconsistent = 0;
+    for (int i = 0; i < static_cast<int>(tasks.size()); i++) {
+        const AuditResult result = results.resultAt(i);
+        if (!result.ok) {
+            std::cerr << result.file_name.toStdString();
+            if (!result.game_name.isEmpty()) {
+                std::cerr << " (" << result.game_name.toStdString() << ")";
+            }
+            std::cerr << ": " << result.error_message.toStdString()
+                      << std::endl;
+            exit_code = -1;
+            continue;
+        }
+        if (result.discrepancies.empty()) {
+            continue;
+        }
+        QByteArray report;
+        ScoresheetAudit::encode(json, result.file_name, result.game_name,
+                                result.discrepancies, report);
+        out.write(report);
+        n_discrepancies += result.discrepancies.size();
+        n_inconsistent++;
+    }
+    if (!json) {
+        out.write(QString("%1 discrepancies in %2 of %3 scoresheets\n")
+                      .arg(n_discrepancies)
+                      .arg(n_inconsistent)
+                      .arg(static_cast<int>(tasks.size()))
+                      .toUtf8());
+    }
+    // Like a linter, the audit fails when it finds discrepancies
+    if (exit_code == 0 && n_discrepancies > 0) {
+        exit_code = 1;
+    }
+    return exit_code;
+}
+
+int CommandLine::bundleCreate(const QString &bundle_file,
+                              const QStringList &inputs) const {
+    QString error_message;
+    if (!ScoresheetBundle::create(bundle_file, expandAnalysisInputs(inputs),
+                                  &error_message)) {
+        std::cerr << "Error when creating bundle ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int CommandLine::bundleList(const QString &bundle_file) const {
+    ScoresheetBundle bundle;
+    if (!bundle.open(bundle_file)) {
+        std::cerr << "Error when opening bundle ("
+                  << bundle.errorString().toStdString() << ")" << std::endl;
+        return -1;
+    }
+    QTextStream out(stdout);
+    for (int file = 0; file < bundle.fileCount(); file++) {
+        out << bundle.fileName(file) << "\t" << bundle.fileSize(file) << "\t"
+            << bundle.fileBlock(file) << "\n";
+    }
+    return 0;
+}
+
+#ifdef WITH_CORPUS_STORE
+int CommandLine::storeIngest(const QString &store_file,
+                             const QStringList &inputs,
+                             const QString &game_name,
+                             const QString &registry_file) const {
+    PlayerRegistry registry;
+    const bool use_registry = loadRegistry(registry_file, registry);
+    CorpusStore store;
+    QString error_message;
+    if (!store.open(store_file, false, &error_message)) {
+        std::cerr << "Error when opening corpus store ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return -1;
+    }
+    // Every game of an archive is stored, unless a game is selected. The
+    // files and the bundles are dated by their file, the games of an
+    // archive by the archive.
+    std::vector<AnalysisTask> tasks;
+    std::vector<QDateTime> dates;
+    BundleList bundles;
+    ArchiveList archives;
+    int exit_code = 0;
+    for (const QString &file_name : expandAnalysisInputs(inputs)) {
+        if (!addGameTasks(file_name, game_name,
+                          AnalysisTask{QString(), QString(),
+                                       AnalysisWriter::Format::TEXT, false,
+                                       nullptr},
+                          bundles, archives, tasks)) {
+            exit_code = -1;
+            continue;
+        }
+        const QDateTime file_date = QFileInfo(file_name).lastModified();
+        while (dates.size() < tasks.size()) {
+            const AnalysisTask &task = tasks[dates.size()];
+            dates.push_back(task.archive != nullptr
+                                ? task.archive->gameDate(task.archive_game)
+                                : file_date);
+        }
+    }
+
+    // The scoresheets are loaded on the thread pool, the games are added in
+    // the order of the inputs
+    QFuture<LoadResult> results =
+        QtConcurrent::mapped(tasks, &CommandLine::loadTask);
+    for (int i = 0; i < static_cast<int>(tasks.size()); i++) {
+        LoadResult result = results.resultAt(i);
+        if (!result.ok) {
+            std::cerr << result.file_name.toStdString();
+            if (!result.game_name.isEmpty()) {
+                std::cerr << " (" << result.game_name.toStdString() << ")";
+            }
+            std::cerr << ": " << result.error_message.toStdString()
+                      << std::endl;
+            exit_code = -1;
+            continue;
+        }
+        // The players are stored by their registered name
+        for (int seat = 0; use_registry && seat < result.data.n_players;
+             seat++) {
+            QString &player_name = result.data.player_names[seat];
+            player_name = registry.name(registry.id(player_name));
+        }
+        // Named like the files of the bundles
+        const QString name =
+            result.game_name.isEmpty()
+                ? result.file_name
+                : result.file_name + "/" + result.game_name;
+        // A game that fails is rolled back alone, the others are stored
+        if (!store.addGame(name, dates[i], result.data, &error_message)) {
+            std::cerr << "Error when storing " << name.toStdString() << " ("
+                      << error_message.toStdString() << ")" << std::endl;
+            exit_code = -1;
+        }
+    }
+    if (!store.commit(&error_message)) {
+        std::cerr << "Error when committing corpus store ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return -1;
+    }
+    if (use_registry) {
+        saveRegistry(registry_file, registry);
+    }
+    return exit_code;
+}
+
+int CommandLine::storeQuery(const QString &store_file,
+                            const QStringList &arguments) const {
+    if (arguments.size() != 1) {
+        std::cerr << "The query requires exactly one SQL statement"
+                  << std::endl;
+        return -1;
+    }
+    CorpusStore store;
+    QString error_message;
+    if (!store.open(store_file, true, &error_message)) {
+        std::cerr << "Error when opening corpus store ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return -1;
+    }
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+    if (!store.query(arguments[0], out, &error_message)) {
+        out.flush();
+        std::cerr << "Error when running query ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+int CommandLine::convert(const QString &input_file,
+                         const QString &output_file) const {
+    QFile input(input_file);
+    if (!input.open(QIODevice::ReadOnly)) {
+        std::cerr << "Error when opening scoresheet file" << std::endl;
+        return -1;
+    }
+    ScoresheetData data;
+    QString error_message;
+    if (!ScoresheetData::readFile(input, data, &error_message)) {
+        std::cerr << "Error when parsing scoresheet file ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return -1;
+    }
+    QFile output(output_file);
+    if (!output.open(QIODevice::WriteOnly) ||
+        !data.writeFile(output, &error_message)) {
+        std::cerr << "Error when writing scoresheet file ("
+                  << (output.isOpen() ? error_message : output.errorString())
+                         .toStdString()
+                  << ")" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int CommandLine::archiveAppend(const QString &archive_file,
+                               const QStringList &input_files) const {
+    for (const QString &input_file : input_files) {
+        QFile input(input_file);
+        ScoresheetData data;
+        QString error_message;
+        if (!input.open(QIODevice::ReadOnly) ||
+            !ScoresheetData::readFile(input, data, &error_message) ||
+            !GameArchive::appendGame(archive_file,
+                                     QFileInfo(input_file).completeBaseName(),
+                                     QFileInfo(input_file).lastModified(), data,
+                                     &error_message)) {
+            std::cerr << "Error when archiving " << input_file.toStdString()
+                      << " ("
+                      << (input.isOpen() ? error_message : input.errorString())
+                             .toStdString()
+                      << ")" << std::endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int CommandLine::archiveList(const QString &archive_file,
+                             const QString &registry_file) const {
+    GameArchive archive;
+    if (!archive.open(archive_file)) {
+        std::cerr << "Error when opening archive ("
+                  << archive.errorString().toStdString() << ")" << std::endl;
+        return -1;
+    }
+    // The registered players are listed by their registered name
+    PlayerRegistry registry;
+    loadRegistry(registry_file, registry);
+    QTextStream out(stdout);
+    for (int game = 0; game < archive.gameCount(); game++) {
+        out << archive.gameName(game) << "\t"
+            << archive.gameDate(game).toString(Qt::ISODate) << "\t"
+            << archive.gameTurnCount(game);
+        for (int i = 0; i < archive.gamePlayerCount(game); i++) {
+            const int id = archive.gamePlayerId(game, i, registry);
+            out << "\t"
+                << (id >= 0 ? registry.name(id)
+                            : archive.gamePlayerName(game, i));
+        }
+        out << "\n";
+    }
+    return 0;
+}
+
+int CommandLine::archiveCompact(const QString &archive_file) const {
+    QString error_message;
+    if (!GameArchive::compact(archive_file, &error_message)) {
+        std::cerr << "Error when compacting archive ("
+                  << error_message.toStdString() << ")" << std::endl;
+        return -1;
+    }
+    return 0;
+}
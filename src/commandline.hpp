@@ -0,0 +1,241 @@
+#pragma once
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QString>
+#include <memory>
+#include <vector>
+
+#include "analysiswriter.hpp"
+#include "gamearchive.hpp"
+#include "playerregistry.hpp"
+#ifdef WITH_CORPUS_STORE
+#include "corpusstore.hpp"
+#endif
+#include "resultcache.hpp"
+#include "rollingstats.hpp"
+#include "scoresheetaudit.hpp"
+#include "scoresheetbundle.hpp"
+#include "scoresheetdata.hpp"
+#include "seasonstats.hpp"
+
+/**
+ * @brief Command line tools (analysis, statistics, audit, conversion,
+ * archives, bundles)
+ *
+ * They only depend on QtCore, so that they are shared by the GUI executable
+ * and the headless one. The corpus store options are only built into the
+ * headless one, when configured with WITH_CORPUS_STORE (they need QtSql).
+ */
+class CommandLine {
+    Q_DECLARE_TR_FUNCTIONS(CommandLine)
+
+  public:
+    CommandLine();
+
+    /**
+     * @brief Register the options of the tools and the positional files
+     */
+    void addOptions(QCommandLineParser &parser) const;
+    /**
+     * @brief Run the tool selected on the command line, if any
+     *
+     * @param exit_code receives the exit status of the tool
+     * @return false if no tool was selected
+     */
+    bool run(const QCommandLineParser &parser, int &exit_code) const;
+
+  private:
+    /**
+     * @brief Scoresheet to analyze: a file, a game of an archive or a file of
+     * a bundle
+     */
+    struct AnalysisTask {
+        QString file_name; /**< <bundle>/<file> for a file of a bundle */
+        QString game_name;
+        AnalysisWriter::Format format;
+        bool named; /**< Whether the text analysis starts with the file */
+        const ResultCache *cache; /**< Cached results, may be null */
+        const ScoresheetBundle *bundle = nullptr; /**< Bundle of the file */
+        int bundle_file = -1; /**< Number of the file in the bundle */
+        const GameArchive *archive = nullptr; /**< Archive of the game */
+        int archive_game = -1; /**< Number of the game in the archive */
+    };
+    using BundleList = std::vector<std::unique_ptr<ScoresheetBundle>>;
+    using ArchiveList = std::vector<std::unique_ptr<GameArchive>>;
+    /**
+     * @brief Analysis of a scoresheet, or the reason it failed
+     */
+    struct AnalysisResult {
+        QString file_name;
+        bool ok = false;
+        QString error_message;
+        QByteArray output;
+        QByteArray cache_key; /**< Key of the output, if it can be cached */
+        bool cached = false;  /**< Whether the output comes from the cache */
+    };
+    /**
+     * @brief Summary of a scoresheet for the statistics, or the reason it
+     * failed
+     */
+    struct SummaryResult {
+        QString file_name;
+        bool ok = false;
+        QString error_message;
+        SeasonStats::Session session;
+        QByteArray cache_key; /**< Key of the summary, if it can be cached */
+        QByteArray encoded_session; /**< Serialized summary, to be cached */
+        bool cached = false; /**< Whether the summary comes from the cache */
+    };
+    /**
+     * @brief Discrepancies of a scoresheet, or the reason it failed
+     */
+    struct AuditResult {
+        QString file_name;
+        QString game_name; /**< Game of an archive, empty for a file */
+        bool ok = false;
+        QString error_message;
+        std::vector<ScoresheetAudit::Discrepancy> discrepancies;
+    };
+#ifdef WITH_CORPUS_STORE
+    /**
+     * @brief Scoresheet to store, or the reason it failed
+     */
+    struct LoadResult {
+        QString file_name;
+        QString game_name; /**< Game of an archive, empty for a file */
+        bool ok = false;
+        QString error_message;
+        ScoresheetData data;
+    };
+#endif
+
+    /**
+     * @brief Replace the directories by the scoresheets they contain and the
+     * wildcard patterns by the files they match, sorted by name
+     */
+    static QStringList expandAnalysisInputs(const QStringList &inputs);
+    /**
+     * @brief Add the task of an input file, or one task per scoresheet of a
+     * bundle (.mssz), based on the given task
+     *
+     * @param bundles keeps the opened bundles, read by the tasks
+     * @return false if the bundle can't be opened (reported on the error
+     * output)
+     */
+    static bool addTasks(const QString &file_name, const AnalysisTask &task,
+                         BundleList &bundles, std::vector<AnalysisTask> &tasks);
+    /**
+     * @brief Like addTasks(), with one task per game of an archive (.mssa),
+     * unless a game is selected
+     *
+     * @param archives keeps the opened archives, read by the tasks
+     * @return false if the archive or the bundle can't be opened, or the
+     * selected game is not in the archive (reported on the error output)
+     */
+    static bool addGameTasks(const QString &file_name, const QString &game_name,
+                             const AnalysisTask &task, BundleList &bundles,
+                             ArchiveList &archives,
+                             std::vector<AnalysisTask> &tasks);
+    enum class LoadStatus { LOADED, CACHED, FAILED };
+    /**
+     * @brief Load the scoresheet of a task (a file or a game of an archive),
+     * unless the result of the given kind is cached for its content
+     *
+     * @param cache_key receives the key of the result if it can be cached
+     * @param cached_result receives the cached result, if any
+     */
+    static LoadStatus loadScoresheet(const AnalysisTask &task,
+                                     const QByteArray &result_kind,
+                                     ScoresheetData &data,
+                                     QByteArray &cache_key,
+                                     QByteArray &cached_result,
+                                     QString *error_message);
+    /**
+     * @brief Load and analyze a scoresheet, run on the thread pool
+     */
+    static AnalysisResult analyzeTask(const AnalysisTask &task);
+    /**
+     * @brief Load and summarize a scoresheet, run on the thread pool
+     */
+    static SummaryResult summarizeTask(const AnalysisTask &task);
+    /**
+     * @brief Load and audit a scoresheet, run on the thread pool
+     */
+    static AuditResult auditTask(const AnalysisTask &task);
+#ifdef WITH_CORPUS_STORE
+    /**
+     * @brief Load a scoresheet to store, run on the thread pool
+     */
+    static LoadResult loadTask(const AnalysisTask &task);
+#endif
+
+    /* Tools, returning the exit status */
+    int analyze(const QStringList &inputs, const QString &game_name,
+                AnalysisWriter::Format format, const QString &cache_file) const;
+    /**
+     * @param rolling_size size of the windows of the trend to print instead
+     * of the statistics, 0 for the statistics
+     */
+    int stats(const QStringList &inputs, const QString &game_name,
+              AnalysisWriter::Format format, const QString &cache_file,
+              const QString &registry_file, RollingStats::Unit rolling_unit,
+              int rolling_size) const;
+    int watch(const QString &directory, AnalysisWriter::Format format,
+              const QString &registry_file) const;
+    int audit(const QStringList &inputs, const QString &game_name,
+              AnalysisWriter::Format format) const;
+    /**
+     * @brief Load the result cache, if a cache file is given
+     *
+     * @return false if the cache is not usable
+     */
+    static bool loadCache(const QString &cache_file, ResultCache &cache);
+    static void saveCache(const QString &cache_file, ResultCache &cache);
+    /**
+     * @brief Load the player registry, if a registry file is given
+     *
+     * @return false if the registry is not usable
+     */
+    static bool loadRegistry(const QString &registry_file,
+                             PlayerRegistry &registry);
+    static void saveRegistry(const QString &registry_file,
+                             PlayerRegistry &registry);
+    int convert(const QString &input_file, const QString &output_file) const;
+    int archiveAppend(const QString &archive_file,
+                      const QStringList &input_files) const;
+    int archiveList(const QString &archive_file,
+                    const QString &registry_file) const;
+    int archiveCompact(const QString &archive_file) const;
+    int bundleCreate(const QString &bundle_file,
+                     const QStringList &inputs) const;
+    int bundleList(const QString &bundle_file) const;
+#ifdef WITH_CORPUS_STORE
+    int storeIngest(const QString &store_file, const QStringList &inputs,
+                    const QString &game_name,
+                    const QString &registry_file) const;
+    int storeQuery(const QString &store_file,
+                   const QStringList &arguments) const;
+#endif
+
+    QCommandLineOption analyze_option_;
+    QCommandLineOption convert_option_;
+    QCommandLineOption archive_append_option_;
+    QCommandLineOption archive_list_option_;
+    QCommandLineOption archive_compact_option_;
+    QCommandLineOption game_option_;
+    QCommandLineOption format_option_;
+    QCommandLineOption stats_option_;
+    QCommandLineOption rolling_option_;
+    QCommandLineOption rolling_turns_option_;
+    QCommandLineOption cache_option_;
+    QCommandLineOption players_option_;
+    QCommandLineOption watch_option_;
+    QCommandLineOption audit_option_;
+    QCommandLineOption bundle_create_option_;
+    QCommandLineOption bundle_list_option_;
+#ifdef WITH_CORPUS_STORE
+    QCommandLineOption store_ingest_option_;
+    QCommandLineOption store_query_option_;
+#endif
+};
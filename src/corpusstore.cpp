@@ -0,0 +1,531 @@
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QVariant>
+#include <vector>
+
+#include "corpusstore.hpp"
+#include "handdictionary.hpp"
+
+static const int SCHEMA_VERSION = 2;
+
+static const char *const OUTCOME_NAMES[4] = {"tsumo", "ron", "manual", "draw"};
+
+/**
+ * @brief Names of the yakus in the store, in the order of Yaku
+ */
+static const char *const YAKU_NAMES[] = {"pinfu",
+                                         "riichi",
+                                         "ippatsu",
+                                         "fully_concealed_hand",
+                                         "thirteen_orphans",
+                                         "seven_pairs",
+                                         "dragon_pon",
+                                         "prevailing_wind_pon",
+                                         "player_wind_pon",
+                                         "all_pon",
+                                         "three_concealed_pon",
+                                         "three_kan",
+                                         "four_kan",
+                                         "big_three_dragons",
+                                         "little_three_dragons",
+                                         "big_four_winds",
+                                         "little_four_winds",
+                                         "double_chii",
+                                         "twice_double_chii",
+                                         "three_suit_chii",
+                                         "pure_straight",
+                                         "all_simple",
+                                         "seven_honors_pairs",
+                                         "all_honors_hand",
+                                         "all_terminals_hand",
+                                         "pure_outside_hand",
+                                         "all_terminals_and_honors_hand",
+                                         "mixed_outside_hand",
+                                         "nine_gates",
+                                         "full_flush_hand",
+                                         "half_flush_hand",
+                                         "doras"};
+static const int N_YAKUS = sizeof(YAKU_NAMES) / sizeof(YAKU_NAMES[0]);
+static_assert(N_YAKUS == static_cast<int>(Yaku::DORAS) + 1,
+              "Every yaku must be named");
+
+static const char *const SCHEMA[] = {
+    "CREATE TABLE players (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)",
+    "CREATE TABLE games (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE, "
+    "date TEXT NOT NULL, n_players INTEGER NOT NULL, "
+    "beginning_score INTEGER NOT NULL)",
+    "CREATE INDEX games_date ON games (date)",
+    "CREATE TABLE game_players (game INTEGER NOT NULL REFERENCES games (id) "
+    "ON DELETE CASCADE, seat INTEGER NOT NULL, "
+    "player INTEGER NOT NULL REFERENCES players (id), "
+    "PRIMARY KEY (game, seat))",
+    "CREATE INDEX game_players_player ON game_players (player)",
+    "CREATE TABLE yakus (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE, "
+    "yakuman INTEGER NOT NULL)",
+    "CREATE TABLE hands (id INTEGER PRIMARY KEY, description TEXT NOT NULL, "
+    "riichi INTEGER NOT NULL, ron INTEGER NOT NULL, valid INTEGER NOT NULL, "
+    "fu INTEGER NOT NULL, fan INTEGER NOT NULL, "
+    "UNIQUE (description, riichi, ron))",
+    "CREATE TABLE hand_yakus (hand INTEGER NOT NULL REFERENCES hands (id), "
+    "yaku INTEGER NOT NULL REFERENCES yakus (id), PRIMARY KEY (hand, yaku))",
+    "CREATE INDEX hand_yakus_yaku ON hand_yakus (yaku, hand)",
+    "CREATE TABLE turns (game INTEGER NOT NULL REFERENCES games (id) "
+    "ON DELETE CASCADE, turn INTEGER NOT NULL, outcome TEXT NOT NULL, "
+    "east INTEGER NOT NULL REFERENCES players (id), "
+    "winner INTEGER REFERENCES players (id), "
+    "loser INTEGER REFERENCES players (id), fu INTEGER, fan INTEGER, "
+    "hand INTEGER REFERENCES hands (id), PRIMARY KEY (game, turn))",
+    "CREATE INDEX turns_outcome ON turns (outcome)",
+    "CREATE INDEX turns_winner ON turns (winner)",
+    "CREATE INDEX turns_loser ON turns (loser)",
+    "CREATE INDEX turns_hand ON turns (hand)",
+    "CREATE TABLE score_changes (game INTEGER NOT NULL REFERENCES games (id) "
+    "ON DELETE CASCADE, turn INTEGER NOT NULL, seat INTEGER NOT NULL, "
+    "player INTEGER NOT NULL REFERENCES players (id), "
+    "score_change INTEGER NOT NULL, PRIMARY KEY (game, turn, seat))",
+    "CREATE INDEX score_changes_player ON score_changes (player)"};
+
+/**
+ * @brief Whether a yaku is a yakuman
+ */
+static bool isYakuman(Yaku yaku) {
+    switch (yaku) {
+    case Yaku::THIRTEEN_ORPHANS:
+    case Yaku::FOUR_KAN:
+    case Yaku::BIG_THREE_DRAGONS:
+    case Yaku::BIG_FOUR_WINDS:
+    case Yaku::LITTLE_FOUR_WINDS:
+    case Yaku::SEVEN_HONORS_PAIRS:
+    case Yaku::ALL_HONORS_HAND:
+    case Yaku::ALL_TERMINALS_HAND:
+    case Yaku::NINE_GATES:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Report an error, returning false
+ */
+static bool failed(QString *error_message, const QString &message) {
+    if (error_message != nullptr) {
+        *error_message = message;
+    }
+    return false;
+}
+
+/**
+ * @brief Insertions, prepared once per opened store
+ */
+struct CorpusStore::Statements {
+    explicit Statements(const QSqlDatabase &database)
+        : insert_player(database), insert_hand(database),
+          insert_hand_yaku(database), delete_game(database),
+          insert_game(database), insert_game_player(database),
+          insert_turn(database), insert_score_change(database) {}
+
+    bool prepare(QString *error_message) {
+        const std::pair<QSqlQuery *, const char *> statements[] = {
+            {&insert_player, "INSERT INTO players (name) VALUES (?)"},
+            {&insert_hand, "INSERT INTO hands (description, riichi, ron, "
+                           "valid, fu, fan) VALUES (?, ?, ?, ?, ?, ?)"},
+            {&insert_hand_yaku,
+             "INSERT INTO hand_yakus (hand, yaku) VALUES (?, ?)"},
+            {&delete_game, "DELETE FROM games WHERE name = ?"},
+            {&insert_game, "INSERT INTO games (name, date, n_players, "
+                           "beginning_score) VALUES (?, ?, ?, ?)"},
+            {&insert_game_player,
+             "INSERT INTO game_players (game, seat, player) VALUES (?, ?, ?)"},
+            {&insert_turn,
+             "INSERT INTO turns (game, turn, outcome, east, winner, loser, "
+             "fu, fan, hand) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)"},
+            {&insert_score_change,
+             "INSERT INTO score_changes (game, turn, seat, player, "
+             "score_change) VALUES (?, ?, ?, ?, ?)"}};
+        for (const auto &statement : statements) {
+            if (!statement.first->prepare(statement.second)) {
+                return failed(error_message,
+                              statement.first->lastError().text());
+            }
+        }
+        return true;
+    }
+
+    QSqlQuery insert_player;
+    QSqlQuery insert_hand;
+    QSqlQuery insert_hand_yaku;
+    QSqlQuery delete_game;
+    QSqlQuery insert_game;
+    QSqlQuery insert_game_player;
+    QSqlQuery insert_turn;
+    QSqlQuery insert_score_change;
+};
+
+CorpusStore::CorpusStore()
+    : connection_name_(
+          "corpus_store_" +
+          QString::number(reinterpret_cast<quintptr>(this), 16)),
+      in_batch_(false), batch_games_(0) {}
+
+CorpusStore::~CorpusStore() { close(); }
+
+bool CorpusStore::open(const QString &file_name, bool read_only,
+                       QString *error_message) {
+    close();
+    if (read_only && !QFileInfo(file_name).isFile()) {
+        return failed(error_message, "No such corpus store");
+    }
+    database_ = QSqlDatabase::addDatabase("QSQLITE", connection_name_);
+    database_.setDatabaseName(file_name);
+    if (read_only) {
+        database_.setConnectOptions("QSQLITE_OPEN_READONLY");
+    }
+    if (!database_.open()) {
+        const QString error = database_.lastError().text();
+        close();
+        return failed(error_message, error);
+    }
+
+    QSqlQuery version_query(database_);
+    if (!version_query.exec("PRAGMA user_version") || !version_query.next()) {
+        const QString error = version_query.lastError().text();
+        close();
+        return failed(error_message, error);
+    }
+    const int version = version_query.value(0).toInt();
+    version_query.finish();
+    QString error;
+    if (version == 0 && !read_only) {
+        if (!createSchema(&error)) {
+            close();
+            return failed(error_message, error);
+        }
+    } else if (version != SCHEMA_VERSION) {
+        close();
+        return failed(error_message, "Not a corpus store, or unsupported "
+                                     "version");
+    }
+    if (read_only) {
+        return true;
+    }
+
+    // The rows of a replaced game are deleted along with it
+    QSqlQuery pragma(database_);
+    statements_.reset(new Statements(database_));
+    if (!pragma.exec("PRAGMA foreign_keys = ON")) {
+        error = pragma.lastError().text();
+    }
+    if (!error.isEmpty() || !statements_->prepare(&error) ||
+        !loadIds(&error)) {
+        close();
+        return failed(error_message, error);
+    }
+    return true;
+}
+
+void CorpusStore::close() {
+    // The statements refer to the connection, which is removed last
+    statements_.reset();
+    if (database_.isOpen()) {
+        if (in_batch_) {
+            database_.rollback();
+        }
+        database_.close();
+    }
+    database_ = QSqlDatabase();
+    if (QSqlDatabase::contains(connection_name_)) {
+        QSqlDatabase::removeDatabase(connection_name_);
+    }
+    in_batch_ = false;
+    batch_games_ = 0;
+    player_ids_.clear();
+    hand_ids_.clear();
+}
+
+bool CorpusStore::createSchema(QString *error_message) {
+    if (!database_.transaction()) {
+        return failed(error_message, database_.lastError().text());
+    }
+    QSqlQuery query(database_);
+    bool success = true;
+    for (const char *statement : SCHEMA) {
+        success = success && query.exec(statement);
+    }
+    success = success && query.prepare("INSERT INTO yakus (id, name, yakuman) "
+                                       "VALUES (?, ?, ?)");
+    for (int yaku = 0; success && yaku < N_YAKUS; yaku++) {
+        query.addBindValue(yaku);
+        query.addBindValue(QString(YAKU_NAMES[yaku]));
+        query.addBindValue(isYakuman(static_cast<Yaku>(yaku)));
+        success = query.exec();
+    }
+    success = success &&
+              query.exec("PRAGMA user_version = " +
+                         QString::number(SCHEMA_VERSION)) &&
+              database_.commit();
+    if (!success) {
+        const QString error = query.lastError().text();
+        database_.rollback();
+        return failed(error_message, error);
+    }
+    return true;
+}
+
+bool CorpusStore::loadIds(QString *error_message) {
+    QSqlQuery query(database_);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, name FROM players")) {
+        return failed(error_message, query.lastError().text());
+    }
+    while (query.next()) {
+        player_ids_.insert(query.value(1).toString(),
+                           query.value(0).toLongLong());
+    }
+    if (!query.exec("SELECT id, description, riichi, ron FROM hands")) {
+        return failed(error_message, query.lastError().text());
+    }
+    while (query.next()) {
+        QByteArray key = query.value(1).toString().toUtf8();
+        key.append(static_cast<char>((query.value(2).toBool() ? 1 : 0) |
+                                     (query.value(3).toBool() ? 2 : 0)));
+        hand_ids_.insert(key, query.value(0).toLongLong());
+    }
+    return true;
+}
+
+bool CorpusStore::playerId(const QString &name, qint64 &id,
+                           QString *error_message) {
+    const auto found = player_ids_.constFind(name);
+    if (found != player_ids_.constEnd()) {
+        id = found.value();
+        return true;
+    }
+    QSqlQuery &insert = statements_->insert_player;
+    insert.addBindValue(name);
+    if (!insert.exec()) {
+        return failed(error_message, insert.lastError().text());
+    }
+    id = insert.lastInsertId().toLongLong();
+    player_ids_.insert(name, id);
+    added_players_.push_back(name);
+    return true;
+}
+
+bool CorpusStore::handId(const WinningHand &hand, qint64 &id,
+                         QString *error_message) {
+    const std::string description = hand.toString();
+    QByteArray key(description.data(), static_cast<int>(description.size()));
+    key.append(static_cast<char>((hand.isRiichi() ? 1 : 0) |
+                                 (hand.isRon() ? 2 : 0)));
+    const auto found = hand_ids_.constFind(key);
+    if (found != hand_ids_.constEnd()) {
+        id = found.value();
+        return true;
+    }
+
+    // Validated and scored once per distinct hand of the program
+    HandDictionary &dictionary = HandDictionary::instance();
+    const bool valid = dictionary.validity(hand).valid;
+    const HandScore &score = dictionary.score(hand);
+    QSqlQuery &insert = statements_->insert_hand;
+    insert.addBindValue(QString::fromStdString(description));
+    insert.addBindValue(hand.isRiichi());
+    insert.addBindValue(hand.isRon());
+    insert.addBindValue(valid);
+    insert.addBindValue(score.totalFu());
+    insert.addBindValue(score.totalFan());
+    if (!insert.exec()) {
+        return failed(error_message, insert.lastError().text());
+    }
+    id = insert.lastInsertId().toLongLong();
+    QSqlQuery &insert_yaku = statements_->insert_hand_yaku;
+    for (int yaku = 0; yaku < N_YAKUS; yaku++) {
+        if ((score.yakuMask() & HandScore::yakuBit(static_cast<Yaku>(yaku))) ==
+            0) {
+            continue;
+        }
+        insert_yaku.addBindValue(id);
+        insert_yaku.addBindValue(yaku);
+        if (!insert_yaku.exec()) {
+            return failed(error_message, insert_yaku.lastError().text());
+        }
+    }
+    hand_ids_.insert(key, id);
+    added_hands_.push_back(key);
+    return true;
+}
+
+bool CorpusStore::addGame(const QString &name, const QDateTime &date,
+                          const ScoresheetData &data,
+                          QString *error_message) {
+    if (!in_batch_) {
+        if (!database_.transaction()) {
+            return failed(error_message, database_.lastError().text());
+        }
+        in_batch_ = true;
+    }
+    // Each game is inserted under a savepoint, so that a failed game is
+    // rolled back alone and the batch only holds whole games
+    QSqlQuery savepoint(database_);
+    if (!savepoint.exec("SAVEPOINT game")) {
+        return failed(error_message, savepoint.lastError().text());
+    }
+    added_players_.clear();
+    added_hands_.clear();
+    bool success = insertGame(name, date, data, error_message);
+    if (success && !savepoint.exec("RELEASE game")) {
+        success = failed(error_message, savepoint.lastError().text());
+    }
+    if (!success) {
+        savepoint.exec("ROLLBACK TO game");
+        savepoint.exec("RELEASE game");
+        // The players and hands of the game are no longer stored
+        for (const QString &player : added_players_) {
+            player_ids_.remove(player);
+        }
+        for (const QByteArray &hand : added_hands_) {
+            hand_ids_.remove(hand);
+        }
+        return false;
+    }
+
+    batch_games_++;
+    return batch_games_ < BATCH_SIZE || commit(error_message);
+}
+
+bool CorpusStore::insertGame(const QString &name, const QDateTime &date,
+                             const ScoresheetData &data,
+                             QString *error_message) {
+    Statements &statements = *statements_;
+    statements.delete_game.addBindValue(name);
+    if (!statements.delete_game.exec()) {
+        return failed(error_message, statements.delete_game.lastError().text());
+    }
+    QSqlQuery &insert_game = statements.insert_game;
+    insert_game.addBindValue(name);
+    insert_game.addBindValue(date.toUTC().toString(Qt::ISODate));
+    insert_game.addBindValue(data.n_players);
+    insert_game.addBindValue(data.beginning_score);
+    if (!insert_game.exec()) {
+        return failed(error_message, insert_game.lastError().text());
+    }
+    const qint64 game = insert_game.lastInsertId().toLongLong();
+
+    std::vector<qint64> player_ids(data.n_players);
+    QVariantList seat_games, seats, seat_players;
+    for (int seat = 0; seat < data.n_players; seat++) {
+        if (!playerId(data.player_names[seat], player_ids[seat],
+                      error_message)) {
+            return false;
+        }
+        seat_games << game;
+        seats << seat;
+        seat_players << player_ids[seat];
+    }
+
+    // The turns and the score changes are bound column by column, and
+    // inserted in one batch each
+    const QVariant null_id(QVariant::LongLong);
+    const QVariant null_score(QVariant::Int);
+    QVariantList turn_games, turns, outcomes, easts, winners, losers, fus,
+        fans, hands;
+    QVariantList change_games, change_turns, change_seats, change_players,
+        changes;
+    for (size_t i = 0; i < data.turn_results.size(); i++) {
+        const int turn = static_cast<int>(i);
+        const TurnResult &result = data.turn_results[i];
+        const TurnOutcome outcome = result.outcome();
+        const bool victory =
+            outcome == TurnOutcome::TSUMO || outcome == TurnOutcome::RON;
+        turn_games << game;
+        turns << turn;
+        outcomes << QString(OUTCOME_NAMES[static_cast<int>(outcome)]);
+        easts << player_ids[result.eastPlayer()];
+        winners << (victory ? QVariant(player_ids[result.winner()]) : null_id);
+        losers << (outcome == TurnOutcome::RON
+                       ? QVariant(player_ids[result.loser()])
+                       : null_id);
+        fus << (victory ? QVariant(result.fuScore()) : null_score);
+        fans << (victory ? QVariant(result.fanScore()) : null_score);
+        qint64 hand = 0;
+        if (victory && result.hand() != nullptr) {
+            if (!handId(*result.hand(), hand, error_message)) {
+                return false;
+            }
+            hands << hand;
+        } else {
+            hands << null_id;
+        }
+
+        const std::vector<int> score_change =
+            result.computeScoreChange(data.n_players);
+        for (int seat = 0; seat < data.n_players &&
+                           seat < static_cast<int>(score_change.size());
+             seat++) {
+            change_games << game;
+            change_turns << turn;
+            change_seats << seat;
+            change_players << player_ids[seat];
+            changes << score_change[seat];
+        }
+    }
+
+    const std::pair<QSqlQuery *, std::vector<const QVariantList *>>
+        batches[] = {
+            {&statements.insert_game_player,
+             {&seat_games, &seats, &seat_players}},
+            {&statements.insert_turn,
+             {&turn_games, &turns, &outcomes, &easts, &winners, &losers, &fus,
+              &fans, &hands}},
+            {&statements.insert_score_change,
+             {&change_games, &change_turns, &change_seats, &change_players,
+              &changes}}};
+    for (const auto &batch : batches) {
+        if (batch.second.front()->isEmpty()) {
+            continue;
+        }
+        for (const QVariantList *column : batch.second) {
+            batch.first->addBindValue(*column);
+        }
+        if (!batch.first->execBatch()) {
+            return failed(error_message, batch.first->lastError().text());
+        }
+    }
+    return true;
+}
+
+bool CorpusStore::commit(QString *error_message) {
+    if (!in_batch_) {
+        return true;
+    }
+    in_batch_ = false;
+    batch_games_ = 0;
+    if (!database_.commit()) {
+        return failed(error_message, database_.lastError().text());
+    }
+    return true;
+}
+
+bool CorpusStore::query(const QString &sql, QTextStream &out,
+                        QString *error_message) {
+    QSqlQuery query(database_);
+    query.setForwardOnly(true);
+    if (!query.exec(sql)) {
+        return failed(error_message, query.lastError().text());
+    }
+    const QSqlRecord record = query.record();
+    for (int column = 0; column < record.count(); column++) {
+        out << (column > 0 ? "\t" : "") << record.fieldName(column);
+    }
+    out << "\n";
+    while (query.next()) {
+        for (int column = 0; column < record.count(); column++) {
+            out << (column > 0 ? "\t" : "") << query.value(column).toString();
+        }
+        out << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QString>
+#include <QTextStream>
+#include <memory>
+#include <vector>
+
+#include "scoresheetdata.hpp"
+
+/*
+ * Corpus store schema (SQLite), version 2
+ *
+ *  - players(id, name): the distinct player names
+ *  - games(id, name, date, n_players, beginning_score): one row per
+ *    scoresheet, named like in the analyses and dated by its file (ISO 8601
+ *    in UTC, so that the dates compare as text: date >= '2024')
+ *  - game_players(game, seat, player)
+ *  - yakus(id, name, yakuman): the Yaku values, in their order
+ *  - hands(id, description, riichi, ron, valid, fu, fan): the distinct
+ *    winning hands, described like in the .mss format, with the fu and fan
+ *    they score
+ *  - hand_yakus(hand, yaku): the yakus scored by each hand
+ *  - turns(game, turn, outcome, east, winner, loser, fu, fan, hand): the
+ *    turns, with the players (ids, not seats) and the recorded fu and fan;
+ *    outcome is tsumo, ron, manual or draw, and winner, loser, fu, fan and
+ *    hand are null when they do not apply
+ *  - score_changes(game, turn, seat, player, score_change): keyed by seat,
+ *    like game_players, as a player may hold several seats of a game
+ *
+ * The players (seats, winners, losers and score changes), the outcomes, the
+ * yakus and the dates of the games are indexed.
+ */
+
+/**
+ * @brief SQLite store of a corpus of scoresheets, for indexed queries
+ *
+ * The players and the hands are normalized: each one is stored once, and
+ * the games and turns refer to it. Games are ingested in batches, up to
+ * BATCH_SIZE games per transaction, through statements prepared once.
+ */
+class CorpusStore {
+  public:
+    /** Number of games ingested per transaction */
+    static const int BATCH_SIZE = 256;
+
+    CorpusStore();
+    ~CorpusStore();
+    CorpusStore(const CorpusStore &) = delete;
+    CorpusStore &operator=(const CorpusStore &) = delete;
+
+    /**
+     * @brief Open a store, created with its schema if the file is new
+     *
+     * @param read_only open an existing store, without allowing any change
+     * @return false if the store can't be opened or has another schema
+     * version
+     */
+    bool open(const QString &file_name, bool read_only,
+              QString *error_message = nullptr);
+    /**
+     * @brief Close the store, discarding the games of an uncommitted batch
+     */
+    void close();
+
+    /**
+     * @brief Add a game, replacing the game with the same name
+     *
+     * The game is added to the current batch, which is committed once full:
+     * commit() must be called after the last game. A game that fails is
+     * rolled back alone (the game it replaces is kept): the batch goes on
+     * with the games added before it.
+     */
+    bool addGame(const QString &name, const QDateTime &date,
+                 const ScoresheetData &data, QString *error_message = nullptr);
+    /**
+     * @brief Commit the current batch, if any
+     */
+    bool commit(QString *error_message = nullptr);
+
+    /**
+     * @brief Run a SQL query and write its rows, tab-separated, after a line
+     * of column names
+     */
+    bool query(const QString &sql, QTextStream &out,
+               QString *error_message = nullptr);
+
+  private:
+    struct Statements;
+
+    bool createSchema(QString *error_message);
+    /**
+     * @brief Load the ids of the stored players and hands
+     */
+    bool loadIds(QString *error_message);
+    /**
+     * @brief Insert the rows of a game, under the savepoint of addGame()
+     */
+    bool insertGame(const QString &name, const QDateTime &date,
+                    const ScoresheetData &data, QString *error_message);
+    /**
+     * @brief Id of a player, added if needed
+     */
+    bool playerId(const QString &name, qint64 &id, QString *error_message);
+    /**
+     * @brief Id of a hand, added with its score and yakus if needed
+     */
+    bool handId(const WinningHand &hand, qint64 &id, QString *error_message);
+
+    QString connection_name_;  /**< Connection of this store */
+    QSqlDatabase database_;
+    std::unique_ptr<Statements> statements_; /**< Prepared insertions */
+    bool in_batch_;            /**< Whether a transaction is open */
+    int batch_games_;          /**< Games of the current transaction */
+    QHash<QString, qint64> player_ids_;
+    QHash<QByteArray, qint64> hand_ids_; /**< By description and flags */
+    /** Players and hands added by the current game, forgotten if it fails */
+    std::vector<QString> added_players_;
+    std::vector<QByteArray> added_hands_;
+};
@@ -0,0 +1,9 @@
+#pragma once
+#include <QFile>
+
+/**
+ * @brief Flush the file and wait until its content is stored on disk
+ *
+ * @return true if the data is durable
+ */
+bool syncToDisk(QFile &file);
@@ -0,0 +1,429 @@
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+#include "fileutils.hpp"
+#include "gamearchive.hpp"
+
+/** Round an offset up to the next multiple of 8 */
+static quint64 align8(quint64 offset) { return (offset + 7) & ~quint64(7); }
+
+/**
+ * @brief Convert an index entry between host and little-endian byte order
+ * (the conversion is its own inverse)
+ */
+static MssaIndexEntry littleEndianEntry(const MssaIndexEntry &entry) {
+    MssaIndexEntry result = entry;
+    result.offset = qToLittleEndian(entry.offset);
+    result.size = qToLittleEndian(entry.size);
+    result.date = qToLittleEndian(entry.date);
+    result.n_turns = qToLittleEndian(entry.n_turns);
+    result.strings_offset = qToLittleEndian(entry.strings_offset);
+    return result;
+}
+
+/**
+ * @brief Append a length-prefixed UTF-8 string to a string pool
+ */
+static void appendString(QByteArray &pool, const QString &string) {
+    QByteArray utf8 = string.toUtf8().left(0xffff);
+    uchar length[2];
+    qToLittleEndian<quint16>(utf8.size(), length);
+    pool.append(reinterpret_cast<const char *>(length), 2);
+    pool.append(utf8);
+}
+
+/**
+ * @brief Skip n length-prefixed strings starting at the given position
+ */
+static const uchar *skipStrings(const uchar *string, int n) {
+    for (int i = 0; i < n; i++) {
+        string += 2 + qFromLittleEndian<quint16>(string);
+    }
+    return string;
+}
+
+/**
+ * @brief Whether n length-prefixed strings starting at the given offset lie
+ * inside a string pool of pool_size bytes
+ */
+static bool stringsFit(const uchar *pool, quint64 pool_size, quint64 offset,
+                       int n) {
+    for (int i = 0; i < n; i++) {
+        if (offset + 2 > pool_size) {
+            return false;
+        }
+        offset += 2 + qFromLittleEndian<quint16>(pool + offset);
+    }
+    return offset <= pool_size;
+}
+
+static QString readString(const uchar *string) {
+    return QString::fromUtf8(reinterpret_cast<const char *>(string + 2),
+                             qFromLittleEndian<quint16>(string));
+}
+
+/**
+ * @brief Load the header, the index (in host byte order) and the string pool
+ * of an opened archive file
+ */
+static bool readIndex(QFile &file, MssaHeader &header,
+                      std::vector<MssaIndexEntry> &entries, QByteArray &pool,
+                      QString *error_message) {
+    file.seek(0);
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) !=
+            sizeof(header) ||
+        std::memcmp(header.magic, MSSA_MAGIC, sizeof(MSSA_MAGIC)) != 0 ||
+        qFromLittleEndian(header.version) != MSSA_VERSION) {
+        if (error_message != nullptr) {
+            *error_message = "Not a game archive";
+        }
+        return false;
+    }
+    header.n_games = qFromLittleEndian(header.n_games);
+    header.pool_size = qFromLittleEndian(header.pool_size);
+    header.index_offset = qFromLittleEndian(header.index_offset);
+
+    entries.resize(header.n_games);
+    const qint64 index_size = header.n_games * sizeof(MssaIndexEntry);
+    if (!file.seek(header.index_offset) ||
+        file.read(reinterpret_cast<char *>(entries.data()), index_size) !=
+            index_size) {
+        if (error_message != nullptr) {
+            *error_message = "Truncated game index";
+        }
+        return false;
+    }
+    for (MssaIndexEntry &entry : entries) {
+        entry = littleEndianEntry(entry);
+    }
+    pool = file.read(header.pool_size);
+    if (pool.size() != static_cast<int>(header.pool_size)) {
+        if (error_message != nullptr) {
+            *error_message = "Truncated string pool";
+        }
+        return false;
+    }
+    // The strings of the current games are read when appending
+    for (const MssaIndexEntry &entry : entries) {
+        if (!(entry.flags & MSSA_DELETED) &&
+            !stringsFit(reinterpret_cast<const uchar *>(pool.constData()),
+                        pool.size(), entry.strings_offset,
+                        1 + entry.n_players)) {
+            if (error_message != nullptr) {
+                *error_message = "Corrupted string pool";
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write the index and the string pool at the given offset, then point
+ * the header to them once they are on disk
+ */
+static bool writeIndex(QFileDevice &file, quint64 index_offset,
+                       const std::vector<MssaIndexEntry> &entries,
+                       const QByteArray &pool) {
+    if (!file.seek(index_offset)) {
+        return false;
+    }
+    for (const MssaIndexEntry &entry : entries) {
+        MssaIndexEntry le_entry = littleEndianEntry(entry);
+        if (file.write(reinterpret_cast<const char *>(&le_entry),
+                       sizeof(le_entry)) != sizeof(le_entry)) {
+            return false;
+        }
+    }
+    if (file.write(pool) != pool.size()) {
+        return false;
+    }
+
+    // Make sure the games and the index are stored before the header
+    QFile *plain_file = qobject_cast<QFile *>(&file);
+    if (plain_file != nullptr && !syncToDisk(*plain_file)) {
+        return false;
+    }
+
+    MssaHeader header;
+    std::memcpy(header.magic, MSSA_MAGIC, sizeof(MSSA_MAGIC));
+    header.version = qToLittleEndian(MSSA_VERSION);
+    header.reserved = 0;
+    header.n_games = qToLittleEndian<quint32>(entries.size());
+    header.pool_size = qToLittleEndian<quint32>(pool.size());
+    header.index_offset = qToLittleEndian<quint64>(index_offset);
+    if (!file.seek(0) ||
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header)) !=
+            sizeof(header)) {
+        return false;
+    }
+    return plain_file == nullptr || syncToDisk(*plain_file);
+}
+
+GameArchive::GameArchive()
+    : data_(nullptr), size_(0), index_(nullptr), pool_(nullptr) {}
+
+GameArchive::~GameArchive() { close(); }
+
+bool GameArchive::open(const QString &file_name) {
+    close();
+    file_.setFileName(file_name);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        error_string_ = file_.errorString();
+        return false;
+    }
+    size_ = file_.size();
+    if (size_ < static_cast<qint64>(sizeof(MssaHeader)) ||
+        (data_ = file_.map(0, size_)) == nullptr) {
+        error_string_ = "Unable to map the game archive";
+        close();
+        return false;
+    }
+
+    const MssaHeader *header = reinterpret_cast<const MssaHeader *>(data_);
+    const quint64 index_offset = qFromLittleEndian(header->index_offset);
+    const quint32 n_games = qFromLittleEndian(header->n_games);
+    if (std::memcmp(header->magic, MSSA_MAGIC, sizeof(MSSA_MAGIC)) != 0 ||
+        qFromLittleEndian(header->version) != MSSA_VERSION) {
+        error_string_ = "Not a game archive";
+        close();
+        return false;
+    }
+    if (index_offset % 8 != 0 ||
+        index_offset + n_games * sizeof(MssaIndexEntry) +
+                qFromLittleEndian(header->pool_size) >
+            static_cast<quint64>(size_)) {
+        error_string_ = "Truncated or corrupted game archive";
+        close();
+        return false;
+    }
+    index_ = reinterpret_cast<const MssaIndexEntry *>(data_ + index_offset);
+    pool_ = data_ + index_offset + n_games * sizeof(MssaIndexEntry);
+
+    // Keep the current games, checking that they and their strings lie
+    // inside the archive
+    const quint32 pool_size = qFromLittleEndian(header->pool_size);
+    for (quint32 i = 0; i < n_games; i++) {
+        if (index_[i].flags & MSSA_DELETED) {
+            continue;
+        }
+        if (qFromLittleEndian(index_[i].offset) +
+                    qFromLittleEndian(index_[i].size) >
+                index_offset ||
+            !stringsFit(pool_, pool_size,
+                        qFromLittleEndian(index_[i].strings_offset),
+                        1 + index_[i].n_players)) {
+            error_string_ = "Corrupted game index";
+            close();
+            return false;
+        }
+        games_.push_back(i);
+    }
+    return true;
+}
+
+void GameArchive::close() {
+    if (data_ != nullptr) {
+        file_.unmap(const_cast<uchar *>(data_));
+    }
+    file_.close();
+    data_ = nullptr;
+    size_ = 0;
+    index_ = nullptr;
+    pool_ = nullptr;
+    games_.clear();
+}
+
+bool GameArchive::isOpen() const { return data_ != nullptr; }
+const QString &GameArchive::errorString() const { return error_string_; }
+
+int GameArchive::gameCount() const { return games_.size(); }
+
+QString GameArchive::gameName(int game) const {
+    return readString(gameString(game, 0));
+}
+
+QDateTime GameArchive::gameDate(int game) const {
+    return QDateTime::fromMSecsSinceEpoch(qFromLittleEndian(entry(game).date),
+                                          Qt::UTC);
+}
+
+int GameArchive::gameTurnCount(int game) const {
+    return qFromLittleEndian(entry(game).n_turns);
+}
+
+int GameArchive::gamePlayerCount(int game) const {
+    return entry(game).n_players;
+}
+
+QString GameArchive::gamePlayerName(int game, int player) const {
+    return readString(gameString(game, 1 + player));
+}
+
+int GameArchive::gamePlayerId(int game, int player,
+                              const PlayerRegistry &registry) const {
+    return registry.find(gamePlayerName(game, player));
+}
+
+int GameArchive::findGame(const QString &name) const {
+    for (int game = 0; game < gameCount(); game++) {
+        if (gameName(game) == name) {
+            return game;
+        }
+    }
+    return -1;
+}
+
+BinaryScoresheet GameArchive::game(int game) const {
+    const MssaIndexEntry &game_entry = entry(game);
+    return BinaryScoresheet(data_ + qFromLittleEndian(game_entry.offset),
+                            qFromLittleEndian(game_entry.size));
+}
+
+bool GameArchive::readGame(int game, ScoresheetData &data) const {
+    BinaryScoresheet scoresheet = this->game(game);
+    if (!scoresheet.isValid()) {
+        return false;
+    }
+    return scoresheet.read(data);
+}
+
+bool GameArchive::appendGame(const QString &file_name, const QString &name,
+                             const QDateTime &date, const ScoresheetData &data,
+                             QString *error_message) {
+    QByteArray game;
+    if (!BinaryScoresheet::encode(data, game, error_message)) {
+        return false;
+    }
+
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadWrite)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+
+    MssaHeader header;
+    std::vector<MssaIndexEntry> entries;
+    QByteArray pool;
+    if (file.size() > 0 &&
+        !readIndex(file, header, entries, pool, error_message)) {
+        return false;
+    }
+
+    // A game with the same name is replaced
+    for (MssaIndexEntry &old_entry : entries) {
+        if (!(old_entry.flags & MSSA_DELETED) &&
+            readString(reinterpret_cast<const uchar *>(pool.constData()) +
+                       old_entry.strings_offset) == name) {
+            old_entry.flags |= MSSA_DELETED;
+        }
+    }
+
+    // The game is written after the end of the file
+    MssaIndexEntry new_entry;
+    std::memset(&new_entry, 0, sizeof(new_entry));
+    new_entry.offset =
+        align8(std::max<quint64>(file.size(), sizeof(MssaHeader)));
+    new_entry.size = game.size();
+    new_entry.date = date.toMSecsSinceEpoch();
+    new_entry.n_turns = data.turn_results.size();
+    new_entry.n_players = data.n_players;
+    new_entry.strings_offset = pool.size();
+    appendString(pool, name);
+    for (int i = 0; i < data.n_players; i++) {
+        appendString(pool, data.player_names[i]);
+    }
+    entries.push_back(new_entry);
+
+    const qint64 end_of_file = file.size();
+    if (!file.seek(end_of_file) ||
+        file.write(QByteArray(new_entry.offset - end_of_file, '\0')) !=
+            static_cast<qint64>(new_entry.offset - end_of_file) ||
+        file.write(game) != game.size() ||
+        file.write(QByteArray(align8(file.pos()) - file.pos(), '\0')) < 0 ||
+        !writeIndex(file, file.pos(), entries, pool)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+
+    // Each append leaves the previous index as dead space: compact the
+    // archive once the dead space outweighs the rest
+    quint64 live_size = sizeof(MssaHeader) +
+                        entries.size() * sizeof(MssaIndexEntry) + pool.size();
+    for (const MssaIndexEntry &entry : entries) {
+        if (!(entry.flags & MSSA_DELETED)) {
+            live_size += align8(entry.size);
+        }
+    }
+    const quint64 archive_size = file.size();
+    file.close();
+    if (archive_size > 2 * live_size) {
+        // The archive is valid either way, a failed compaction is tried
+        // again on the next append
+        compact(file_name);
+    }
+    return true;
+}
+
+bool GameArchive::compact(const QString &file_name, QString *error_message) {
+    GameArchive archive;
+    if (!archive.open(file_name)) {
+        if (error_message != nullptr) {
+            *error_message = archive.errorString();
+        }
+        return false;
+    }
+
+    // Write the compacted archive aside and replace the original atomically
+    QSaveFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    std::vector<MssaIndexEntry> entries;
+    QByteArray pool;
+    // Reserve room for the header, written last
+    bool success = file.write(QByteArray(sizeof(MssaHeader), '\0')) ==
+                   sizeof(MssaHeader);
+    for (int game = 0; success && game < archive.gameCount(); game++) {
+        MssaIndexEntry new_entry = littleEndianEntry(archive.entry(game));
+        const char *game_data = reinterpret_cast<const char *>(
+            archive.data_ + new_entry.offset);
+        new_entry.offset = file.pos();
+        new_entry.strings_offset = pool.size();
+        appendString(pool, archive.gameName(game));
+        for (int i = 0; i < new_entry.n_players; i++) {
+            appendString(pool, archive.gamePlayerName(game, i));
+        }
+        entries.push_back(new_entry);
+        success = file.write(game_data, new_entry.size) ==
+                      static_cast<qint64>(new_entry.size) &&
+                  file.write(QByteArray(align8(file.pos()) - file.pos(),
+                                        '\0')) >= 0;
+    }
+    success = success && writeIndex(file, file.pos(), entries, pool);
+    if (!success || !file.commit()) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+const MssaIndexEntry &GameArchive::entry(int game) const {
+    return index_[games_[game]];
+}
+
+const uchar *GameArchive::gameString(int game, int n) const {
+    return skipStrings(pool_ + qFromLittleEndian(entry(game).strings_offset),
+                       n);
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <vector>
+
+#include "binaryscoresheet.hpp"
+#include "playerregistry.hpp"
+#include "scoresheetdata.hpp"
+
+/*
+ * Multi-game archive format (.mssa), version 1
+ *
+ * All integers are little-endian. The file is made of:
+ *  - a fixed-size header (MssaHeader)
+ *  - the games, each one stored as a binary scoresheet (.mssb) starting on a
+ *    multiple of 8 bytes
+ *  - the game index: n_games fixed-size entries (MssaIndexEntry)
+ *  - the string pool holding, for each entry, its game name then its player
+ *    names, each one as a 16-bit length followed by UTF-8 bytes
+ *
+ * Appending a game writes the game and a new index after the end of the
+ * file, and only then updates the header: an interrupted append leaves the
+ * previous archive intact. Replaced games and old indexes are dead space
+ * until the archive is compacted, which appending does by itself once the
+ * dead space exceeds the size of the rest of the archive: the dead space is
+ * bounded by the live data, and each compaction copies less than the bytes
+ * appended since the previous one.
+ */
+
+static const char MSSA_MAGIC[4] = {'M', 'S', 'S', 'A'};
+static const quint16 MSSA_VERSION = 1;
+
+/**
+ * @brief Header of a game archive
+ */
+struct MssaHeader {
+    char magic[4];        /**< "MSSA" */
+    quint16 version;      /**< Format version */
+    quint16 reserved;     /**< Always 0 */
+    quint32 n_games;      /**< Number of index entries */
+    quint32 pool_size;    /**< Size of the string pool */
+    quint64 index_offset; /**< Offset of the game index */
+};
+static_assert(sizeof(MssaHeader) == 24, "Unexpected MssaHeader layout");
+
+/** Index entry flag: the game was replaced or removed */
+static const quint8 MSSA_DELETED = 0x1;
+
+/**
+ * @brief Entry of the game index
+ */
+struct MssaIndexEntry {
+    quint64 offset;         /**< Offset of the game binary scoresheet */
+    quint64 size;           /**< Size of the game binary scoresheet */
+    qint64 date;            /**< Date of the game (ms since epoch, UTC) */
+    quint32 n_turns;        /**< Number of turns of the game */
+    quint32 strings_offset; /**< Offset of the game strings in the pool */
+    quint8 n_players;       /**< Number of players of the game */
+    quint8 flags;           /**< MSSA_DELETED */
+    quint8 reserved[6];     /**< Always 0 */
+};
+static_assert(sizeof(MssaIndexEntry) == 40, "Unexpected MssaIndexEntry layout");
+
+/**
+ * @brief Read access to a multi-game archive file
+ *
+ * The archive is mapped in memory: listing the games reads the index in
+ * place and each game is accessed as a BinaryScoresheet view, without
+ * parsing the rest of the archive. Games are numbered from 0 in append order,
+ * replaced games excluded.
+ */
+class GameArchive {
+  public:
+    GameArchive();
+    ~GameArchive();
+    GameArchive(const GameArchive &) = delete;
+    GameArchive &operator=(const GameArchive &) = delete;
+
+    /**
+     * @brief Open and map an archive file
+     *
+     * @return false if the file cannot be mapped or is not a valid archive
+     */
+    bool open(const QString &file_name);
+    void close();
+    bool isOpen() const;
+    const QString &errorString() const;
+
+    /* Game index */
+    int gameCount() const;
+    QString gameName(int game) const;
+    QDateTime gameDate(int game) const;
+    int gameTurnCount(int game) const;
+    int gamePlayerCount(int game) const;
+    QString gamePlayerName(int game, int player) const;
+    /**
+     * @brief Registry id of a player of a game, or -1 if its name is not
+     * registered
+     */
+    int gamePlayerId(int game, int player,
+                     const PlayerRegistry &registry) const;
+    /**
+     * @brief Returns the number of the game with the given name, or -1
+     */
+    int findGame(const QString &name) const;
+
+    /**
+     * @brief In-place view on the binary scoresheet of a game
+     */
+    BinaryScoresheet game(int game) const;
+    /**
+     * @brief Decode the whole scoresheet of a game
+     */
+    bool readGame(int game, ScoresheetData &data) const;
+
+    /* Archive tools */
+    /**
+     * @brief Append a game to an archive, creating the archive if needed
+     *
+     * A game already stored with the same name is replaced. The archive is
+     * compacted when its dead space outweighs the rest.
+     */
+    static bool appendGame(const QString &file_name, const QString &name,
+                           const QDateTime &date, const ScoresheetData &data,
+                           QString *error_message = nullptr);
+    /**
+     * @brief Rewrite an archive without the replaced games and dead space
+     */
+    static bool compact(const QString &file_name,
+                        QString *error_message = nullptr);
+
+  private:
+    const MssaIndexEntry &entry(int game) const;
+    /**
+     * @brief Pointer to the n-th string of a game in the string pool (0 is
+     * the game name, then the player names)
+     */
+    const uchar *gameString(int game, int n) const;
+
+    QFile file_;                  /**< Archive file */
+    const uchar *data_;           /**< Mapping of the whole archive */
+    qint64 size_;                 /**< Size of the archive */
+    const MssaIndexEntry *index_; /**< Game index */
+    const uchar *pool_;           /**< String pool */
+    std::vector<int> games_;      /**< Index entries of the current games */
+    QString error_string_;        /**< Last error */
+};
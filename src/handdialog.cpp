@@ -444,7 +444,7 @@ const WinningHand &HandDialog::hand() const { return hand_represented_; }
 
 void HandDialog::updateScoreText() {
     HandScore score = hand_represented_.computeScore();
-    score_text_->setText(score.toString());
+    score_text_->setText(QString::fromStdString(score.toString()));
 }
 
 void HandDialog::onChange() {
@@ -0,0 +1,152 @@
+#include <QMutexLocker>
+#include <cstring>
+
+#include "handdictionary.hpp"
+
+/**
+ * @brief Riichi and ron flags of the turn of a hand
+ */
+static quint32 turnFlags(bool riichi, bool ron) {
+    return (riichi ? 1 : 0) | (ron ? 2 : 0);
+}
+
+HandDictionary &HandDictionary::instance() {
+    static HandDictionary dictionary;
+    return dictionary;
+}
+
+bool HandDictionary::Key::operator==(const Key &other) const {
+    return std::memcmp(this, &other, sizeof(Key)) == 0;
+}
+
+size_t HandDictionary::KeyHash::operator()(const Key &key) const {
+    static_assert(sizeof(Key) == 24, "Unexpected HandDictionary::Key layout");
+    return std::hash<std::string_view>()(
+        std::string_view(reinterpret_cast<const char *>(&key), sizeof(Key)));
+}
+
+HandDictionary::Key HandDictionary::key(const MssbHand &encoded,
+                                        int total_doras, bool riichi,
+                                        bool ron) {
+    Key key;
+    key.hand = encoded;
+    key.hand.total_doras = 0;
+    key.total_doras = total_doras;
+    key.flags = turnFlags(riichi, ron);
+    return key;
+}
+
+template <class F>
+HandDictionary::Entry *HandDictionary::findOrAdd(Shard &shard, const Key &key,
+                                                 F make_hand) {
+    Entry *&entry = shard.entries_by_key[key];
+    if (entry == nullptr) {
+        shard.entries.push_back(Entry{make_hand()});
+        entry = &shard.entries.back();
+    }
+    return entry;
+}
+
+const WinningHand *HandDictionary::intern(const WinningHand &hand) {
+    MssbHand encoded;
+    BinaryScoresheet::encodeHand(hand, encoded);
+    const Key hand_key =
+        key(encoded, hand.totalDoras(), hand.isRiichi(), hand.isRon());
+    Shard &shard = shards_[KeyHash()(hand_key) % N_SHARDS];
+    QMutexLocker locker(&shard.mutex);
+    return &findOrAdd(shard, hand_key, [&hand]() { return hand; })->hand;
+}
+
+const WinningHand *HandDictionary::internEncoded(const MssbHand &encoded,
+                                                 bool riichi, bool ron) {
+    const Key hand_key = key(encoded, encoded.total_doras, riichi, ron);
+    Shard &shard = shards_[KeyHash()(hand_key) % N_SHARDS];
+    QMutexLocker locker(&shard.mutex);
+    return &findOrAdd(shard, hand_key,
+                      [&]() {
+                          return BinaryScoresheet::decodeHand(encoded, riichi,
+                                                              ron);
+                      })
+                ->hand;
+}
+
+const WinningHand *HandDictionary::findDescription(const char *begin,
+                                                   const char *end,
+                                                   bool riichi,
+                                                   bool ron) const {
+    // Looked up in place in the scoresheet
+    const std::string_view description(begin, end - begin);
+    const Shard &shard =
+        shards_[std::hash<std::string_view>()(description) % N_SHARDS];
+    QMutexLocker locker(&shard.mutex);
+    const auto &hands = shard.hands_by_description[turnFlags(riichi, ron)];
+    const auto found = hands.find(description);
+    return found != hands.end() ? found->second : nullptr;
+}
+
+void HandDictionary::addDescription(const char *begin, const char *end,
+                                    bool riichi, bool ron,
+                                    const WinningHand *hand) {
+    const std::string_view description(begin, end - begin);
+    Shard &shard =
+        shards_[std::hash<std::string_view>()(description) % N_SHARDS];
+    QMutexLocker locker(&shard.mutex);
+    auto &hands = shard.hands_by_description[turnFlags(riichi, ron)];
+    if (shard.descriptions.size() >= MAX_SHARD_DESCRIPTIONS ||
+        hands.count(description) != 0) {
+        return;
+    }
+    // The texts never move once in the deque, so their views stay valid
+    shard.descriptions.emplace_back(description);
+    hands.emplace(shard.descriptions.back(), hand);
+}
+
+const HandDictionary::Entry &
+HandDictionary::scoredEntry(const WinningHand &hand) {
+    // A hand built elsewhere (e.g. in the GUI) is scored as its copy
+    MssbHand encoded;
+    BinaryScoresheet::encodeHand(hand, encoded);
+    const Key hand_key =
+        key(encoded, hand.totalDoras(), hand.isRiichi(), hand.isRon());
+    Shard &shard = shards_[KeyHash()(hand_key) % N_SHARDS];
+    const WinningHand *shared_hand;
+    {
+        QMutexLocker locker(&shard.mutex);
+        const Entry *entry =
+            findOrAdd(shard, hand_key, [&hand]() { return hand; });
+        if (entry->scored) {
+            return *entry;
+        }
+        shared_hand = &entry->hand;
+    }
+
+    // Scored outside the lock: several threads may score the same new hand,
+    // only the first result is kept
+    const ValidityStatus validity = shared_hand->checkValid();
+    const HandScore score = shared_hand->computeScore();
+    QMutexLocker locker(&shard.mutex);
+    Entry *entry = shard.entries_by_key[hand_key];
+    if (!entry->scored) {
+        entry->validity = validity;
+        entry->score = score;
+        entry->scored = true;
+    }
+    return *entry;
+}
+
+const ValidityStatus &HandDictionary::validity(const WinningHand &hand) {
+    return scoredEntry(hand).validity;
+}
+
+const HandScore &HandDictionary::score(const WinningHand &hand) {
+    return scoredEntry(hand).score;
+}
+
+int HandDictionary::size() const {
+    int size = 0;
+    for (const Shard &shard : shards_) {
+        QMutexLocker locker(&shard.mutex);
+        size += shard.entries.size();
+    }
+    return size;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <QMutex>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "binaryscoresheet.hpp"
+#include "winning_hand.hpp"
+
+/**
+ * @brief Dictionary of the distinct winning hands, shared by the scoresheet
+ * readers
+ *
+ * Winning hands repeat heavily across the turns of a season: the readers
+ * intern them here, so that each distinct hand (its encoding in the binary
+ * format, and the riichi and ron flags of its turn) is parsed or decoded,
+ * stored, validated and scored once. The turn results then point to the
+ * same WinningHand.
+ *
+ * The hands are kept for the lifetime of the program, like the hands the
+ * turn results pointed to before: the dictionary only grows with the hands
+ * it never saw, so reading the same scoresheets again costs no memory. The
+ * text descriptions remembered to skip parsing are bounded, a description
+ * beyond the bound being parsed each time.
+ *
+ * The dictionary can be used from several threads: it is split in shards
+ * locked independently, and lookups copy nothing.
+ */
+class HandDictionary {
+  public:
+    /** Number of shards, locked independently */
+    static const int N_SHARDS = 16;
+    /** Number of text descriptions remembered by each shard */
+    static const int MAX_SHARD_DESCRIPTIONS = 4096;
+
+    /**
+     * @brief Dictionary shared by the whole program
+     */
+    static HandDictionary &instance();
+
+    /**
+     * @brief Shared copy of a hand, added if it is not in the dictionary
+     */
+    const WinningHand *intern(const WinningHand &hand);
+    /**
+     * @brief Shared hand of a binary encoded hand, decoded only if it is not
+     * in the dictionary
+     */
+    const WinningHand *internEncoded(const MssbHand &encoded, bool riichi,
+                                     bool ron);
+    /**
+     * @brief Shared hand of a text description in [begin, end) (as written
+     * in the .mss format), or null if the description was never added
+     */
+    const WinningHand *findDescription(const char *begin, const char *end,
+                                       bool riichi, bool ron) const;
+    /**
+     * @brief Remember the shared hand of a text description, so that it is
+     * not parsed again (unless its shard is full)
+     */
+    void addDescription(const char *begin, const char *end, bool riichi,
+                        bool ron, const WinningHand *hand);
+
+    /**
+     * @brief Validity of a hand, checked once per distinct hand
+     */
+    const ValidityStatus &validity(const WinningHand &hand);
+    /**
+     * @brief Score of a hand, computed once per distinct hand
+     */
+    const HandScore &score(const WinningHand &hand);
+
+    /**
+     * @brief Number of distinct hands
+     */
+    int size() const;
+
+  private:
+    /**
+     * @brief Distinct hand, with its validity and score once computed
+     */
+    struct Entry {
+        WinningHand hand;
+        bool scored = false;
+        ValidityStatus validity;
+        HandScore score;
+    };
+    /**
+     * @brief Key of a distinct hand, hashed and compared as bytes
+     */
+    struct Key {
+        MssbHand hand;      /**< Encoding, with total_doras set to 0 */
+        qint32 total_doras; /**< In full, the encoding only keeping 8 bits */
+        quint32 flags;      /**< Riichi in bit 0, ron in bit 1 */
+
+        bool operator==(const Key &other) const;
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+    /**
+     * @brief Part of the dictionary, holding the hands and the descriptions
+     * whose keys hash to it
+     */
+    struct Shard {
+        mutable QMutex mutex;
+        std::deque<Entry> entries; /**< Distinct hands, at stable addresses */
+        std::unordered_map<Key, Entry *, KeyHash> entries_by_key;
+        /** Texts of the descriptions, viewed by the keys of
+         * hands_by_description */
+        std::deque<std::string> descriptions;
+        /** Hands of the descriptions, by riichi and ron flags */
+        std::unordered_map<std::string_view, const WinningHand *>
+            hands_by_description[4];
+    };
+
+    HandDictionary() = default;
+    static Key key(const MssbHand &encoded, int total_doras, bool riichi,
+                   bool ron);
+    /**
+     * @brief Entry of a key, added with the hand built by make_hand if
+     * needed (the mutex of the shard must be locked)
+     */
+    template <class F>
+    static Entry *findOrAdd(Shard &shard, const Key &key, F make_hand);
+    /**
+     * @brief Entry of a hand, validated and scored
+     */
+    const Entry &scoredEntry(const WinningHand &hand);
+
+    Shard shards_[N_SHARDS];
+};
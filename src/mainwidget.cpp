@@ -8,6 +8,10 @@
 #include "addresultdialog.hpp"
 #include "mainwidget.hpp"
 #include "showdetaildialog.hpp"
+#include "turncommands.hpp"
+
+/** Maximum number of edits kept in the undo history */
+static const int UNDO_LIMIT = 500;
 
 MainWidget::MainWidget(QWidget *parent, ScoreModel *_score_model)
     : QWidget(parent), n_players_(_score_model->NPlayers()),
@@ -15,7 +19,9 @@ MainWidget::MainWidget(QWidget *parent, ScoreModel *_score_model)
       score_view_(new QTableView),
       add_result_button_(new QPushButton(tr("&Add turn result"))),
       delete_result_button_(new QPushButton(tr("&Delete turn result"))),
-      result_detail_button_(new QPushButton(tr("&Turn result detail"))) {
+      edit_result_button_(new QPushButton(tr("&Edit turn result"))),
+      result_detail_button_(new QPushButton(tr("&Turn result detail"))),
+      undo_stack_(new QUndoStack(this)) {
     // Link view with score model
     score_view_->setModel(_score_model);
 
@@ -29,10 +35,11 @@ MainWidget::MainWidget(QWidget *parent, ScoreModel *_score_model)
 
     // Define the layout of the main widget
     QGridLayout *main_layout = new QGridLayout;
-    main_layout->addWidget(score_view_, 0, 0, 4, 1);
+    main_layout->addWidget(score_view_, 0, 0, 5, 1);
     main_layout->addWidget(add_result_button_, 0, 1);
     main_layout->addWidget(delete_result_button_, 1, 1);
-    main_layout->addWidget(result_detail_button_, 2, 1);
+    main_layout->addWidget(edit_result_button_, 2, 1);
+    main_layout->addWidget(result_detail_button_, 3, 1);
 
     // Set the layout of the main widget
     setLayout(main_layout);
@@ -47,41 +54,40 @@ MainWidget::MainWidget(QWidget *parent, ScoreModel *_score_model)
             &QItemSelectionModel::selectionChanged, this,
             &MainWidget::tableClicked);
 
-    // Initially, detail and delete buttons are disabled
+    // Initially, detail, edit and delete buttons are disabled
     delete_result_button_->setDisabled(true);
+    edit_result_button_->setDisabled(true);
     result_detail_button_->setDisabled(true);
 
+    // Bound the memory used by the undo history
+    undo_stack_->setUndoLimit(UNDO_LIMIT);
+
+    // A new or loaded scoresheet starts with an empty undo history
+    connect(_score_model, &ScoreModel::modelReset, undo_stack_,
+            &QUndoStack::clear);
+
     // Connect a click on delete button to the action of deleting a turn
     connect(delete_result_button_, &QPushButton::clicked, this,
             &MainWidget::deleteResult);
 
+    // Connect a click on edit button to the edition of the selected turn
+    connect(edit_result_button_, &QPushButton::clicked, this,
+            &MainWidget::editResult);
+
     // Connect a click on show detail button to the showing of the detail dialog
     connect(result_detail_button_, &QPushButton::clicked, this,
             &MainWidget::showTurnDetail);
 }
 
+QUndoStack *MainWidget::undoStack() const { return undo_stack_; }
+
 void MainWidget::addResult() {
     AddResultDialog add_result_dialog(this, n_players_, player_names_);
 
     // Popup the add result dialog
     if (add_result_dialog.exec() == QDialog::Accepted) {
-        if (add_result_dialog.RonVictory() <= 1) {
-            score_model_->addTurnResult(TurnResult(
-                add_result_dialog.EastPlayer(), add_result_dialog.Winner(),
-                add_result_dialog.RonVictory(), add_result_dialog.Loser(),
-                add_result_dialog.Player1DidRiichi(),
-                add_result_dialog.Player2DidRiichi(),
-                add_result_dialog.Player3DidRiichi(),
-                add_result_dialog.Player4DidRiichi(),
-                add_result_dialog.FuScore(), add_result_dialog.FanScore(),
-                add_result_dialog.winningHand()));
-        } else if (add_result_dialog.RonVictory() == 2) { // Manual score
-            score_model_->addTurnResult(
-                TurnResult(add_result_dialog.ManualScores()));
-        } else if (add_result_dialog.RonVictory() == 3) { // Draw
-            score_model_->addTurnResult(
-                TurnResult(add_result_dialog.DrawResult()));
-        }
+        undo_stack_->push(
+            new AddTurnCommand(score_model_, add_result_dialog.turnResult()));
         score_view_->resizeColumnsToContents();
     }
 }
@@ -91,12 +97,14 @@ void MainWidget::tableClicked() {
     if (!(score_view_->selectionModel()->isSelected(
             score_view_->selectionModel()->currentIndex())) ||
         score_view_->selectionModel()->currentIndex().row() == 0) {
-        // In this case, detail and delete buttons should be disabled
+        // In this case, detail, edit and delete buttons should be disabled
         delete_result_button_->setDisabled(true);
+        edit_result_button_->setDisabled(true);
         result_detail_button_->setDisabled(true);
     } else if (score_view_->selectionModel()->currentIndex().row() > 0) {
-        // In this case, detail and delete buttons should be enabled
+        // In this case, detail, edit and delete buttons should be enabled
         delete_result_button_->setDisabled(false);
+        edit_result_button_->setDisabled(false);
         result_detail_button_->setDisabled(false);
     }
 }
@@ -115,7 +123,20 @@ void MainWidget::deleteResult() {
     }
 
     // Delete the turn in the model
-    score_model_->deleteTurnResult(row_selected - 1);
+    undo_stack_->push(new DeleteTurnCommand(score_model_, row_selected - 1));
+}
+
+void MainWidget::editResult() {
+    int row_selected = score_view_->selectionModel()->currentIndex().row();
+
+    AddResultDialog edit_result_dialog(this, n_players_, player_names_);
+    edit_result_dialog.setTurnResult(
+        score_model_->turnResults().at(row_selected - 1));
+
+    if (edit_result_dialog.exec() == QDialog::Accepted) {
+        undo_stack_->push(new EditTurnCommand(score_model_, row_selected - 1,
+                                              edit_result_dialog.turnResult()));
+    }
 }
 
 void MainWidget::showTurnDetail() {
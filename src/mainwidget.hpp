@@ -2,6 +2,7 @@
 #include <QDialog>
 #include <QPushButton>
 #include <QTableView>
+#include <QUndoStack>
 
 #include "scoremodel.hpp"
 
@@ -15,6 +16,11 @@ class MainWidget : public QWidget {
   public:
     MainWidget(QWidget *parent, ScoreModel *_score_model);
 
+    /**
+     * @brief Returns the undo stack holding the edits of the scoresheet
+     */
+    QUndoStack *undoStack() const;
+
   private slots:
     /**
      * @brief Slot for when adding a turn result
@@ -28,6 +34,10 @@ class MainWidget : public QWidget {
      * @brief Slot for when deleting a turn result
      */
     void deleteResult();
+    /**
+     * @brief Slot for when editing a turn result
+     */
+    void editResult();
     /**
      * @brief Slot for when showing a turn result details
      */
@@ -41,5 +51,7 @@ class MainWidget : public QWidget {
     QTableView *score_view_;            /**< The scoresheet view */
     QPushButton *add_result_button_;    /**< The "Add result" button */
     QPushButton *delete_result_button_; /**< The "Delete result" button */
+    QPushButton *edit_result_button_;   /**< The "Edit result" button */
     QPushButton *result_detail_button_; /**< The "Result detail" button */
+    QUndoStack *undo_stack_;            /**< Undo / redo history of edits */
 };
\ No newline at end of file
@@ -1,4 +1,6 @@
+#include <QtConcurrent>
 #include <QtWidgets>
+#include <algorithm>
 #include <iostream>
 
 #include "handdialog.hpp"
@@ -7,7 +9,9 @@
 #include "newgamedialog.hpp"
 
 MainWindow::MainWindow()
-    : score_model_(this), main_widget_(new MainWidget(this, &score_model_)) {
+    : score_model_(this), journal_(&score_model_),
+      autosaver_(&score_model_, &journal_),
+      main_widget_(new MainWidget(this, &score_model_)) {
     /* Create Menus */
     createActions();
     setUnifiedTitleAndToolBarOnMac(true);
@@ -17,10 +21,55 @@ MainWindow::MainWindow()
 
     // Resize window
     resize(700, 700);
+
+    connect(&journal_, &ScoresheetJournal::writeError, this,
+            [this](const QString &error_message) {
+                statusBar()->showMessage(
+                    tr("Unable to journal changes (%1)").arg(error_message));
+            });
+    connect(&autosaver_, &AutoSaver::saved, this,
+            [this](const QString &file_name, qint64 latency_ms) {
+                statusBar()->showMessage(tr("Autosaved %1 in %2 ms")
+                                             .arg(QFileInfo(file_name).fileName())
+                                             .arg(latency_ms),
+                                         AUTOSAVE_MESSAGE_TIMEOUT_MS);
+            });
+    connect(&autosaver_, &AutoSaver::saveFailed, this,
+            [this](const QString &file_name, const QString &error_message) {
+                statusBar()->showMessage(tr("Unable to autosave %1 (%2)")
+                                             .arg(QFileInfo(file_name).fileName())
+                                             .arg(error_message));
+            });
+    connect(&load_watcher_,
+            &QFutureWatcher<std::shared_ptr<LoadedScoresheet>>::finished, this,
+            &MainWindow::loadFinished);
+}
+
+void MainWindow::recoverJournaledFile() {
+    // A journaled scoresheet still set means the application did not exit
+    // cleanly while it was edited
+    const QString file_name = QSettings().value("journal/file").toString();
+    if (file_name.isEmpty() || !QFile::exists(file_name)) {
+        return;
+    }
+    const QMessageBox::StandardButton ret = QMessageBox::question(
+        this, tr("Recover scoresheet"),
+        tr("The application was not closed properly while editing %1. Do "
+           "you want to recover this scoresheet?")
+            .arg(file_name));
+    if (ret == QMessageBox::Yes) {
+        loadFile(file_name);
+    } else {
+        QSettings().remove("journal/file");
+    }
 }
 
 void MainWindow::closeEvent(QCloseEvent *event) {
     if (confirmExit()) {
+        // Stop loading before the window goes away
+        load_cancelled_ = true;
+        load_watcher_.waitForFinished();
+        closeJournal();
         event->accept();
     } else {
         event->ignore();
@@ -31,6 +80,7 @@ void MainWindow::newGame() {
     NewGameDialog new_game_dialog(this);
 
     if (new_game_dialog.exec() == QDialog::Accepted) {
+        closeJournal();
         // Load new game information
         score_model_.reset(new_game_dialog.nPlayers(),
                            new_game_dialog.beginningScore(),
@@ -61,27 +111,26 @@ void MainWindow::save() {
     // If no current save file, call saveAs()
     if (current_save_file_.isEmpty()) {
         saveAs();
+        return;
     }
 
-    // Try to open the file in write mode
-    QFile file(current_save_file_);
-    if (!file.open(QIODevice::WriteOnly)) {
-        QMessageBox::information(this, tr("Unable to open file"),
-                                 file.errorString());
-        current_save_file_ = "";
+    // Write the whole scoresheet (atomically), in the format given by the
+    // file extension, then journal the following changes
+    autosaver_.cancel();
+    QString error_message;
+    if (!journal_.save(current_save_file_, &error_message)) {
+        QMessageBox::warning(this, tr("Unable to save file"), error_message);
         return;
     }
-
-    // Serialize the score model to the file
-    QTextStream out(&file);
-    score_model_.writeToTextStream(out);
+    QSettings().setValue("journal/file", current_save_file_);
 }
 
 void MainWindow::saveAs() {
     // Ask for file dialog
     current_save_file_ = QFileDialog::getSaveFileName(
         this, tr("Save scoresheet"), "",
-        tr("Mahjong Scoresheet (*.mss);;All Files (*)"));
+        tr("Mahjong Scoresheet (*.mss);;Binary Mahjong Scoresheet "
+           "(*.mssb);;All Files (*)"));
 
     // Save scoresheet to file
     if (!current_save_file_.isEmpty()) {
@@ -93,26 +142,171 @@ void MainWindow::load() {
     // Ask for file dialog
     QString load_file = QFileDialog::getOpenFileName(
         this, tr("Load scoresheet"), "",
-        tr("Mahjong Scoresheet (*.mss);;All Files(*)"));
+        tr("Mahjong Scoresheet (*.mss *.mssb);;Mahjong Game Archive "
+           "(*.mssa);;All Files(*)"));
+
+    // Load a game of an archive
+    if (load_file.endsWith(".mssa", Qt::CaseInsensitive)) {
+        loadFromArchive(load_file);
+        return;
+    }
 
     // Load scoresheet from file
     if (!load_file.isEmpty()) {
-        QFile file(load_file);
-        if (!file.open(QIODevice::ReadOnly)) {
-            QMessageBox::information(this, tr("Unable to open file"),
-                                     file.errorString());
-            return;
+        loadFile(load_file);
+    }
+}
+
+/**
+ * @brief Read a scoresheet file and replay its journal (run on a worker
+ * thread)
+ */
+static std::shared_ptr<LoadedScoresheet>
+readScoresheet(const QString &file_name, const ProgressCallback &progress) {
+    auto loaded = std::make_shared<LoadedScoresheet>();
+    QFile file(file_name);
+    if (!file.open(QIODevice::ReadOnly)) {
+        loaded->error_message = file.errorString();
+        return loaded;
+    }
+    loaded->opened = true;
+    if (!ScoresheetData::readFile(file, loaded->data, &loaded->error_message,
+                                  progress)) {
+        return loaded;
+    }
+    file.close();
+    loaded->success = true;
+
+    // Apply the changes journaled since the file was last written
+    loaded->journal_replayed = ScoresheetJournal::replay(
+        file_name, loaded->data, &loaded->n_records, &loaded->journal_error);
+    return loaded;
+}
+
+void MainWindow::loadFile(const QString &file_name) {
+    if (load_watcher_.isRunning()) {
+        return;
+    }
+    loading_file_ = file_name;
+    load_cancelled_ = false;
+
+    // The progress dialog only shows up if loading takes a while
+    load_progress_ = new QProgressDialog(
+        tr("Loading %1...").arg(QFileInfo(file_name).fileName()), tr("Cancel"),
+        0, LOAD_PROGRESS_STEPS, this);
+    load_progress_->setWindowModality(Qt::WindowModal);
+    load_progress_->setMinimumDuration(LOAD_PROGRESS_DELAY_MS);
+    connect(load_progress_, &QProgressDialog::canceled, this,
+            [this]() { load_cancelled_ = true; });
+
+    // The dialog is deleted once loading is over: pending progress updates
+    // are then dropped
+    QProgressDialog *progress_dialog = load_progress_;
+    const ProgressCallback progress = [this, progress_dialog](qint64 done,
+                                                              qint64 total) {
+        QMetaObject::invokeMethod(
+            progress_dialog, "setValue", Qt::QueuedConnection,
+            Q_ARG(int, static_cast<int>(done * LOAD_PROGRESS_STEPS /
+                                        std::max<qint64>(total, 1))));
+        return !load_cancelled_;
+    };
+    load_watcher_.setFuture(QtConcurrent::run(
+        [file_name, progress]() { return readScoresheet(file_name, progress); }));
+}
+
+void MainWindow::loadFinished() {
+    load_progress_->deleteLater();
+    load_progress_ = nullptr;
+    const std::shared_ptr<LoadedScoresheet> loaded = load_watcher_.result();
+    const QString &file_name = loading_file_;
+
+    if (load_cancelled_) {
+        statusBar()->showMessage(tr("Loading cancelled"));
+        return;
+    }
+    if (!loaded->opened) {
+        QMessageBox::information(this, tr("Unable to open file"),
+                                 loaded->error_message);
+        return;
+    }
+    if (!loaded->success) {
+        QMessageBox::warning(
+            this, tr("Wrong format"),
+            tr("Error while parsing file (%1)").arg(loaded->error_message));
+        return;
+    }
+    if (!loaded->journal_replayed) {
+        QMessageBox::warning(
+            this, tr("Unable to recover changes"),
+            tr("The journal of the scoresheet cannot be replayed (%1), the "
+               "changes will not be journaled until the scoresheet is saved.")
+                .arg(loaded->journal_error));
+    }
+
+    // The loaded content replaces the scoresheet in one step
+    closeJournal();
+    score_model_.load(std::move(loaded->data));
+    current_save_file_ = file_name;
+
+    if (loaded->journal_replayed) {
+        // Recovered changes are merged into the file right away
+        QString error_message;
+        if (loaded->n_records > 0 ? !journal_.save(file_name, &error_message)
+                                  : !journal_.open(file_name, &error_message)) {
+            statusBar()->showMessage(
+                tr("Changes are not journaled (%1)").arg(error_message));
+        } else {
+            QSettings().setValue("journal/file", file_name);
         }
-        QTextStream in(&file);
-        if (!score_model_.loadFromTextStream(in)) {
-            QMessageBox::warning(this, tr("Wrong format"),
-                                 tr("Error while parsing file"));
-            return;
+        if (loaded->n_records > 0) {
+            statusBar()->showMessage(tr("Recovered %n change(s) from the journal",
+                                        "", loaded->n_records));
         }
-        current_save_file_ = load_file;
     }
 }
 
+void MainWindow::loadFromArchive(const QString &file_name) {
+    GameArchive archive;
+    if (!archive.open(file_name)) {
+        QMessageBox::warning(this, tr("Unable to open archive"),
+                             archive.errorString());
+        return;
+    }
+    if (archive.gameCount() == 0) {
+        QMessageBox::information(this, tr("Empty archive"),
+                                 tr("The archive does not hold any game."));
+        return;
+    }
+
+    // Ask which game to load, most recent first
+    QStringList games;
+    for (int game = archive.gameCount() - 1; game >= 0; game--) {
+        games << tr("%1 (%2, %3 turns)")
+                     .arg(archive.gameName(game))
+                     .arg(archive.gameDate(game).toLocalTime().toString(
+                         Qt::ISODate))
+                     .arg(archive.gameTurnCount(game));
+    }
+    bool ok = false;
+    const QString game_item = QInputDialog::getItem(
+        this, tr("Load game"), tr("Game:"), games, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+    const int game = archive.gameCount() - 1 - games.indexOf(game_item);
+
+    closeJournal();
+    if (!score_model_.loadFromArchive(archive, game)) {
+        QMessageBox::warning(this, tr("Wrong format"),
+                             tr("Error while reading game %1 (%2)")
+                                 .arg(archive.gameName(game))
+                                 .arg(archive.game(game).errorString()));
+        return;
+    }
+    // Games are saved to their own scoresheet file
+    current_save_file_ = "";
+}
+
 void MainWindow::testHandSelector() {
     HandDialog dialog(this);
     dialog.exec();
@@ -121,6 +315,7 @@ void MainWindow::testHandSelector() {
 void MainWindow::createActions() {
     /* Create Menus */
     QMenu *fileMenu = menuBar()->addMenu(tr("&File"));
+    QMenu *editMenu = menuBar()->addMenu(tr("&Edit"));
     QMenu *helpMenu = menuBar()->addMenu(tr("&Help"));
 
     /* New Game action */
@@ -165,6 +360,22 @@ void MainWindow::createActions() {
     connect(exitAct, &QAction::triggered, this, &MainWindow::close);
     fileMenu->addAction(exitAct);
 
+    /* Undo action */
+    QAction *undoAct =
+        main_widget_->undoStack()->createUndoAction(this, tr("&Undo"));
+    undoAct->setIcon(QIcon::fromTheme("edit-undo"));
+    undoAct->setShortcuts(QKeySequence::Undo);
+    undoAct->setStatusTip(tr("Undo the last change of the scoresheet"));
+    editMenu->addAction(undoAct);
+
+    /* Redo action */
+    QAction *redoAct =
+        main_widget_->undoStack()->createRedoAction(this, tr("&Redo"));
+    redoAct->setIcon(QIcon::fromTheme("edit-redo"));
+    redoAct->setShortcuts(QKeySequence::Redo);
+    redoAct->setStatusTip(tr("Redo the last undone change of the scoresheet"));
+    editMenu->addAction(redoAct);
+
     /* About action */
     const QIcon aboutIcon = QIcon::fromTheme("help-about");
     QAction *aboutAct = new QAction(aboutIcon, tr("&About"), this);
@@ -182,6 +393,15 @@ void MainWindow::createActions() {
     helpMenu->addAction(howToAct);
 }
 
+void MainWindow::closeJournal() {
+    // Leave a clean scoresheet file behind, without journal to replay
+    autosaver_.cancel();
+    if (journal_.compact()) {
+        QSettings().remove("journal/file");
+    }
+    journal_.close();
+}
+
 bool MainWindow::confirmExit() {
     const QMessageBox::StandardButton ret = QMessageBox::warning(
         this, tr("Exit"), tr("Are you sure you want to exit?"),
@@ -1,8 +1,27 @@
 #pragma once
+#include <QFutureWatcher>
 #include <QMainWindow>
+#include <QProgressDialog>
+#include <atomic>
+#include <memory>
 
+#include "autosaver.hpp"
 #include "mainwidget.hpp"
 #include "scoremodel.hpp"
+#include "scoresheetjournal.hpp"
+
+/**
+ * @brief Scoresheet file read in the background
+ */
+struct LoadedScoresheet {
+    ScoresheetData data;          /**< Content, journal replayed */
+    bool opened = false;          /**< The file could be opened */
+    bool success = false;         /**< The file could be read */
+    QString error_message;        /**< Why the file could not be read */
+    bool journal_replayed = true; /**< The journal, if any, was replayed */
+    int n_records = 0;            /**< Number of replayed journal records */
+    QString journal_error;        /**< Why the journal could not be replayed */
+};
 
 /**
  * @brief Main window of the application
@@ -12,8 +31,20 @@ class MainWindow : public QMainWindow {
     Q_OBJECT
 
   public:
+    /** Display time of the autosave reports in the status bar */
+    static const int AUTOSAVE_MESSAGE_TIMEOUT_MS = 5000;
+    /** Loading time before the progress dialog shows up */
+    static const int LOAD_PROGRESS_DELAY_MS = 500;
+    static const int LOAD_PROGRESS_STEPS = 1000; /**< Progress bar range */
+
     MainWindow();
 
+    /**
+     * @brief Offer to reload the scoresheet that was being edited if the
+     * application did not exit cleanly, replaying its journal
+     */
+    void recoverJournaledFile();
+
   protected:
     /**
      * @brief Override close event in order to ask for confirmation
@@ -48,6 +79,10 @@ class MainWindow : public QMainWindow {
      */
     void load();
     void testHandSelector();
+    /**
+     * @brief Swap the scoresheet read in the background into the model
+     */
+    void loadFinished();
 
   private:
     /**
@@ -62,8 +97,28 @@ class MainWindow : public QMainWindow {
      * @return false if exit cancelled
      */
     bool confirmExit();
+    /**
+     * @brief Ask for a game of an archive file and load it
+     */
+    void loadFromArchive(const QString &file_name);
+    /**
+     * @brief Load a scoresheet file on a worker thread, replaying its journal
+     * if any, with a progress dialog allowing to cancel
+     */
+    void loadFile(const QString &file_name);
+    /**
+     * @brief Merge the journal into the saved scoresheet and stop journaling
+     */
+    void closeJournal();
 
-    ScoreModel score_model_; /**< Scoresheet */
+    ScoreModel score_model_;    /**< Scoresheet */
+    ScoresheetJournal journal_; /**< Journal of the saved scoresheet */
+    AutoSaver autosaver_;       /**< Background rewriting of the saved file */
+    /** Scoresheet file being loaded */
+    QFutureWatcher<std::shared_ptr<LoadedScoresheet>> load_watcher_;
+    QProgressDialog *load_progress_ = nullptr; /**< Loading progress */
+    std::atomic<bool> load_cancelled_{false};  /**< Loading was cancelled */
+    QString loading_file_;                     /**< File being loaded */
     MainWidget *main_widget_;
     QString current_save_file_;
 };
\ No newline at end of file
@@ -0,0 +1,471 @@
+#include "handdictionary.hpp"
+#include "mssparser.hpp"
+
+MssParser::MssParser(const char *begin, const char *end)
+    : begin_(begin), end_(end), cursor_(begin), line_begin_(begin), line_(1) {
+}
+
+void MssParser::setProgressCallback(const ProgressCallback &progress) {
+    progress_ = progress;
+}
+
+bool MssParser::parse(ScoresheetData &data) {
+    /* Read basic information */
+    if (!readInt(data.n_players)) {
+        return false;
+    }
+    if (data.n_players < 3 || data.n_players > 4) {
+        return fail(cursor_, "Number of players must be 3 or 4");
+    }
+    if (!expectEndOfLine()) {
+        return false;
+    }
+
+    /* Read player names, one per line */
+    data.player_names = std::vector<QString>(4, QString());
+    for (int i = 0; i < data.n_players; i++) {
+        const char *name_begin, *name_end;
+        if (!readLine(name_begin, name_end)) {
+            return fail(cursor_, "Missing player name");
+        }
+        data.player_names[i] =
+            QString::fromUtf8(name_begin, static_cast<int>(name_end - name_begin));
+    }
+
+    if (!readInt(data.beginning_score)) {
+        return false;
+    }
+    if (data.beginning_score < 0) {
+        return fail(cursor_, "Beginning score must be positive");
+    }
+    if (!expectEndOfLine()) {
+        return false;
+    }
+
+    /* Read the turn results, one per non-empty line */
+    data.turn_results.clear();
+    int n_turns_to_report = PROGRESS_INTERVAL;
+    while (!atEnd()) {
+        if (progress_ && --n_turns_to_report == 0) {
+            n_turns_to_report = PROGRESS_INTERVAL;
+            if (!progress_(cursor_ - begin_, end_ - begin_)) {
+                return fail(cursor_, "Parsing cancelled");
+            }
+        }
+        skipSpaces();
+        if (atEndOfLine()) {
+            skipEndOfLine();
+            continue;
+        }
+        if (!parseTurn(data.n_players, data.turn_results)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool MssParser::parseFile(QFile &file, ScoresheetData &data,
+                          QString *error_message,
+                          const ProgressCallback &progress) {
+    // Map the file when possible (mapping fails on empty or special files)
+    QByteArray content;
+    const char *begin = nullptr;
+    const qint64 size = file.size();
+    uchar *mapped = size > 0 ? file.map(0, size) : nullptr;
+    if (mapped != nullptr) {
+        begin = reinterpret_cast<const char *>(mapped);
+    } else {
+        content = file.readAll();
+        begin = content.constData();
+    }
+    const char *end = begin + (mapped != nullptr ? size : content.size());
+
+    MssParser parser(begin, end);
+    parser.setProgressCallback(progress);
+    bool success = parser.parse(data);
+    if (!success && error_message != nullptr) {
+        *error_message = parser.errorMessage();
+    }
+
+    if (mapped != nullptr) {
+        file.unmap(mapped);
+    }
+    return success;
+}
+
+bool MssParser::parseTurnResult(int n_players, TurnResult &turn_result) {
+    std::vector<TurnResult> turn_results;
+    if (!parseTurn(n_players, turn_results)) {
+        return false;
+    }
+    if (!atEnd()) {
+        return fail(cursor_, "Unexpected data after turn result");
+    }
+    turn_result = turn_results.back();
+    return true;
+}
+
+const QString &MssParser::errorString() const { return error_string_; }
+int MssParser::errorLine() const { return error_line_; }
+int MssParser::errorColumn() const { return error_column_; }
+QString MssParser::errorMessage() const {
+    return QString("line %1, column %2: %3")
+        .arg(error_line_)
+        .arg(error_column_)
+        .arg(error_string_);
+}
+
+bool MssParser::atEnd() const { return cursor_ == end_; }
+
+bool MssParser::atEndOfLine() const {
+    return cursor_ == end_ || *cursor_ == '\n' || *cursor_ == '\r';
+}
+
+void MssParser::skipSpaces() {
+    while (cursor_ != end_ && (*cursor_ == ' ' || *cursor_ == '\t')) {
+        ++cursor_;
+    }
+}
+
+void MssParser::skipEndOfLine() {
+    if (cursor_ != end_ && *cursor_ == '\r') {
+        ++cursor_;
+    }
+    if (cursor_ != end_ && *cursor_ == '\n') {
+        ++cursor_;
+    }
+    line_++;
+    line_begin_ = cursor_;
+}
+
+bool MssParser::readInt(int &value) {
+    skipSpaces();
+    const char *start = cursor_;
+    bool negative = false;
+    if (cursor_ != end_ && (*cursor_ == '-' || *cursor_ == '+')) {
+        negative = (*cursor_ == '-');
+        ++cursor_;
+    }
+    if (cursor_ == end_ || *cursor_ < '0' || *cursor_ > '9') {
+        return fail(start, "Expected an integer");
+    }
+    long long result = 0;
+    while (cursor_ != end_ && *cursor_ >= '0' && *cursor_ <= '9') {
+        result = result * 10 + (*cursor_ - '0');
+        if (result > 0x7fffffffLL) {
+            return fail(start, "Integer out of range");
+        }
+        ++cursor_;
+    }
+    if (!atEndOfLine() && *cursor_ != ' ' && *cursor_ != '\t') {
+        return fail(cursor_, "Unexpected character in integer");
+    }
+    value = static_cast<int>(negative ? -result : result);
+    return true;
+}
+
+bool MssParser::readToken(const char *&token_begin, const char *&token_end) {
+    skipSpaces();
+    token_begin = cursor_;
+    while (!atEndOfLine() && *cursor_ != ' ' && *cursor_ != '\t') {
+        ++cursor_;
+    }
+    token_end = cursor_;
+    return token_begin != token_end;
+}
+
+bool MssParser::readLine(const char *&line_begin, const char *&line_end) {
+    if (atEnd()) {
+        return false;
+    }
+    line_begin = cursor_;
+    while (!atEndOfLine()) {
+        ++cursor_;
+    }
+    line_end = cursor_;
+    skipEndOfLine();
+    return true;
+}
+
+bool MssParser::expectEndOfLine() {
+    skipSpaces();
+    if (!atEndOfLine()) {
+        return fail(cursor_, "Unexpected data at end of line");
+    }
+    skipEndOfLine();
+    return true;
+}
+
+bool MssParser::fail(const char *position, const QString &message) {
+    if (error_string_.isEmpty()) {
+        error_string_ = message;
+        error_line_ = line_;
+        error_column_ = static_cast<int>(position - line_begin_) + 1;
+    }
+    return false;
+}
+
+bool MssParser::parseTurn(int n_players,
+                          std::vector<TurnResult> &turn_results) {
+    int east_player, winner, ron_victory;
+    if (!readInt(east_player) || !readInt(winner) || !readInt(ron_victory)) {
+        return false;
+    }
+
+    if (ron_victory == 0 || ron_victory == 1) { // Tsumo or ron victory
+        if (east_player < 0 || east_player >= n_players || winner < 0 ||
+            winner >= n_players) {
+            return fail(cursor_, "Player number out of range");
+        }
+        int loser, riichi[4], fu_score, fan_score;
+        if (!readInt(loser) || !readInt(riichi[0]) || !readInt(riichi[1]) ||
+            !readInt(riichi[2])) {
+            return false;
+        }
+        skipSpaces();
+        const char *riichi_4_position = cursor_;
+        if (!readInt(riichi[3]) || !readInt(fu_score) ||
+            !readInt(fan_score)) {
+            return false;
+        }
+        // The loser is only meaningful (and checked) for a ron victory
+        if (ron_victory == 1 && (loser < 0 || loser >= n_players)) {
+            return fail(cursor_, "Loser number out of range");
+        }
+        // A 3-player game has no fourth player to pay a riichi
+        if (n_players < 4 && riichi[3] != 0) {
+            return fail(riichi_4_position, "Riichi of a missing player");
+        }
+
+        const WinningHand *hand = nullptr;
+        const char *hand_begin, *hand_end;
+        if (readToken(hand_begin, hand_end) &&
+            !parseHand(hand_begin, hand_end, riichi[winner] != 0,
+                       ron_victory == 1, hand)) {
+            return false;
+        }
+
+        turn_results.emplace_back(east_player, winner, ron_victory, loser,
+                                  riichi[0] != 0, riichi[1] != 0,
+                                  riichi[2] != 0, riichi[3] != 0, fu_score,
+                                  fan_score, hand);
+    } else if (ron_victory == 2) { // Manual result
+        std::vector<int> scores(n_players, 0);
+        for (int i = 0; i < n_players; i++) {
+            if (!readInt(scores[i])) {
+                return false;
+            }
+        }
+        turn_results.emplace_back(scores, east_player, winner);
+    } else if (ron_victory == 3) { // Draw
+        std::vector<bool> players_tenpai(n_players, false);
+        for (int i = 0; i < n_players; i++) {
+            int tenpai;
+            if (!readInt(tenpai)) {
+                return false;
+            }
+            players_tenpai[i] = (tenpai == 1);
+        }
+        turn_results.emplace_back(players_tenpai, east_player, winner);
+    } else {
+        return fail(cursor_, "Unknown turn outcome");
+    }
+
+    return expectEndOfLine();
+}
+
+bool MssParser::parseHand(const char *begin, const char *end, bool riichi,
+                          bool ron, const WinningHand *&hand) {
+    // Hands repeat across the turns: each description is parsed once
+    HandDictionary &dictionary = HandDictionary::instance();
+    hand = dictionary.findDescription(begin, end, riichi, ron);
+    if (hand != nullptr) {
+        return true;
+    }
+    const char *cursor = begin;
+
+    // The tiles are separated from the other information by a '+'
+    const char *infos = begin;
+    while (infos != end && *infos != '+') {
+        ++infos;
+    }
+    if (infos == end) {
+        return fail(begin, "Missing '+' in hand description");
+    }
+
+    HandType type;
+    ClassicGroup groups[4];
+    Tile tiles[7];
+    int n_groups = 0;
+    bool has_duo = false;
+    if (*cursor == '7') { // Seven pairs: 7P-1s-2s-...
+        type = HandType::PAIRS;
+        if (infos - cursor < 3 || cursor[1] != 'P' || cursor[2] != '-') {
+            return fail(cursor, "Expected seven pairs prefix \"7P-\"");
+        }
+        cursor += 3;
+        for (int i = 0; i < 7; i++) {
+            if (i > 0) {
+                if (cursor == infos || *cursor != '-') {
+                    return fail(cursor, "Expected '-' between pairs");
+                }
+                ++cursor;
+            }
+            if (!parseTile(cursor, infos, tiles[i])) {
+                return false;
+            }
+        }
+    } else if (*cursor == '1') { // Thirteen orphans: 13O-1s
+        type = HandType::ORPHANS;
+        if (infos - cursor < 4 || cursor[1] != '3' || cursor[2] != 'O' ||
+            cursor[3] != '-') {
+            return fail(cursor, "Expected thirteen orphans prefix \"13O-\"");
+        }
+        cursor += 4;
+        if (!parseTile(cursor, infos, tiles[0])) {
+            return false;
+        }
+    } else { // Classic hand: four groups and a duo, separated by '-'
+        type = HandType::CLASSIC;
+        while (cursor != infos) {
+            if (cursor != begin) {
+                if (*cursor != '-') {
+                    return fail(cursor, "Expected '-' between groups");
+                }
+                ++cursor;
+            }
+            if (cursor != infos && *cursor == 'D') {
+                if (has_duo) {
+                    return fail(cursor, "Duplicate duo in hand");
+                }
+                ++cursor;
+                if (!parseTile(cursor, infos, tiles[0])) {
+                    return false;
+                }
+                has_duo = true;
+            } else if (n_groups == 4) {
+                return fail(cursor, "Too many groups in hand");
+            } else if (!parseGroup(cursor, infos, groups[n_groups++])) {
+                return false;
+            }
+        }
+        if (n_groups != 4 || !has_duo) {
+            return fail(begin, "Classic hand needs four groups and a duo");
+        }
+    }
+    if (cursor != infos) {
+        return fail(cursor, "Unexpected data in hand description");
+    }
+
+    /* Other information: +ippatsu-doras-prevailing wind-player wind */
+    cursor = infos + 1;
+    int ippatsu = 0, total_doras = 0;
+    if (cursor == end || (*cursor != '0' && *cursor != '1')) {
+        return fail(cursor, "Expected ippatsu flag");
+    }
+    ippatsu = *cursor++ - '0';
+    if (cursor == end || *cursor++ != '-') {
+        return fail(cursor - 1, "Expected '-' after ippatsu flag");
+    }
+    if (cursor == end || *cursor < '0' || *cursor > '9') {
+        return fail(cursor, "Expected number of doras");
+    }
+    while (cursor != end && *cursor >= '0' && *cursor <= '9') {
+        total_doras = total_doras * 10 + (*cursor++ - '0');
+    }
+    Tile prevailing_wind, player_wind;
+    if (cursor == end || *cursor++ != '-' ||
+        !parseWind(cursor, end, prevailing_wind)) {
+        return fail(cursor - 1, "Expected prevailing wind");
+    }
+    if (cursor == end || *cursor++ != '-' ||
+        !parseWind(cursor, end, player_wind)) {
+        return fail(cursor - 1, "Expected player wind");
+    }
+    if (cursor != end) {
+        return fail(cursor, "Unexpected data at end of hand description");
+    }
+
+    if (type == HandType::CLASSIC) {
+        hand = dictionary.intern(WinningHand(
+            ClassicHand(groups[0], groups[1], groups[2], groups[3], tiles[0]),
+            prevailing_wind, player_wind, riichi, ippatsu != 0, ron,
+            total_doras));
+    } else if (type == HandType::PAIRS) {
+        hand = dictionary.intern(WinningHand(tiles, prevailing_wind,
+                                             player_wind, riichi, ippatsu != 0,
+                                             ron, total_doras));
+    } else {
+        hand = dictionary.intern(WinningHand(tiles[0], prevailing_wind,
+                                             player_wind, riichi, ippatsu != 0,
+                                             ron, total_doras));
+    }
+    dictionary.addDescription(begin, end, riichi, ron, hand);
+    return true;
+}
+
+bool MssParser::parseTile(const char *&cursor, const char *end, Tile &tile) {
+    if (end - cursor < 2 || !Tile::fromString({cursor, 2}, tile)) {
+        return fail(cursor, "Expected a tile (value then suit, e.g. 5p)");
+    }
+    cursor += 2;
+    return true;
+}
+
+bool MssParser::parseWind(const char *&cursor, const char *end, Tile &tile) {
+    // A missing wind is written as an empty string
+    if (cursor == end || *cursor == '-') {
+        tile = Tile();
+        return true;
+    }
+    switch (*cursor) {
+    case 'E':
+        tile = Tile(HONOR, static_cast<int>(HonorValue::EAST));
+        break;
+    case 'S':
+        tile = Tile(HONOR, static_cast<int>(HonorValue::SOUTH));
+        break;
+    case 'W':
+        tile = Tile(HONOR, static_cast<int>(HonorValue::WEST));
+        break;
+    case 'N':
+        tile = Tile(HONOR, static_cast<int>(HonorValue::NORTH));
+        break;
+    default:
+        return false;
+    }
+    ++cursor;
+    return true;
+}
+
+bool MssParser::parseGroup(const char *&cursor, const char *end,
+                           ClassicGroup &group) {
+    if (cursor == end) {
+        return fail(cursor, "Expected a group");
+    }
+    if (*cursor == 'C') {
+        group.type = ClassicGroupType::CHII;
+    } else if (*cursor == 'P') {
+        group.type = ClassicGroupType::PON;
+    } else if (*cursor == 'K') {
+        group.type = ClassicGroupType::KAN;
+    } else {
+        return fail(cursor, "Expected a group type (C, P, K) or a duo (D)");
+    }
+    ++cursor;
+    if (!parseTile(cursor, end, group.tile)) {
+        return false;
+    }
+    group.melded = false;
+    group.ron_meld = false;
+    if (cursor != end && *cursor == '"') {
+        group.melded = true;
+        group.ron_meld = true;
+        ++cursor;
+    } else if (cursor != end && *cursor == '\'') {
+        group.melded = true;
+        ++cursor;
+    }
+    return true;
+}
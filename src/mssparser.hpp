@@ -0,0 +1,97 @@
+#pragma once
+#include <QFile>
+#include <QString>
+
+#include "scoresheetdata.hpp"
+#include "winning_hand.hpp"
+
+/**
+ * @brief Tokenizer-based reader for the text scoresheet format (.mss)
+ *
+ * The parser works directly on a byte buffer (UTF-8 text), without building
+ * intermediate strings or streams: integers and tiles are decoded in place
+ * and turns and hands are built directly from the tokens. On error, the
+ * position of the faulty token is reported.
+ */
+class MssParser {
+  public:
+    /** Number of turns parsed between two progress reports */
+    static const int PROGRESS_INTERVAL = 4096;
+
+    /**
+     * @brief Construct a parser over the bytes in [begin, end)
+     */
+    MssParser(const char *begin, const char *end);
+
+    /**
+     * @brief Report the number of bytes parsed while parsing turns, parsing
+     * fails if the callback returns false
+     */
+    void setProgressCallback(const ProgressCallback &progress);
+
+    /**
+     * @brief Parse a whole scoresheet
+     *
+     * @return true if parsing didn't encounter any errors
+     * @return false otherwise, see errorString(), errorLine() and
+     * errorColumn()
+     */
+    bool parse(ScoresheetData &data);
+
+    /**
+     * @brief Read a whole opened scoresheet file, mapping it in memory if
+     * possible
+     *
+     * @param error_message if not null, receives a description of the error
+     * @return true if parsing succeeded
+     */
+    static bool parseFile(QFile &file, ScoresheetData &data,
+                          QString *error_message = nullptr,
+                          const ProgressCallback &progress = nullptr);
+
+    /**
+     * @brief Parse a single turn result line (as written by
+     * TurnResult::writeToTextStream) spanning the whole buffer
+     */
+    bool parseTurnResult(int n_players, TurnResult &turn_result);
+
+    /* Error information */
+    const QString &errorString() const;
+    int errorLine() const;
+    int errorColumn() const;
+    /**
+     * @brief Error formatted as "line L, column C: message"
+     */
+    QString errorMessage() const;
+
+  private:
+    /* Low level tokenizer */
+    bool atEnd() const;
+    bool atEndOfLine() const;
+    void skipSpaces();
+    void skipEndOfLine();
+    bool readInt(int &value);
+    bool readToken(const char *&token_begin, const char *&token_end);
+    bool readLine(const char *&line_begin, const char *&line_end);
+    bool expectEndOfLine();
+    bool fail(const char *position, const QString &message);
+
+    /* Grammar */
+    bool parseTurn(int n_players, std::vector<TurnResult> &turn_results);
+    bool parseHand(const char *begin, const char *end, bool riichi, bool ron,
+                   const WinningHand *&hand);
+    bool parseTile(const char *&cursor, const char *end, Tile &tile);
+    bool parseWind(const char *&cursor, const char *end, Tile &tile);
+    bool parseGroup(const char *&cursor, const char *end,
+                    ClassicGroup &group);
+
+    const char *begin_;       /**< Beginning of the buffer */
+    const char *end_;         /**< End of the buffer */
+    const char *cursor_;      /**< Current position in the buffer */
+    const char *line_begin_;  /**< Beginning of the current line */
+    int line_;                /**< Current line number (1-based) */
+    QString error_string_;    /**< Description of the first error */
+    int error_line_ = 0;      /**< Line of the first error */
+    int error_column_ = 0;    /**< Column of the first error */
+    ProgressCallback progress_; /**< Progress report, may be empty */
+};
@@ -0,0 +1,119 @@
+#include <QFile>
+#include <QSaveFile>
+
+#include "playerregistry.hpp"
+
+bool PlayerRegistry::load(const QString &file_name, QString *error_message) {
+    file_name_ = file_name;
+    names_.clear();
+    ids_.clear();
+    modified_ = false;
+
+    QFile file(file_name);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    const QStringList lines = QString::fromUtf8(file.readAll()).split('\n');
+    for (int i = 0; i < lines.size(); i++) {
+        // Names are kept as saved (spaces included), only the end of line of
+        // a file edited on Windows is dropped
+        QString line = lines[i];
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        if (line.isEmpty()) {
+            continue;
+        }
+        const QStringList names = line.split('\t');
+        const int player = static_cast<int>(names_.size());
+        bool success = !names[0].isEmpty() && find(names[0]) < 0;
+        if (success) {
+            names_.push_back(QStringList() << names[0]);
+            ids_.insert(names[0], player);
+        }
+        for (int alias = 1; success && alias < names.size(); alias++) {
+            success = addAlias(player, names[alias]);
+        }
+        if (!success) {
+            if (error_message != nullptr) {
+                *error_message =
+                    QString("Empty or duplicate player name on line %1")
+                        .arg(i + 1);
+            }
+            names_.clear();
+            ids_.clear();
+            return false;
+        }
+    }
+    // Loading adds no player
+    modified_ = false;
+    return true;
+}
+
+bool PlayerRegistry::save(QString *error_message) {
+    if (!modified_) {
+        return true;
+    }
+    QByteArray content;
+    for (const QStringList &names : names_) {
+        content.append(names.join('\t').toUtf8()).append('\n');
+    }
+    QSaveFile file(file_name_);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(content) != content.size() || !file.commit()) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    modified_ = false;
+    return true;
+}
+
+int PlayerRegistry::find(const QString &name) const {
+    return ids_.value(name, -1);
+}
+
+int PlayerRegistry::id(const QString &name) {
+    auto player = ids_.find(name);
+    if (player != ids_.end()) {
+        return player.value();
+    }
+    // The separators of the file can't be part of a saved name: a name
+    // containing them is the player of its saved form, if already known
+    QString saved_name = name;
+    saved_name.replace('\t', ' ').replace('\n', ' ').replace('\r', ' ');
+    int player_id = find(saved_name);
+    if (player_id < 0) {
+        player_id = static_cast<int>(names_.size());
+        names_.push_back(QStringList() << saved_name);
+        ids_.insert(saved_name, player_id);
+        modified_ = true;
+    }
+    ids_.insert(name, player_id);
+    return player_id;
+}
+
+const QString &PlayerRegistry::name(int id) const { return names_[id][0]; }
+
+bool PlayerRegistry::addAlias(int id, const QString &alias,
+                              QString *error_message) {
+    if (alias.isEmpty() || find(alias) >= 0) {
+        if (error_message != nullptr) {
+            *error_message = "Empty or duplicate player name " + alias;
+        }
+        return false;
+    }
+    names_[id] << alias;
+    ids_.insert(alias, id);
+    modified_ = true;
+    return true;
+}
+
+int PlayerRegistry::count() const { return static_cast<int>(names_.size()); }
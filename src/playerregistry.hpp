@@ -0,0 +1,62 @@
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+/**
+ * @brief Registry of the players, giving each one an integer id across games
+ *
+ * A player is known by a name, and possibly by aliases (typos, former
+ * names): all of them resolve to the same id, so that the games recorded
+ * under any of them are counted together. Ids are dense, numbered from 0 in
+ * registration order, so that they can index flat arrays.
+ *
+ * The registry file is a UTF-8 text file, with one line per player in id
+ * order: the name of the player, then its aliases, separated by tabs. Names
+ * are saved as given, spaces included, except for the tabs and line breaks
+ * they contain, which become spaces. Two players are merged by moving the
+ * names of one line to the end of the other and removing it; the merge
+ * applies from the next run on, without parsing the scoresheets again.
+ */
+class PlayerRegistry {
+  public:
+    /**
+     * @brief Load the registry file, a missing file being an empty registry
+     *
+     * @return false if the file can't be read, or names a player twice (the
+     * registry is then empty, and should not be saved over the file)
+     */
+    bool load(const QString &file_name, QString *error_message = nullptr);
+    /**
+     * @brief Replace the registry file atomically, if players were added
+     */
+    bool save(QString *error_message = nullptr);
+
+    /**
+     * @brief Id of a name or an alias, or -1 if it is not registered
+     */
+    int find(const QString &name) const;
+    /**
+     * @brief Id of a name or an alias, registering a new player if needed
+     */
+    int id(const QString &name);
+    /**
+     * @brief Name of a player (not one of its aliases)
+     */
+    const QString &name(int id) const;
+    /**
+     * @brief Add an alias of a player
+     *
+     * @return false if the alias already names a player
+     */
+    bool addAlias(int id, const QString &alias,
+                  QString *error_message = nullptr);
+    int count() const;
+
+  private:
+    QString file_name_;              /**< Registry file */
+    std::vector<QStringList> names_; /**< Name then aliases of each player */
+    QHash<QString, int> ids_;        /**< Id of each name and alias */
+    bool modified_ = false;          /**< Whether a player was added */
+};
@@ -0,0 +1,168 @@
+#include <QCryptographicHash>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+#include "resultcache.hpp"
+
+static const int KEY_SIZE = 20;
+
+bool ResultCache::load(const QString &file_name, QString *error_message) {
+    file_name_ = file_name;
+    entries_.clear();
+    run_ = 1;
+    modified_ = false;
+
+    QFile file(file_name);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    const QByteArray content = file.readAll();
+    if (content.isEmpty()) {
+        return true;
+    }
+    const char *cursor = content.constData();
+    const char *end = cursor + content.size();
+
+    MsscHeader header;
+    if (end - cursor < static_cast<qint64>(sizeof(MsscHeader))) {
+        if (error_message != nullptr) {
+            *error_message = "Truncated cache index";
+        }
+        return false;
+    }
+    std::memcpy(&header, cursor, sizeof(MsscHeader));
+    cursor += sizeof(MsscHeader);
+    if (std::memcmp(header.magic, MSSC_MAGIC, sizeof(MSSC_MAGIC)) != 0 ||
+        qFromLittleEndian(header.version) != MSSC_VERSION) {
+        if (error_message != nullptr) {
+            *error_message = "Not a cache index, or unsupported version";
+        }
+        return false;
+    }
+    // Results of another engine are all stale
+    run_ = qFromLittleEndian(header.run) + 1;
+    if (qFromLittleEndian(header.engine_version) != ENGINE_VERSION) {
+        modified_ = true;
+        return true;
+    }
+
+    const quint32 n_entries = qFromLittleEndian(header.n_entries);
+    // The count of a corrupted index can't reserve more than the file holds
+    entries_.reserve(static_cast<int>(
+        std::min<qint64>(n_entries, (end - cursor) / (KEY_SIZE + 8))));
+    for (quint32 i = 0; i < n_entries; i++) {
+        if (end - cursor < KEY_SIZE + 8) {
+            break;
+        }
+        const QByteArray key(cursor, KEY_SIZE);
+        cursor += KEY_SIZE;
+        Entry entry;
+        entry.last_run = qFromLittleEndian<quint32>(cursor);
+        const quint32 size = qFromLittleEndian<quint32>(cursor + 4);
+        cursor += 8;
+        if (static_cast<quint64>(end - cursor) < size) {
+            break;
+        }
+        entry.result = QByteArray(cursor, size);
+        cursor += size;
+        entries_.insert(key, entry);
+    }
+    if (cursor != end) {
+        // Truncated index: keep the entries read so far, it is rewritten on
+        // save
+        modified_ = true;
+    }
+    return true;
+}
+
+bool ResultCache::save(QString *error_message) {
+    // Drop the entries that have not been used for a while
+    for (auto entry = entries_.begin(); entry != entries_.end();) {
+        if (run_ - entry.value().last_run >= MAX_IDLE_RUNS) {
+            entry = entries_.erase(entry);
+            modified_ = true;
+        } else {
+            ++entry;
+        }
+    }
+    if (!modified_) {
+        return true;
+    }
+
+    QSaveFile file(file_name_);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    MsscHeader header;
+    std::memcpy(header.magic, MSSC_MAGIC, sizeof(MSSC_MAGIC));
+    header.version = qToLittleEndian(MSSC_VERSION);
+    header.reserved = 0;
+    header.engine_version = qToLittleEndian(ENGINE_VERSION);
+    header.run = qToLittleEndian(run_);
+    header.n_entries = qToLittleEndian<quint32>(entries_.size());
+    QByteArray content(reinterpret_cast<const char *>(&header),
+                       sizeof(MsscHeader));
+    for (auto entry = entries_.constBegin(); entry != entries_.constEnd();
+         ++entry) {
+        char sizes[8];
+        qToLittleEndian<quint32>(entry.value().last_run, sizes);
+        qToLittleEndian<quint32>(entry.value().result.size(), sizes + 4);
+        content.append(entry.key())
+            .append(sizes, sizeof(sizes))
+            .append(entry.value().result);
+    }
+    if (file.write(content) != content.size() || !file.commit()) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    modified_ = false;
+    return true;
+}
+
+QByteArray ResultCache::key(const QByteArray &kind,
+                            const QByteArray &content) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(kind);
+    hash.addData("\0", 1);
+    hash.addData(content);
+    return hash.result();
+}
+
+bool ResultCache::find(const QByteArray &key, QByteArray &result) const {
+    const auto entry = entries_.constFind(key);
+    if (entry == entries_.constEnd()) {
+        return false;
+    }
+    result = entry.value().result;
+    return true;
+}
+
+void ResultCache::use(const QByteArray &key) {
+    // An entry is only refreshed once halfway to being dropped, so that a
+    // run using the entries of the previous runs leaves the index as is
+    auto entry = entries_.find(key);
+    if (entry != entries_.end() &&
+        run_ - entry.value().last_run >= MAX_IDLE_RUNS / 2) {
+        entry.value().last_run = run_;
+        modified_ = true;
+    }
+}
+
+void ResultCache::insert(const QByteArray &key, const QByteArray &result) {
+    entries_.insert(key, Entry{run_, result});
+    modified_ = true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+
+/*
+ * Result cache index format (.msscache), version 1
+ *
+ * All integers are little-endian. The file is made of a fixed-size header
+ * (MsscHeader) followed by n_entries entries, each one made of:
+ *  - the 20-byte key (SHA-1 of the kind of result and of the scoresheet
+ *    content)
+ *  - the 32-bit number of the last run that used the entry
+ *  - the 32-bit size of the result, followed by the result bytes
+ */
+
+static const char MSSC_MAGIC[4] = {'M', 'S', 'S', 'C'};
+static const quint16 MSSC_VERSION = 1;
+
+/**
+ * @brief Header of a result cache index
+ */
+struct MsscHeader {
+    char magic[4];          /**< "MSSC" */
+    quint16 version;        /**< Format version */
+    quint16 reserved;       /**< Always 0 */
+    quint32 engine_version; /**< ResultCache::ENGINE_VERSION of the results */
+    quint32 run;            /**< Number of the last run */
+    quint32 n_entries;      /**< Number of entries */
+};
+static_assert(sizeof(MsscHeader) == 20, "Unexpected MsscHeader layout");
+
+/**
+ * @brief Cache of the results computed from scoresheets (analyses,
+ * statistics summaries), stored in a single index file
+ *
+ * Results are keyed by the hash of the scoresheet content, so an edited
+ * scoresheet never gets the results of its previous content. The whole
+ * cache is dropped when the engine version changes, and the entries which
+ * have not been used for MAX_IDLE_RUNS runs are dropped when saving. Only
+ * the runs which rewrite the index (to add, refresh or drop entries) are
+ * counted, so that a run computing nothing new costs no write.
+ *
+ * find() may be called from several threads at once, as long as no entry is
+ * inserted or used meanwhile.
+ */
+class ResultCache {
+  public:
+    /** Version of the scoring rules and of the result formats, to be bumped
+     * whenever they change */
+    static const quint32 ENGINE_VERSION = 2;
+    /** Number of runs after which an unused entry is dropped */
+    static const quint32 MAX_IDLE_RUNS = 16;
+
+    /**
+     * @brief Load the index file, a missing file being an empty cache
+     *
+     * @return false if the file can't be read or is not a cache index (the
+     * cache is then empty, and should not be saved over the file)
+     */
+    bool load(const QString &file_name, QString *error_message = nullptr);
+    /**
+     * @brief Replace the index file atomically, if any entry changed
+     */
+    bool save(QString *error_message = nullptr);
+
+    /**
+     * @brief Key of a kind of result (e.g. an analysis format) computed from
+     * the given scoresheet content
+     */
+    static QByteArray key(const QByteArray &kind, const QByteArray &content);
+
+    /**
+     * @brief Look up a result
+     *
+     * @return false if the result is not cached
+     */
+    bool find(const QByteArray &key, QByteArray &result) const;
+    /**
+     * @brief Mark a cached result as used by this run
+     *
+     * The use is only recorded (and the index rewritten) once the entry is
+     * halfway to MAX_IDLE_RUNS.
+     */
+    void use(const QByteArray &key);
+    /**
+     * @brief Add a result computed by this run
+     */
+    void insert(const QByteArray &key, const QByteArray &result);
+
+  private:
+    struct Entry {
+        quint32 last_run; /**< Number of the last run that used the entry */
+        QByteArray result;
+    };
+
+    QString file_name_;                /**< Index file */
+    quint32 run_ = 1;                  /**< Number of the current run */
+    QHash<QByteArray, Entry> entries_; /**< Results by key */
+    bool modified_ = false;            /**< Whether an entry changed */
+};
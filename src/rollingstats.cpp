@@ -0,0 +1,149 @@
+#include "analysiswriter.hpp"
+#include "rollingstats.hpp"
+
+static const char TEXT_HEADER[] =
+    "session\tplayer\tsessions\tturns\tmean_gain\ttsumo_rate\tron_rate\t"
+    "mean_hand_value\n";
+
+double RollingStats::Measures::meanGain() const {
+    return n_turns > 0 ? static_cast<double>(gain_sum) / n_turns : 0;
+}
+
+double RollingStats::Measures::tsumoRate() const {
+    return n_turns > 0 ? static_cast<double>(tsumos) / n_turns : 0;
+}
+
+double RollingStats::Measures::ronRate() const {
+    return n_turns > 0 ? static_cast<double>(rons) / n_turns : 0;
+}
+
+double RollingStats::Measures::meanHandValue() const {
+    return tsumos + rons > 0
+               ? static_cast<double>(hand_value_sum) / (tsumos + rons)
+               : 0;
+}
+
+RollingStats::RollingStats(Unit unit, int size, PlayerRegistry *registry)
+    : unit_(unit), size_(size), registry_(registry) {}
+
+PlayerRegistry &RollingStats::registry() {
+    return registry_ != nullptr ? *registry_ : own_registry_;
+}
+
+const PlayerRegistry &RollingStats::registry() const {
+    return registry_ != nullptr ? *registry_ : own_registry_;
+}
+
+bool RollingStats::isFull(const Window &window) const {
+    if (unit_ == Unit::SESSIONS) {
+        return window.sums.n_sessions > size_;
+    }
+    // The window keeps enough sessions to hold size_ turns
+    return window.sessions.size() > 1 &&
+           window.sums.n_turns - window.sessions.front().n_turns >= size_;
+}
+
+void RollingStats::addSession(const SeasonStats::Session &session) {
+    n_sessions_++;
+    last_players_.clear();
+    for (size_t i = 0; i < session.players.size(); i++) {
+        const SeasonStats::PlayerSession &player = session.players[i];
+        const int id = registry().id(session.player_names[i]);
+        if (id >= static_cast<int>(windows_.size())) {
+            windows_.resize(registry().count());
+        }
+        if (player.n_turns == 0) {
+            // The player did not play this session
+            continue;
+        }
+        last_players_.push_back(id);
+
+        Window &window = windows_[id];
+        window.sessions.push_back(player);
+        window.sums.n_sessions++;
+        window.sums.n_turns += player.n_turns;
+        window.sums.gain_sum += player.gain_sum;
+        window.sums.tsumos += player.tsumos;
+        window.sums.rons += player.rons;
+        window.sums.hand_value_sum += player.hand_value_sum;
+        while (isFull(window)) {
+            const SeasonStats::PlayerSession &oldest = window.sessions.front();
+            window.sums.n_sessions--;
+            window.sums.n_turns -= oldest.n_turns;
+            window.sums.gain_sum -= oldest.gain_sum;
+            window.sums.tsumos -= oldest.tsumos;
+            window.sums.rons -= oldest.rons;
+            window.sums.hand_value_sum -= oldest.hand_value_sum;
+            window.sessions.pop_front();
+        }
+    }
+}
+
+int RollingStats::sessionCount() const { return n_sessions_; }
+
+const RollingStats::Measures &RollingStats::measures(int id) const {
+    return windows_[id].sums;
+}
+
+void RollingStats::writeTextHeader(QByteArray &out) { out.append(TEXT_HEADER); }
+
+void RollingStats::writeLastSession(bool json, QByteArray &out) const {
+    if (json) {
+        out.append("{\"session\":")
+            .append(QByteArray::number(n_sessions_))
+            .append(",\"players\":[");
+    }
+    for (size_t i = 0; i < last_players_.size(); i++) {
+        const int id = last_players_[i];
+        const Measures &window = measures(id);
+        const QByteArray name = registry().name(id).toUtf8();
+        const QByteArray mean_gain =
+            QByteArray::number(window.meanGain(), 'f', 2);
+        const QByteArray tsumo_rate =
+            QByteArray::number(window.tsumoRate(), 'f', 4);
+        const QByteArray ron_rate =
+            QByteArray::number(window.ronRate(), 'f', 4);
+        const QByteArray mean_hand_value =
+            QByteArray::number(window.meanHandValue(), 'f', 2);
+        if (!json) {
+            out.append(QByteArray::number(n_sessions_))
+                .append('\t')
+                .append(name)
+                .append('\t')
+                .append(QByteArray::number(window.n_sessions))
+                .append('\t')
+                .append(QByteArray::number(window.n_turns))
+                .append('\t')
+                .append(mean_gain)
+                .append('\t')
+                .append(tsumo_rate)
+                .append('\t')
+                .append(ron_rate)
+                .append('\t')
+                .append(mean_hand_value)
+                .append('\n');
+            continue;
+        }
+        if (i > 0) {
+            out.append(',');
+        }
+        out.append("{\"name\":");
+        AnalysisWriter::appendJsonString(out, name);
+        out.append(",\"sessions\":")
+            .append(QByteArray::number(window.n_sessions))
+            .append(",\"turns\":")
+            .append(QByteArray::number(window.n_turns))
+            .append(",\"mean_gain\":")
+            .append(mean_gain)
+            .append(",\"tsumo_rate\":")
+            .append(tsumo_rate)
+            .append(",\"ron_rate\":")
+            .append(ron_rate)
+            .append(",\"mean_hand_value\":")
+            .append(mean_hand_value)
+            .append('}');
+    }
+    if (json) {
+        out.append("]}\n");
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <deque>
+#include <vector>
+
+#include "playerregistry.hpp"
+#include "seasonstats.hpp"
+
+/**
+ * @brief Statistics of the players over a sliding window of their last
+ * sessions or turns, for trend lines over a season
+ *
+ * The sessions are added in chronological order. Each player keeps the
+ * sessions of its window and their sums: adding a session adds its results
+ * to the sums of its players, and subtracts the results of the sessions
+ * leaving their windows. Each session enters and leaves a window once, so
+ * that adding a session costs O(1) per player however large the windows.
+ *
+ * A window of turns is made of the last sessions of the player which hold
+ * at least the given number of turns (sessions are not split).
+ */
+class RollingStats {
+  public:
+    enum class Unit { SESSIONS, TURNS };
+
+    /**
+     * @brief Measures of a player over its window
+     */
+    struct Measures {
+        int n_sessions = 0; /**< Number of sessions in the window */
+        int n_turns = 0;
+        qint64 gain_sum = 0;
+        int tsumos = 0;
+        int rons = 0;
+        qint64 hand_value_sum = 0;
+
+        double meanGain() const;
+        double tsumoRate() const; /**< Tsumo victories per turn */
+        double ronRate() const;   /**< Ron victories per turn */
+        double meanHandValue() const; /**< Points per victory */
+    };
+
+    /**
+     * @param size number of sessions or of turns of the windows
+     * @param registry resolves the player names and receives the new
+     * players; if null, each name is a distinct player
+     */
+    RollingStats(Unit unit, int size, PlayerRegistry *registry = nullptr);
+
+    /**
+     * @brief Add the next session, sliding the windows of its players
+     */
+    void addSession(const SeasonStats::Session &session);
+    int sessionCount() const;
+
+    /**
+     * @brief Measures of a player (by registry id) over its current window
+     */
+    const Measures &measures(int id) const;
+
+    /**
+     * @brief Write the measures of the players of the last session, one
+     * tab-separated line per player (after writeTextHeader()) or a single
+     * line of JSON
+     */
+    void writeLastSession(bool json, QByteArray &out) const;
+    static void writeTextHeader(QByteArray &out);
+
+  private:
+    /**
+     * @brief Window of a player: its sessions, oldest first, and their sums
+     */
+    struct Window {
+        std::deque<SeasonStats::PlayerSession> sessions;
+        Measures sums;
+    };
+
+    PlayerRegistry &registry();
+    const PlayerRegistry &registry() const;
+    /**
+     * @brief Whether the oldest session of a window leaves it
+     */
+    bool isFull(const Window &window) const;
+
+    Unit unit_;
+    int size_;
+    PlayerRegistry *registry_;   /**< Registry given, may be null */
+    PlayerRegistry own_registry_; /**< Registry used if none is given */
+    std::vector<Window> windows_; /**< Window of each registry id */
+    std::vector<int> last_players_; /**< Ids of the last session's players */
+    int n_sessions_ = 0;
+};
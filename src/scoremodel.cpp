@@ -1,4 +1,5 @@
 #include "scoremodel.hpp"
+#include "mssparser.hpp"
 #include <QBrush>
 #include <QColor>
 #include <iostream>
@@ -7,9 +8,8 @@ ScoreModel::ScoreModel(QObject *parent, N_Players _n_players,
                        int beginning_score, QString name_player_1,
                        QString name_player_2, QString name_player_3,
                        QString name_player_4)
-    : QAbstractTableModel(parent), n_players_(_n_players) {
-    scores_.push_back(
-        std::vector<int>(static_cast<int>(n_players_), beginning_score));
+    : QAbstractTableModel(parent), n_players_(_n_players),
+      score_table_(static_cast<int>(_n_players), beginning_score) {
     player_names_ = std::vector<QString>(4, QString());
     player_names_[0] = name_player_1;
     player_names_[1] = name_player_2;
@@ -18,49 +18,40 @@ ScoreModel::ScoreModel(QObject *parent, N_Players _n_players,
 }
 
 int ScoreModel::rowCount(const QModelIndex & /* parent */) const {
-    return scores_.size();
+    return score_table_.rowCount();
 }
 
 int ScoreModel::columnCount(const QModelIndex & /* parent */) const {
-    return scores_[0].size();
+    return static_cast<int>(n_players_);
 }
 
 QVariant ScoreModel::data(const QModelIndex &index, int role) const {
     if (role == Qt::DisplayRole) {
         QString cell_content;
         // Add positive or negative value change from the turn before
-        if (index.column() < static_cast<int>(scores_[0].size())) {
-            cell_content +=
-                QString("%1").arg(scores_[index.row()][index.column()]);
-            if (index.row() > 0 &&
-                scores_[index.row()][index.column()] <
-                    scores_[index.row() - 1][index.column()]) {
+        if (index.column() < columnCount()) {
+            cell_content += QString("%1").arg(score(index.row(), index.column()));
+            if (index.row() > 0 && score(index.row(), index.column()) <
+                                       score(index.row() - 1, index.column())) {
                 cell_content += QString(" (-%2)").arg(
-                    scores_[index.row() - 1][index.column()] -
-                    scores_[index.row()][index.column()]);
+                    score(index.row() - 1, index.column()) -
+                    score(index.row(), index.column()));
             } else if (index.row() > 0 &&
-                       scores_[index.row()][index.column()] >
-                           scores_[index.row() - 1][index.column()]) {
+                       score(index.row(), index.column()) >
+                           score(index.row() - 1, index.column())) {
                 cell_content += QString(" (+%2)").arg(
-                    scores_[index.row()][index.column()] -
-                    scores_[index.row() - 1][index.column()]);
+                    score(index.row(), index.column()) -
+                    score(index.row() - 1, index.column()));
             }
-        } /* else {
-             int sum = 0;
-             for (unsigned j = 0; j < scores_[0].size(); j++) {
-                 sum += scores_[index.row()][j];
-             }
-             cell_content = QString("%1").arg(sum);
-         }*/
+        }
         return cell_content;
     } else if (role == Qt::BackgroundRole) {
-        if (index.row() > 0 &&
-            index.column() < static_cast<int>(scores_[0].size())) {
-            if (scores_[index.row()][index.column()] <
-                scores_[index.row() - 1][index.column()]) {
+        if (index.row() > 0 && index.column() < columnCount()) {
+            if (score(index.row(), index.column()) <
+                score(index.row() - 1, index.column())) {
                 return QBrush(QColor(255, 84, 82, 190));
-            } else if (scores_[index.row()][index.column()] >
-                       scores_[index.row() - 1][index.column()]) {
+            } else if (score(index.row(), index.column()) >
+                       score(index.row() - 1, index.column())) {
                 return QBrush(QColor(82, 255, 99, 190));
             }
         }
@@ -73,7 +64,7 @@ QVariant ScoreModel::headerData(int section, Qt::Orientation orientation,
                                 int role) const {
     if (role == Qt::DisplayRole) {
         if (orientation == Qt::Horizontal) {
-            if (section == static_cast<int>(scores_[0].size())) {
+            if (section == columnCount()) {
                 return QString(tr("Total"));
             } else {
                 return QString("%1").arg(player_names_[section]);
@@ -95,31 +86,55 @@ const std::vector<QString> &ScoreModel::PlayerNames() const {
     return player_names_;
 }
 const std::vector<TurnResult> &ScoreModel::turnResults() const {
-    return turn_results_;
+    return score_table_.turnResults();
 }
 
 void ScoreModel::addTurnResult(const TurnResult &turn_result) {
-    turn_results_.push_back(turn_result);
-    recomputeScores();
+    insertTurnResult(score_table_.turnResults().size(), turn_result);
+}
+
+void ScoreModel::insertTurnResult(int turn_index,
+                                  const TurnResult &turn_result) {
+    // The new turn is displayed on row turn_index + 1
+    beginInsertRows(QModelIndex(), turn_index + 1, turn_index + 1);
+    score_table_.insertTurnResult(turn_index, turn_result);
+    endInsertRows();
+
+    // Following turns are shifted by the score change of the new turn
+    notifyScoresChanged(turn_index + 2);
+    emit turnResultInserted(turn_index);
+}
+
+void ScoreModel::replaceTurnResult(int turn_index,
+                                   const TurnResult &turn_result) {
+    score_table_.replaceTurnResult(turn_index, turn_result);
+    notifyScoresChanged(turn_index + 1);
+    emit turnResultReplaced(turn_index);
+}
+
+void ScoreModel::appendTurnResults(std::vector<TurnResult> &&turn_results) {
+    appendTurnResults(std::make_move_iterator(turn_results.begin()),
+                      std::make_move_iterator(turn_results.end()));
+    turn_results.clear();
 }
 
 void ScoreModel::deleteTurnResult(int turn_index) {
-    turn_results_.erase(turn_results_.begin() + turn_index);
-    recomputeScores();
+    beginRemoveRows(QModelIndex(), turn_index + 1, turn_index + 1);
+    score_table_.deleteTurnResult(turn_index);
+    endRemoveRows();
+
+    // Following turns no longer include the score change of the deleted turn
+    notifyScoresChanged(turn_index + 1);
+    emit turnResultDeleted(turn_index);
 }
 
 void ScoreModel::reset(N_Players _n_players, int beginning_score,
                        const std::vector<QString> &_player_names) {
-    // Empty turns and scores
-    turn_results_.clear();
-    scores_.clear();
+    beginResetModel();
 
-    // Change number of players
+    // Change number of players, empty turns and initialize scores
     n_players_ = _n_players;
-
-    // Initialize scores
-    scores_.push_back(
-        std::vector<int>(static_cast<int>(n_players_), beginning_score));
+    score_table_.reset(static_cast<int>(n_players_), beginning_score);
 
     // Change player names
     player_names_[0] = _player_names[0];
@@ -129,92 +144,79 @@ void ScoreModel::reset(N_Players _n_players, int beginning_score,
         player_names_[3] = _player_names[3];
     }
 
-    emit layoutChanged();
+    endResetModel();
+}
+
+ScoresheetData ScoreModel::toScoresheetData() const {
+    ScoresheetData data;
+    data.n_players = static_cast<int>(n_players_);
+    data.player_names = player_names_;
+    data.beginning_score = score_table_.beginningScore();
+    data.turn_results = score_table_.turnResults();
+    return data;
 }
 
 void ScoreModel::writeToTextStream(QTextStream &out) const {
-    out << static_cast<int>(n_players_) << "\n"
-        << player_names_[0] << "\n"
-        << player_names_[1] << "\n"
-        << player_names_[2] << "\n";
-    if (n_players_ == N_Players::FOUR_PLAYERS) {
-        out << player_names_[3] << "\n";
-    }
-    out << scores_[0][0] << "\n";
-    for (unsigned i = 0; i < turn_results_.size(); ++i) {
-        turn_results_[i].writeToTextStream(out);
-        out << "\n";
-    }
+    toScoresheetData().writeToTextStream(out);
 }
 
 bool ScoreModel::loadFromTextStream(QTextStream &in) {
-    /* Read basic information */
-    int read_n_players = 0;
-    in >> read_n_players;
-    if (read_n_players < 3 || read_n_players > 4) {
-        return false;
-    }
-    QString line;
-    std::vector<QString> player_names =
-        std::vector<QString>(read_n_players, "");
-    // End reading first line
-    in.readLineInto(&line);
-    /* Read player names  */
-    if (!in.readLineInto(&line)) {
+    QByteArray content = in.readAll().toUtf8();
+    ScoresheetData data;
+    MssParser parser(content.constData(),
+                     content.constData() + content.size());
+    if (!parser.parse(data)) {
         return false;
     }
-    player_names[0] = line;
-    if (!in.readLineInto(&line)) {
-        return false;
-    }
-    player_names[1] = line;
-    if (!in.readLineInto(&line)) {
-        return false;
-    }
-    player_names[2] = line;
-    if (read_n_players > 3) {
-        if (!in.readLineInto(&line)) {
-            return false;
-        }
-        player_names[3] = line;
+    load(std::move(data));
+    return true;
+}
+
+void ScoreModel::load(ScoresheetData &&data) {
+    // The views see a single reset, from the old content to the new one
+    beginResetModel();
+    n_players_ = static_cast<N_Players>(data.n_players);
+    for (int i = 0; i < data.n_players; i++) {
+        player_names_[i] = data.player_names[i];
     }
-    int beginning_score;
-    in >> beginning_score;
-    if (beginning_score < 0) {
+    score_table_.assign(data.n_players, data.beginning_score,
+                        std::move(data.turn_results));
+    endResetModel();
+}
+
+bool ScoreModel::loadFromArchive(const GameArchive &archive, int game) {
+    const BinaryScoresheet scoresheet = archive.game(game);
+    if (!scoresheet.isValid()) {
         return false;
     }
-    // Read end of line with beginning score
-    in.readLineInto(&line);
 
     /* Reset the scoresheet */
-    reset(static_cast<N_Players>(read_n_players), beginning_score,
-          player_names);
-
-    /* Read the turn results */
-    while (in.readLineInto(&line)) {
-        turn_results_.push_back(TurnResult(read_n_players, &line));
+    std::vector<QString> player_names(4);
+    for (int i = 0; i < scoresheet.nPlayers(); i++) {
+        player_names[i] = scoresheet.playerName(i);
     }
-
-    // Recompute scores
-    recomputeScores();
-
+    reset(static_cast<N_Players>(scoresheet.nPlayers()),
+          scoresheet.beginningScore(), player_names);
+
+    // Decode the turn records in place and add them at once
+    std::vector<TurnResult> turn_results;
+    turn_results.reserve(scoresheet.turnCount());
+    for (int i = 0; i < scoresheet.turnCount(); i++) {
+        turn_results.push_back(scoresheet.turnResult(i));
+    }
+    appendTurnResults(std::move(turn_results));
     return true;
 }
 
-void ScoreModel::recomputeScores() {
-    std::vector<int> initial_scores = std::vector<int>(scores_[0]);
-    scores_.clear();
-    scores_.push_back(initial_scores);
+int ScoreModel::score(int turn_index, int player) const {
+    return score_table_.score(turn_index, player);
+}
 
-    // Compute each line of score depending on the result of each turn
-    for (size_t i = 0; i < turn_results_.size(); i++) {
-        std::vector<int> turn_score_change =
-            turn_results_[i].computeScoreChange(static_cast<int>(n_players_));
-        scores_.push_back(std::vector<int>(scores_[0].size(), 0));
-        for (size_t j = 0; j < scores_[0].size(); j++) {
-            scores_[scores_.size() - 1][j] =
-                scores_[scores_.size() - 2][j] + turn_score_change[j];
-        }
+void ScoreModel::notifyScoresChanged(int first_row) {
+    const int n_rows = rowCount();
+    if (first_row >= n_rows) {
+        return;
     }
-    emit layoutChanged();
-}
\ No newline at end of file
+    emit dataChanged(index(first_row, 0),
+                     index(n_rows - 1, static_cast<int>(n_players_) - 1));
+}
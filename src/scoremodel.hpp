@@ -1,12 +1,19 @@
 #pragma once
 #include <QAbstractTableModel>
+#include <iterator>
+#include <utility>
 #include <vector>
 
+#include "gamearchive.hpp"
+#include "scoresheetdata.hpp"
+#include "scoretable.hpp"
 #include "turnresult.hpp"
 
 /**
  * @brief Abstract table model representing a game's scoresheet
  *
+ * The scores are computed by a ScoreTable, the model notifies the views of
+ * its changes.
  */
 class ScoreModel : public QAbstractTableModel {
     Q_OBJECT
@@ -32,14 +39,38 @@ class ScoreModel : public QAbstractTableModel {
     const std::vector<QString> &PlayerNames() const;
     const std::vector<TurnResult> &turnResults() const;
 
-    /* Turn history modifiers */
+    /* Turn history modifiers
+     * They maintain the scores incrementally: only the rows from the modified
+     * turn onwards are updated */
     void addTurnResult(const TurnResult &turn_result);
+    void insertTurnResult(int turn_index, const TurnResult &turn_result);
+    void replaceTurnResult(int turn_index, const TurnResult &turn_result);
     void deleteTurnResult(int turn_index);
 
+    /**
+     * @brief Append a range of turn results at the end of the scoresheet
+     *
+     * The turns are moved in when the range yields rvalues (e.g. through
+     * std::make_move_iterator), the scores of the new turns are computed once
+     * and a single row insertion is notified to the views.
+     */
+    template <typename InputIt>
+    void appendTurnResults(InputIt first, InputIt last);
+    void appendTurnResults(std::vector<TurnResult> &&turn_results);
+    /**
+     * @brief Construct a turn result in place at the end of the scoresheet
+     */
+    template <typename... Args> void emplaceTurnResult(Args &&...args);
+
     /* Empty the model and change number of players and player names */
     void reset(N_Players _n_players, int beginning_score,
                const std::vector<QString> &_player_names);
 
+    /**
+     * @brief Copy the content of the scoresheet
+     */
+    ScoresheetData toScoresheetData() const;
+
     /**
      * @brief Convert the scoresheet to text and output it to given stream
      */
@@ -53,16 +84,66 @@ class ScoreModel : public QAbstractTableModel {
      */
     bool loadFromTextStream(QTextStream &in);
 
+    /**
+     * @brief Replace the scoresheet by the given content, moving its turns in
+     *
+     * The scores are computed before the views are notified, in a single
+     * model reset.
+     */
+    void load(ScoresheetData &&data);
+    /**
+     * @brief Replace the scoresheet by a game of an opened archive, decoding
+     * its turns straight from the archive mapping
+     *
+     * @return false if the game is corrupted
+     */
+    bool loadFromArchive(const GameArchive &archive, int game);
+
+  signals:
+    /* Emitted by the turn history modifiers once the scores are updated
+     * (bulk appends and loads only reset or grow the model) */
+    void turnResultInserted(int turn_index);
+    void turnResultReplaced(int turn_index);
+    void turnResultDeleted(int turn_index);
+
   private:
     /**
-     * @brief Recompute the scores depending on the turn history
+     * @brief Score of a player after the given turn (0 is the initial score)
+     */
+    int score(int turn_index, int player) const;
+
+    /**
+     * @brief Notify the views that every row from first_row to the last one
+     * changed
      */
-    void recomputeScores();
-
-    N_Players n_players_;                  /**< Number of players */
-    std::vector<QString> player_names_;    /**< Names of the players */
-    std::vector<TurnResult> turn_results_; /**< Turn results history */
-    /** Saved scores: scores_[i][j] corresponds to the score of player j on
-     * the i-th turn*/
-    std::vector<std::vector<int>> scores_;
-};
\ No newline at end of file
+    void notifyScoresChanged(int first_row);
+
+    N_Players n_players_;               /**< Number of players */
+    std::vector<QString> player_names_; /**< Names of the players */
+    ScoreTable score_table_;            /**< Turn history and scores */
+};
+
+template <typename InputIt>
+void ScoreModel::appendTurnResults(InputIt first, InputIt last) {
+    const int first_new_turn = score_table_.turnResults().size();
+    const int n_new_turns = score_table_.appendTurnResults(first, last);
+    if (n_new_turns == 0) {
+        return;
+    }
+
+    // Rows are counted from the scores, so they only appear once computed
+    beginInsertRows(QModelIndex(), first_new_turn + 1,
+                    first_new_turn + n_new_turns);
+    score_table_.recomputeScores(first_new_turn);
+    endInsertRows();
+}
+
+template <typename... Args>
+void ScoreModel::emplaceTurnResult(Args &&...args) {
+    const int turn_index = score_table_.turnResults().size();
+    score_table_.emplaceTurnResult(std::forward<Args>(args)...);
+
+    beginInsertRows(QModelIndex(), turn_index + 1, turn_index + 1);
+    score_table_.recomputeScores(turn_index);
+    endInsertRows();
+}
\ No newline at end of file
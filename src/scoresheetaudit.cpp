@@ -0,0 +1,121 @@
+#include <cstdlib>
+
+#include "analysiswriter.hpp"
+#include "handdictionary.hpp"
+#include "scoresheetaudit.hpp"
+
+static const int RIICHI_STICK = 1000;
+
+std::vector<ScoresheetAudit::Discrepancy>
+ScoresheetAudit::check(const ScoresheetData &data) {
+    std::vector<Discrepancy> discrepancies;
+    for (size_t i = 0; i < data.turn_results.size(); i++) {
+        const int turn = static_cast<int>(i);
+        const TurnResult &result = data.turn_results[i];
+        const TurnOutcome outcome = result.outcome();
+        if ((outcome == TurnOutcome::TSUMO || outcome == TurnOutcome::RON) &&
+            result.hand() != nullptr) {
+            checkHand(turn, result, discrepancies);
+        }
+
+        const std::vector<int> score_change =
+            result.computeScoreChange(data.n_players);
+        int sum = 0;
+        for (int change : score_change) {
+            sum += change;
+        }
+        const bool riichi_sticks =
+            outcome == TurnOutcome::MANUAL && sum % RIICHI_STICK == 0 &&
+            std::abs(sum) <= data.n_players * RIICHI_STICK;
+        if (sum != 0 && !riichi_sticks) {
+            discrepancies.push_back(Discrepancy{
+                turn, Issue::UNBALANCED,
+                QString("Score changes sum to %1 instead of 0").arg(sum)});
+        }
+    }
+    return discrepancies;
+}
+
+void ScoresheetAudit::checkHand(int turn, const TurnResult &result,
+                                std::vector<Discrepancy> &discrepancies) {
+    // Checked and scored once per distinct hand
+    HandDictionary &dictionary = HandDictionary::instance();
+    const WinningHand &hand = *result.hand();
+    const QString hand_string = QString::fromStdString(hand.toString());
+    const ValidityStatus &validity = dictionary.validity(hand);
+    if (!validity.valid) {
+        discrepancies.push_back(
+            Discrepancy{turn, Issue::INVALID_HAND,
+                        QString("Invalid hand %1 (%2)")
+                            .arg(hand_string,
+                                 QString::fromStdString(validity.message))});
+        return;
+    }
+    const HandScore &score = dictionary.score(hand);
+    if (score.totalFu() != result.fuScore()) {
+        discrepancies.push_back(
+            Discrepancy{turn, Issue::FU_MISMATCH,
+                        QString("%1 fu recorded, the hand %2 scores %3 fu")
+                            .arg(result.fuScore())
+                            .arg(hand_string)
+                            .arg(score.totalFu())});
+    }
+    if (score.totalFan() != result.fanScore()) {
+        discrepancies.push_back(
+            Discrepancy{turn, Issue::FAN_MISMATCH,
+                        QString("%1 fan recorded, the hand %2 scores %3 fan")
+                            .arg(result.fanScore())
+                            .arg(hand_string)
+                            .arg(score.totalFan())});
+    }
+}
+
+const char *ScoresheetAudit::issueName(Issue issue) {
+    switch (issue) {
+    case Issue::INVALID_HAND:
+        return "invalid_hand";
+    case Issue::FU_MISMATCH:
+        return "fu_mismatch";
+    case Issue::FAN_MISMATCH:
+        return "fan_mismatch";
+    case Issue::UNBALANCED:
+        return "unbalanced";
+    }
+    return "";
+}
+
+void ScoresheetAudit::encode(bool json, const QString &file_name,
+                             const QString &game_name,
+                             const std::vector<Discrepancy> &discrepancies,
+                             QByteArray &out) {
+    const QByteArray utf8_file_name = file_name.toUtf8();
+    for (const Discrepancy &discrepancy : discrepancies) {
+        if (!json) {
+            out.append(utf8_file_name);
+            if (!game_name.isEmpty()) {
+                out.append(" (").append(game_name.toUtf8()).append(')');
+            }
+            out.append(": turn ")
+                .append(QByteArray::number(discrepancy.turn + 1))
+                .append(": ")
+                .append(discrepancy.message.toUtf8())
+                .append('\n');
+            continue;
+        }
+        out.append("{\"file\":");
+        AnalysisWriter::appendJsonString(out, utf8_file_name);
+        out.append(",\"game\":");
+        if (game_name.isEmpty()) {
+            out.append("null");
+        } else {
+            AnalysisWriter::appendJsonString(out, game_name.toUtf8());
+        }
+        out.append(",\"turn\":")
+            .append(QByteArray::number(discrepancy.turn))
+            .append(",\"issue\":\"")
+            .append(issueName(discrepancy.issue))
+            .append("\",\"message\":");
+        AnalysisWriter::appendJsonString(out, discrepancy.message.toUtf8());
+        out.append("}\n");
+    }
+}
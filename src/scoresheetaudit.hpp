@@ -0,0 +1,64 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+#include "scoresheetdata.hpp"
+
+/**
+ * @brief Consistency checks of the turns of a scoresheet, to find the
+ * scoring mistakes of hand-entered games
+ *
+ * The winning hand of a victory, if recorded, must be valid and score the
+ * recorded fu and fan. The score changes of every turn must sum to zero,
+ * apart from the riichi sticks put on or taken from the table by a manual
+ * result.
+ */
+class ScoresheetAudit {
+  public:
+    enum class Issue {
+        INVALID_HAND, /**< The winning hand fails WinningHand::checkValid() */
+        FU_MISMATCH,  /**< The recorded fu differ from the hand's */
+        FAN_MISMATCH, /**< The recorded fan differ from the hand's */
+        UNBALANCED    /**< The score changes do not sum to zero */
+    };
+    /**
+     * @brief Inconsistency found in a turn
+     */
+    struct Discrepancy {
+        int turn; /**< Index of the turn, from 0 */
+        Issue issue;
+        QString message; /**< With the recorded and expected values */
+    };
+
+    /**
+     * @brief Check every turn of a scoresheet
+     */
+    static std::vector<Discrepancy> check(const ScoresheetData &data);
+
+    /**
+     * @brief Name of the issue in the JSON lines
+     */
+    static const char *issueName(Issue issue);
+    /**
+     * @brief Append the discrepancies of a scoresheet to the report, in the
+     * text or the JSON lines format
+     *
+     * In the text format, each discrepancy is a line "<file>: turn <n>:
+     * <message>" (with "<file> (<game>)" for a game of an archive), the turns
+     * being numbered from 1 as in the scoresheet view. In the JSON lines
+     * format, it is an object with the "file", "game" (null for a file),
+     * "turn" (from 0, as in the analyses), "issue" and "message" members.
+     */
+    static void encode(bool json, const QString &file_name,
+                       const QString &game_name,
+                       const std::vector<Discrepancy> &discrepancies,
+                       QByteArray &out);
+
+  private:
+    /**
+     * @brief Check the recorded winning hand of a victory
+     */
+    static void checkHand(int turn, const TurnResult &result,
+                          std::vector<Discrepancy> &discrepancies);
+};
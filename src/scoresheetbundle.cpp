@@ -0,0 +1,308 @@
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QtEndian>
+#include <cstring>
+#include <vector>
+
+#include "scoresheetbundle.hpp"
+
+/**
+ * @brief Append a length-prefixed UTF-8 string to a name pool
+ */
+static void appendString(QByteArray &pool, const QByteArray &utf8) {
+    uchar length[2];
+    qToLittleEndian<quint16>(utf8.size(), length);
+    pool.append(reinterpret_cast<const char *>(length), 2);
+    pool.append(utf8);
+}
+
+ScoresheetBundle::ScoresheetBundle()
+    : data_(nullptr), size_(0), n_blocks_(0), n_files_(0), blocks_(nullptr),
+      files_(nullptr), names_(nullptr), names_size_(0) {}
+
+ScoresheetBundle::~ScoresheetBundle() { close(); }
+
+bool ScoresheetBundle::open(const QString &file_name) {
+    close();
+    file_.setFileName(file_name);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        error_string_ = file_.errorString();
+        return false;
+    }
+    size_ = file_.size();
+    if (size_ < static_cast<qint64>(sizeof(MsszHeader)) ||
+        (data_ = file_.map(0, size_)) == nullptr) {
+        error_string_ = "Unable to map the scoresheet bundle";
+        close();
+        return false;
+    }
+
+    const MsszHeader *header = reinterpret_cast<const MsszHeader *>(data_);
+    if (std::memcmp(header->magic, MSSZ_MAGIC, sizeof(MSSZ_MAGIC)) != 0 ||
+        qFromLittleEndian(header->version) != MSSZ_VERSION) {
+        error_string_ = "Not a scoresheet bundle";
+        close();
+        return false;
+    }
+    const quint64 index_offset = qFromLittleEndian(header->index_offset);
+    n_blocks_ = qFromLittleEndian(header->n_blocks);
+    n_files_ = qFromLittleEndian(header->n_files);
+    names_size_ = qFromLittleEndian(header->names_size);
+    // The offsets are compared without adding them, which could wrap around
+    if (index_offset % 8 != 0 || index_offset > static_cast<quint64>(size_) ||
+        static_cast<quint64>(n_blocks_) * sizeof(MsszBlock) +
+                static_cast<quint64>(n_files_) * sizeof(MsszFile) +
+                names_size_ >
+            static_cast<quint64>(size_) - index_offset) {
+        error_string_ = "Truncated or corrupted scoresheet bundle";
+        close();
+        return false;
+    }
+    blocks_ = reinterpret_cast<const MsszBlock *>(data_ + index_offset);
+    files_ = reinterpret_cast<const MsszFile *>(blocks_ + n_blocks_);
+    names_ = reinterpret_cast<const uchar *>(files_ + n_files_);
+
+    // Check that the blocks, the files and their names lie inside the bundle
+    for (quint32 block = 0; block < n_blocks_; block++) {
+        const quint64 offset = qFromLittleEndian(blocks_[block].offset);
+        if (offset > index_offset ||
+            qFromLittleEndian(blocks_[block].size) > index_offset - offset) {
+            error_string_ = "Corrupted block index";
+            close();
+            return false;
+        }
+    }
+    for (quint32 file = 0; file < n_files_; file++) {
+        const MsszFile &entry = files_[file];
+        const quint32 block = qFromLittleEndian(entry.block);
+        const quint32 name_offset = qFromLittleEndian(entry.name_offset);
+        if (block >= n_blocks_ ||
+            static_cast<quint64>(qFromLittleEndian(entry.offset)) +
+                    qFromLittleEndian(entry.size) >
+                qFromLittleEndian(blocks_[block].uncompressed_size) ||
+            static_cast<quint64>(name_offset) + 2 > names_size_ ||
+            static_cast<quint64>(name_offset) + 2 +
+                    qFromLittleEndian<quint16>(names_ + name_offset) >
+                names_size_) {
+            error_string_ = "Corrupted file index";
+            close();
+            return false;
+        }
+    }
+    block_mutexes_.reset(new QMutex[n_blocks_]);
+    return true;
+}
+
+void ScoresheetBundle::close() {
+    if (data_ != nullptr) {
+        file_.unmap(const_cast<uchar *>(data_));
+    }
+    file_.close();
+    data_ = nullptr;
+    size_ = 0;
+    n_blocks_ = 0;
+    n_files_ = 0;
+    blocks_ = nullptr;
+    files_ = nullptr;
+    names_ = nullptr;
+    names_size_ = 0;
+    block_mutexes_.reset();
+    cached_blocks_.clear();
+    cache_order_.clear();
+}
+
+bool ScoresheetBundle::isOpen() const { return data_ != nullptr; }
+const QString &ScoresheetBundle::errorString() const { return error_string_; }
+
+int ScoresheetBundle::blockCount() const { return n_blocks_; }
+int ScoresheetBundle::fileCount() const { return n_files_; }
+
+QString ScoresheetBundle::fileName(int file) const {
+    const uchar *name = names_ + qFromLittleEndian(fileEntry(file).name_offset);
+    return QString::fromUtf8(reinterpret_cast<const char *>(name + 2),
+                             qFromLittleEndian<quint16>(name));
+}
+
+int ScoresheetBundle::fileSize(int file) const {
+    return qFromLittleEndian(fileEntry(file).size);
+}
+
+int ScoresheetBundle::fileBlock(int file) const {
+    return qFromLittleEndian(fileEntry(file).block);
+}
+
+bool ScoresheetBundle::readBlock(int block, QByteArray &content,
+                                 QString *error_message) const {
+    // Only one thread decompresses a block, the others wait for it
+    QMutexLocker block_locker(&block_mutexes_[block]);
+    {
+        QMutexLocker locker(&cache_mutex_);
+        const auto cached = cached_blocks_.constFind(block);
+        if (cached != cached_blocks_.constEnd()) {
+            content = cached.value();
+            return true;
+        }
+    }
+
+    const MsszBlock &entry = blocks_[block];
+    content = qUncompress(data_ + qFromLittleEndian(entry.offset),
+                          qFromLittleEndian(entry.size));
+    if (content.size() !=
+        static_cast<int>(qFromLittleEndian(entry.uncompressed_size))) {
+        if (error_message != nullptr) {
+            *error_message = QString("Corrupted block %1").arg(block);
+        }
+        return false;
+    }
+
+    QMutexLocker locker(&cache_mutex_);
+    cached_blocks_.insert(block, content);
+    cache_order_.push_back(block);
+    if (static_cast<int>(cache_order_.size()) > CACHED_BLOCKS) {
+        cached_blocks_.remove(cache_order_.front());
+        cache_order_.pop_front();
+    }
+    return true;
+}
+
+bool ScoresheetBundle::readContent(int file, QByteArray &content,
+                                   QString *error_message) const {
+    const MsszFile &entry = fileEntry(file);
+    QByteArray block;
+    if (!readBlock(qFromLittleEndian(entry.block), block, error_message)) {
+        return false;
+    }
+    content = block.mid(qFromLittleEndian(entry.offset),
+                        qFromLittleEndian(entry.size));
+    return true;
+}
+
+bool ScoresheetBundle::readFile(int file, ScoresheetData &data,
+                                QString *error_message) const {
+    const MsszFile &entry = fileEntry(file);
+    QByteArray block;
+    if (!readBlock(qFromLittleEndian(entry.block), block, error_message)) {
+        return false;
+    }
+    // Parsed in place, from the decompressed block
+    const char *begin = block.constData() + qFromLittleEndian(entry.offset);
+    return ScoresheetData::read(begin, begin + qFromLittleEndian(entry.size),
+                                data, error_message);
+}
+
+bool ScoresheetBundle::create(const QString &file_name,
+                              const QStringList &input_files,
+                              QString *error_message) {
+    // Write the bundle aside and replace the original atomically
+    QSaveFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    std::vector<MsszBlock> blocks;
+    std::vector<MsszFile> files;
+    QByteArray names;
+    QSet<QString> bundled_names;
+    QByteArray block;
+    QString error;
+    // Reserve room for the header, written last
+    bool success = file.write(QByteArray(sizeof(MsszHeader), '\0')) ==
+                   sizeof(MsszHeader);
+    const auto write_block = [&]() {
+        const QByteArray compressed = qCompress(block);
+        MsszBlock entry;
+        entry.offset = qToLittleEndian<quint64>(file.pos());
+        entry.size = qToLittleEndian<quint32>(compressed.size());
+        entry.uncompressed_size = qToLittleEndian<quint32>(block.size());
+        blocks.push_back(entry);
+        block.clear();
+        return file.write(compressed) == compressed.size();
+    };
+
+    for (int i = 0; success && i < input_files.size(); i++) {
+        const QString &input_file = input_files[i];
+        const QString name = QFileInfo(input_file).fileName();
+        const QByteArray utf8_name = name.toUtf8();
+        if (bundled_names.contains(name) || utf8_name.size() > 0xffff) {
+            error = "Duplicate or too long file name " + name;
+            success = false;
+            break;
+        }
+        bundled_names.insert(name);
+        QFile input(input_file);
+        if (!input.open(QIODevice::ReadOnly)) {
+            error = input_file + ": " + input.errorString();
+            success = false;
+            break;
+        }
+        // Only scoresheets are bundled
+        const QByteArray content = input.readAll();
+        ScoresheetData data;
+        QString parse_error;
+        if (!ScoresheetData::read(content.constData(),
+                                  content.constData() + content.size(), data,
+                                  &parse_error)) {
+            error = input_file + ": Error when parsing scoresheet file (" +
+                    parse_error + ")";
+            success = false;
+            break;
+        }
+
+        MsszFile entry;
+        entry.block = qToLittleEndian<quint32>(blocks.size());
+        entry.offset = qToLittleEndian<quint32>(block.size());
+        entry.size = qToLittleEndian<quint32>(content.size());
+        entry.name_offset = qToLittleEndian<quint32>(names.size());
+        files.push_back(entry);
+        appendString(names, utf8_name);
+        block.append(content);
+        if (block.size() >= BLOCK_SIZE) {
+            success = write_block();
+        }
+    }
+    if (success && !block.isEmpty()) {
+        success = write_block();
+    }
+
+    // Index, then the header pointing to it
+    const quint64 index_offset = (file.pos() + 7) & ~quint64(7);
+    success = success &&
+              file.write(QByteArray(index_offset - file.pos(), '\0')) >= 0 &&
+              file.write(reinterpret_cast<const char *>(blocks.data()),
+                         blocks.size() * sizeof(MsszBlock)) ==
+                  static_cast<qint64>(blocks.size() * sizeof(MsszBlock)) &&
+              file.write(reinterpret_cast<const char *>(files.data()),
+                         files.size() * sizeof(MsszFile)) ==
+                  static_cast<qint64>(files.size() * sizeof(MsszFile)) &&
+              file.write(names) == names.size();
+    MsszHeader header;
+    std::memcpy(header.magic, MSSZ_MAGIC, sizeof(MSSZ_MAGIC));
+    header.version = qToLittleEndian(MSSZ_VERSION);
+    header.reserved = 0;
+    header.n_blocks = qToLittleEndian<quint32>(blocks.size());
+    header.n_files = qToLittleEndian<quint32>(files.size());
+    header.names_size = qToLittleEndian<quint32>(names.size());
+    header.reserved2 = 0;
+    header.index_offset = qToLittleEndian(index_offset);
+    success = success && file.seek(0) &&
+              file.write(reinterpret_cast<const char *>(&header),
+                         sizeof(header)) == sizeof(header);
+    if (!success || !file.commit()) {
+        if (error.isEmpty()) {
+            error = file.errorString();
+        }
+        if (error_message != nullptr) {
+            *error_message = error;
+        }
+        return false;
+    }
+    return true;
+}
+
+const MsszFile &ScoresheetBundle::fileEntry(int file) const {
+    return files_[file];
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <deque>
+#include <memory>
+
+#include "scoresheetdata.hpp"
+
+/*
+ * Compressed scoresheet bundle format (.mssz), version 1
+ *
+ * All integers are little-endian. The file is made of:
+ *  - a fixed-size header (MsszHeader)
+ *  - the blocks, each one compressed with qCompress() (zlib, after the
+ *    uncompressed size as a 32-bit big-endian integer) and holding whole
+ *    scoresheet files (.mss or .mssb) one after the other
+ *  - the block index: n_blocks fixed-size entries (MsszBlock)
+ *  - the file index: n_files fixed-size entries (MsszFile)
+ *  - the name pool holding the file names, each one as a 16-bit length
+ *    followed by UTF-8 bytes
+ *
+ * Each block is decompressed on its own, so any file is read by
+ * decompressing the block holding it.
+ */
+
+static const char MSSZ_MAGIC[4] = {'M', 'S', 'S', 'Z'};
+static const quint16 MSSZ_VERSION = 1;
+
+/**
+ * @brief Header of a scoresheet bundle
+ */
+struct MsszHeader {
+    char magic[4];        /**< "MSSZ" */
+    quint16 version;      /**< Format version */
+    quint16 reserved;     /**< Always 0 */
+    quint32 n_blocks;     /**< Number of compressed blocks */
+    quint32 n_files;      /**< Number of scoresheet files */
+    quint32 names_size;   /**< Size of the name pool */
+    quint32 reserved2;    /**< Always 0 */
+    quint64 index_offset; /**< Offset of the block index */
+};
+static_assert(sizeof(MsszHeader) == 32, "Unexpected MsszHeader layout");
+
+/**
+ * @brief Entry of the block index
+ */
+struct MsszBlock {
+    quint64 offset;            /**< Offset of the compressed block */
+    quint32 size;              /**< Size of the compressed block */
+    quint32 uncompressed_size; /**< Size of the files of the block */
+};
+static_assert(sizeof(MsszBlock) == 16, "Unexpected MsszBlock layout");
+
+/**
+ * @brief Entry of the file index
+ */
+struct MsszFile {
+    quint32 block;        /**< Block holding the file */
+    quint32 offset;       /**< Offset of the file in the uncompressed block */
+    quint32 size;         /**< Size of the file */
+    quint32 name_offset;  /**< Offset of the file name in the name pool */
+};
+static_assert(sizeof(MsszFile) == 16, "Unexpected MsszFile layout");
+
+/**
+ * @brief Read access to a compressed scoresheet bundle
+ *
+ * The bundle is mapped in memory and the index is read in place. Reading a
+ * file decompresses its block in memory, and the scoresheet is parsed
+ * straight from the decompressed block. The last decompressed blocks are
+ * kept, so that reading the files in order decompresses each block once,
+ * and files can be read from several threads.
+ */
+class ScoresheetBundle {
+  public:
+    /** Uncompressed size from which a block is closed when bundling */
+    static const int BLOCK_SIZE = 256 * 1024;
+    /** Number of decompressed blocks kept */
+    static const int CACHED_BLOCKS = 16;
+
+    ScoresheetBundle();
+    ~ScoresheetBundle();
+    ScoresheetBundle(const ScoresheetBundle &) = delete;
+    ScoresheetBundle &operator=(const ScoresheetBundle &) = delete;
+
+    /**
+     * @brief Open and map a bundle file
+     *
+     * @return false if the file cannot be mapped or is not a valid bundle
+     */
+    bool open(const QString &file_name);
+    void close();
+    bool isOpen() const;
+    const QString &errorString() const;
+
+    /* File index */
+    int blockCount() const;
+    int fileCount() const;
+    QString fileName(int file) const;
+    int fileSize(int file) const;
+    int fileBlock(int file) const;
+
+    /**
+     * @brief Decompressed content of a block
+     *
+     * @return false if the block is corrupted
+     */
+    bool readBlock(int block, QByteArray &content,
+                   QString *error_message = nullptr) const;
+    /**
+     * @brief Content of a scoresheet file of the bundle
+     */
+    bool readContent(int file, QByteArray &content,
+                     QString *error_message = nullptr) const;
+    /**
+     * @brief Parse a scoresheet file of the bundle, in the text or the binary
+     * format
+     */
+    bool readFile(int file, ScoresheetData &data,
+                  QString *error_message = nullptr) const;
+
+    /**
+     * @brief Bundle scoresheet files, in the given order
+     *
+     * The files are named by their name without directory, which must be
+     * unique in the bundle. The bundle is written aside and replaces the
+     * file only once complete.
+     */
+    static bool create(const QString &file_name, const QStringList &input_files,
+                       QString *error_message = nullptr);
+
+  private:
+    const MsszFile &fileEntry(int file) const;
+
+    QFile file_;                   /**< Bundle file */
+    const uchar *data_;            /**< Mapping of the whole bundle */
+    qint64 size_;                  /**< Size of the bundle */
+    quint32 n_blocks_;             /**< Number of blocks */
+    quint32 n_files_;              /**< Number of files */
+    const MsszBlock *blocks_;      /**< Block index */
+    const MsszFile *files_;        /**< File index */
+    const uchar *names_;           /**< Name pool */
+    quint32 names_size_;           /**< Size of the name pool */
+    QString error_string_;         /**< Last error */
+    /** One lock per block, so that a block is decompressed once even when
+     * several threads read its files */
+    std::unique_ptr<QMutex[]> block_mutexes_;
+    mutable QMutex cache_mutex_;                /**< Protects the cache */
+    mutable QHash<int, QByteArray> cached_blocks_;
+    mutable std::deque<int> cache_order_; /**< Cached blocks, oldest first */
+};
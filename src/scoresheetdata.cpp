@@ -0,0 +1,83 @@
+#include "scoresheetdata.hpp"
+#include "binaryscoresheet.hpp"
+#include "mssparser.hpp"
+
+void ScoresheetData::writeToTextStream(QTextStream &out) const {
+    out << n_players << "\n";
+    for (int i = 0; i < n_players; i++) {
+        out << player_names[i] << "\n";
+    }
+    out << beginning_score << "\n";
+    for (const TurnResult &turn_result : turn_results) {
+        turn_result.writeToTextStream(out);
+        out << "\n";
+    }
+}
+
+bool ScoresheetData::encode(QByteArray &content, bool binary,
+                            QString *error_message) const {
+    if (binary) {
+        return BinaryScoresheet::encode(*this, content, error_message);
+    }
+
+    content.clear();
+    QTextStream out(&content, QIODevice::WriteOnly);
+    writeToTextStream(out);
+    out.flush();
+    return true;
+}
+
+bool ScoresheetData::writeFile(QFileDevice &file,
+                               QString *error_message) const {
+    QByteArray content;
+    if (!encode(content, isBinaryFileName(file.fileName()), error_message)) {
+        return false;
+    }
+    if (file.write(content) != content.size()) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ScoresheetData::readFile(QFile &file, ScoresheetData &data,
+                              QString *error_message,
+                              const ProgressCallback &progress) {
+    if (file.peek(sizeof(MSSB_MAGIC)) ==
+        QByteArray(MSSB_MAGIC, sizeof(MSSB_MAGIC))) {
+        return BinaryScoresheet::readFile(file, data, error_message, progress);
+    }
+    return MssParser::parseFile(file, data, error_message, progress);
+}
+
+bool ScoresheetData::read(const char *begin, const char *end,
+                          ScoresheetData &data, QString *error_message) {
+    if (end - begin >= static_cast<qint64>(sizeof(MSSB_MAGIC)) &&
+        QByteArray(begin, sizeof(MSSB_MAGIC)) ==
+            QByteArray(MSSB_MAGIC, sizeof(MSSB_MAGIC))) {
+        BinaryScoresheet scoresheet(reinterpret_cast<const uchar *>(begin),
+                                    end - begin);
+        if (!scoresheet.isValid()) {
+            if (error_message != nullptr) {
+                *error_message = scoresheet.errorString();
+            }
+            return false;
+        }
+        return scoresheet.read(data);
+    }
+
+    MssParser parser(begin, end);
+    if (!parser.parse(data)) {
+        if (error_message != nullptr) {
+            *error_message = parser.errorMessage();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ScoresheetData::isBinaryFileName(const QString &file_name) {
+    return file_name.endsWith(".mssb", Qt::CaseInsensitive);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <QFile>
+#include <QString>
+#include <QTextStream>
+#include <functional>
+#include <vector>
+
+#include "turnresult.hpp"
+
+/**
+ * @brief Progress report of a long operation (in any unit, done out of
+ * total), returning false to cancel the operation
+ */
+using ProgressCallback = std::function<bool(qint64 done, qint64 total)>;
+
+/**
+ * @brief Plain content of a scoresheet, independent from any view or model
+ *
+ * This is what scoresheet readers produce and writers consume.
+ */
+struct ScoresheetData {
+    int n_players = 3;                    /**< Number of players (3 or 4) */
+    std::vector<QString> player_names;    /**< Names of the players */
+    int beginning_score = 30000;          /**< Initial score of each player */
+    std::vector<TurnResult> turn_results; /**< Turn results history */
+
+    /**
+     * @brief Convert the scoresheet to text (.mss) and output it to the given
+     * stream
+     */
+    void writeToTextStream(QTextStream &out) const;
+
+    /**
+     * @brief Serialize the scoresheet in the text or the binary format
+     */
+    bool encode(QByteArray &content, bool binary,
+                QString *error_message = nullptr) const;
+
+    /**
+     * @brief Write the scoresheet to an opened file, in the binary format if
+     * the file name ends with .mssb and in the text format otherwise
+     */
+    bool writeFile(QFileDevice &file, QString *error_message = nullptr) const;
+
+    /**
+     * @brief Read a scoresheet from an opened file, in the text or the binary
+     * format (detected from the content)
+     *
+     * @param progress if set, called periodically while reading, reading is
+     * cancelled (and fails) if it returns false
+     */
+    static bool readFile(QFile &file, ScoresheetData &data,
+                         QString *error_message = nullptr,
+                         const ProgressCallback &progress = nullptr);
+    /**
+     * @brief Read a scoresheet held in memory in [begin, end), in the text or
+     * the binary format (detected from the content)
+     */
+    static bool read(const char *begin, const char *end, ScoresheetData &data,
+                     QString *error_message = nullptr);
+
+    /**
+     * @brief Returns true if the file name designates a binary scoresheet
+     */
+    static bool isBinaryFileName(const QString &file_name);
+};
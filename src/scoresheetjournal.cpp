@@ -0,0 +1,338 @@
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QTextStream>
+#include <algorithm>
+
+#include "fileutils.hpp"
+#include "mssparser.hpp"
+#include "scoresheetjournal.hpp"
+
+static const QByteArray JOURNAL_HEADER = "MSSJ 1 ";
+
+/**
+ * @brief SHA-1 of a scoresheet file, identifying the snapshot a journal
+ * applies to
+ */
+static bool snapshotHash(const QString &file_name, QByteArray &hash,
+                         QString *error_message) {
+    QFile file(file_name);
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    if (!file.open(QIODevice::ReadOnly) || !sha1.addData(&file)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    hash = sha1.result().toHex();
+    return true;
+}
+
+ScoresheetJournal::ScoresheetJournal(ScoreModel *score_model, QObject *parent)
+    : QObject(parent), score_model_(score_model) {
+    sync_timer_.setSingleShot(true);
+    sync_timer_.setInterval(SYNC_DELAY_MS);
+    connect(&sync_timer_, &QTimer::timeout, this, &ScoresheetJournal::sync);
+
+    connect(score_model_, &ScoreModel::turnResultInserted, this,
+            &ScoresheetJournal::turnResultInserted);
+    connect(score_model_, &ScoreModel::turnResultReplaced, this,
+            &ScoresheetJournal::turnResultReplaced);
+    connect(score_model_, &ScoreModel::turnResultDeleted, this,
+            &ScoresheetJournal::turnResultDeleted);
+    // A new or loaded scoresheet is no longer the journaled one
+    connect(score_model_, &ScoreModel::modelReset, this,
+            &ScoresheetJournal::close);
+}
+
+ScoresheetJournal::~ScoresheetJournal() { close(); }
+
+bool ScoresheetJournal::save(const QString &file_name,
+                             QString *error_message) {
+    close();
+
+    // The snapshot replaces the file only once completely written
+    QSaveFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+    if (!score_model_->toScoresheetData().writeFile(file, error_message)) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) {
+        if (error_message != nullptr) {
+            *error_message = file.errorString();
+        }
+        return false;
+    }
+
+    // The previous journal no longer matches the snapshot, it is replaced
+    return open(file_name, error_message);
+}
+
+bool ScoresheetJournal::open(const QString &file_name,
+                             QString *error_message) {
+    close();
+
+    QByteArray hash;
+    if (!snapshotHash(file_name, hash, error_message)) {
+        return false;
+    }
+    journal_.setFileName(journalFileName(file_name));
+    if (!journal_.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        journal_.write(JOURNAL_HEADER + hash + "\n") !=
+            JOURNAL_HEADER.size() + hash.size() + 1 ||
+        !syncToDisk(journal_)) {
+        if (error_message != nullptr) {
+            *error_message = journal_.errorString();
+        }
+        journal_.close();
+        return false;
+    }
+    file_name_ = file_name;
+    records_.clear();
+    return true;
+}
+
+void ScoresheetJournal::close() {
+    if (!isOpen()) {
+        return;
+    }
+    sync();
+    journal_.close();
+    file_name_.clear();
+}
+
+bool ScoresheetJournal::isOpen() const { return !file_name_.isEmpty(); }
+const QString &ScoresheetJournal::fileName() const { return file_name_; }
+int ScoresheetJournal::recordCount() const { return records_.size(); }
+
+bool ScoresheetJournal::compact(QString *error_message) {
+    if (!isOpen()) {
+        return true;
+    }
+    const QString file_name = file_name_;
+    return save(file_name, error_message);
+}
+
+bool ScoresheetJournal::sync() {
+    sync_timer_.stop();
+    if (!journal_.isOpen()) {
+        return true;
+    }
+    if (!syncToDisk(journal_)) {
+        emit writeError(journal_.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool ScoresheetJournal::checkpoint(const QByteArray &hash, int n_records) {
+    if (!isOpen()) {
+        return false;
+    }
+    const QByteArray line =
+        JOURNAL_HEADER + hash + " " + QByteArray::number(n_records) + "\n";
+    sync_timer_.stop();
+    if (journal_.write(line) != line.size() || !syncToDisk(journal_)) {
+        emit writeError(journal_.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool ScoresheetJournal::rebase(const QByteArray &hash, int n_records) {
+    if (!isOpen()) {
+        return false;
+    }
+    QSaveFile file(journalFileName(file_name_));
+    bool success = file.open(QIODevice::WriteOnly) &&
+                   file.write(JOURNAL_HEADER + hash + "\n") ==
+                       JOURNAL_HEADER.size() + hash.size() + 1;
+    for (size_t i = n_records; success && i < records_.size(); i++) {
+        success = file.write(records_[i]) == records_[i].size();
+    }
+    if (!success || !file.commit()) {
+        // The journal is still valid thanks to the checkpoint
+        return false;
+    }
+
+    // Keep appending to the new journal
+    journal_.close();
+    if (!journal_.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        emit writeError(journal_.errorString());
+        file_name_.clear();
+        return false;
+    }
+    records_.erase(records_.begin(), records_.begin() + n_records);
+    return true;
+}
+
+bool ScoresheetJournal::replay(const QString &file_name, ScoresheetData &data,
+                               int *n_records, QString *error_message) {
+    if (n_records != nullptr) {
+        *n_records = 0;
+    }
+    QFile journal(journalFileName(file_name));
+    if (!journal.exists()) {
+        return true;
+    }
+    QByteArray hash;
+    if (!journal.open(QIODevice::ReadOnly) ||
+        !snapshotHash(file_name, hash, error_message)) {
+        if (error_message != nullptr && !journal.isOpen()) {
+            *error_message = journal.errorString();
+        }
+        return false;
+    }
+    const QByteArray header = journal.readLine().trimmed();
+    if (!header.startsWith(JOURNAL_HEADER)) {
+        if (error_message != nullptr) {
+            *error_message = "Not a scoresheet journal";
+        }
+        return false;
+    }
+
+    // Collect the intact records, and find where the snapshot starts in them
+    int first_record = header == JOURNAL_HEADER + hash ? 0 : -1;
+    std::vector<QByteArray> records;
+    std::vector<int> record_lines;
+    for (int line = 2; !journal.atEnd(); line++) {
+        QByteArray record = journal.readLine();
+        // Stop at the first torn or corrupted record
+        if (!record.endsWith('\n')) {
+            break;
+        }
+        record.chop(1);
+        if (record.startsWith(JOURNAL_HEADER)) { // Checkpoint
+            const QList<QByteArray> fields = record.split(' ');
+            if (first_record < 0 && fields.size() == 4 && fields[2] == hash) {
+                first_record = fields[3].toInt();
+            }
+            continue;
+        }
+        bool ok;
+        const quint16 checksum = record.left(4).toUShort(&ok, 16);
+        record = record.mid(5);
+        if (!ok || qChecksum(record.constData(), record.size()) != checksum) {
+            break;
+        }
+        records.push_back(record);
+        record_lines.push_back(line);
+    }
+    // A journal written for another snapshot is outdated: the crash happened
+    // after the snapshot was rewritten
+    if (first_record < 0) {
+        return true;
+    }
+
+    std::vector<TurnResult> turn_results = data.turn_results;
+    int n_replayed = 0;
+    for (size_t i = first_record; i < records.size(); i++) {
+        const QByteArray &record = records[i];
+        const int line = record_lines[i];
+        bool ok;
+        const char operation = record.isEmpty() ? '\0' : record[0];
+        int index_end = record.indexOf(' ', 2);
+        if (index_end < 0) {
+            index_end = record.size();
+        }
+        const int turn_index = record.mid(2, index_end - 2).toInt(&ok);
+        const int max_index =
+            turn_results.size() - (operation == 'I' ? 0 : 1);
+        if (!ok || turn_index < 0 || turn_index > max_index ||
+            (operation != 'I' && operation != 'R' && operation != 'D')) {
+            if (error_message != nullptr) {
+                *error_message =
+                    QString("line %1: invalid journal record").arg(line);
+            }
+            return false;
+        }
+
+        if (operation == 'D') {
+            turn_results.erase(turn_results.begin() + turn_index);
+        } else {
+            TurnResult turn_result;
+            MssParser parser(record.constData() + std::min(index_end + 1,
+                                                           record.size()),
+                             record.constData() + record.size());
+            if (!parser.parseTurnResult(data.n_players, turn_result)) {
+                if (error_message != nullptr) {
+                    *error_message = QString("line %1, column %2: %3")
+                                         .arg(line)
+                                         .arg(index_end + 5 +
+                                              parser.errorColumn())
+                                         .arg(parser.errorString());
+                }
+                return false;
+            }
+            if (operation == 'I') {
+                turn_results.insert(turn_results.begin() + turn_index,
+                                    turn_result);
+            } else {
+                turn_results[turn_index] = turn_result;
+            }
+        }
+        n_replayed++;
+    }
+
+    data.turn_results = std::move(turn_results);
+    if (n_records != nullptr) {
+        *n_records = n_replayed;
+    }
+    return true;
+}
+
+QString ScoresheetJournal::journalFileName(const QString &file_name) {
+    return file_name + ".journal";
+}
+
+void ScoresheetJournal::turnResultInserted(int turn_index) {
+    append('I', turn_index);
+}
+
+void ScoresheetJournal::turnResultReplaced(int turn_index) {
+    append('R', turn_index);
+}
+
+void ScoresheetJournal::turnResultDeleted(int turn_index) {
+    append('D', turn_index);
+}
+
+void ScoresheetJournal::append(char operation, int turn_index) {
+    if (!isOpen()) {
+        return;
+    }
+
+    QString text;
+    QTextStream out(&text);
+    out << operation << " " << turn_index;
+    if (operation != 'D') {
+        out << " ";
+        score_model_->turnResults()[turn_index].writeToTextStream(out);
+    }
+    out.flush();
+    const QByteArray record = text.toUtf8();
+    const QByteArray line =
+        QByteArray::number(qChecksum(record.constData(), record.size()), 16)
+            .rightJustified(4, '0') +
+        " " + record + "\n";
+
+    // Flushed right away (safe if the application crashes), synced to disk
+    // in batches (safe if the system crashes)
+    if (journal_.write(line) != line.size() || !journal_.flush()) {
+        emit writeError(journal_.errorString());
+        close();
+        return;
+    }
+    records_.push_back(line);
+    if (!sync_timer_.isActive()) {
+        sync_timer_.start();
+    }
+    if (records_.size() == COMPACTION_THRESHOLD) {
+        emit compactionNeeded();
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <QFile>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <vector>
+
+#include "scoremodel.hpp"
+#include "scoresheetdata.hpp"
+
+/*
+ * Scoresheet journal (<scoresheet file>.journal), version 1
+ *
+ * The journal records the changes made to a scoresheet since it was last
+ * written in full (its snapshot). It is a text file made of:
+ *  - a header line "MSSJ 1 <SHA-1 of the snapshot file>"
+ *  - one line per change "<CRC-16> <operation> <turn index>[ <turn result>]"
+ *    where the operation is I (insert), R (replace) or D (delete), the turn
+ *    result is written as in a .mss file and the CRC-16 (4 hexadecimal
+ *    digits) covers the rest of the line
+ *  - checkpoint lines "MSSJ 1 <SHA-1> <n>", written before the snapshot is
+ *    rewritten in the background: the new snapshot holds the first n records
+ *
+ * Replaying starts from the header or the checkpoint matching the snapshot
+ * file, so the journal stays valid whether or not the rewrite completed. A
+ * torn or corrupted last record (crash during a write) is ignored, as well as
+ * a journal written for another snapshot.
+ */
+
+/**
+ * @brief Append-only journal of the changes made to a saved scoresheet
+ *
+ * Each change of the score model is appended to the journal as one record,
+ * so keeping the file up to date costs O(1) per turn. Records are flushed
+ * immediately and synced to disk in batches. The snapshot is rewritten
+ * (atomically) and the journal emptied when the scoresheet is saved
+ * explicitly, or in the background through checkpoint() and rebase().
+ */
+class ScoresheetJournal : public QObject {
+    Q_OBJECT
+  public:
+    static const int SYNC_DELAY_MS = 1000;       /**< Delay of batched syncs */
+    static const int COMPACTION_THRESHOLD = 256; /**< Records before compaction */
+
+    ScoresheetJournal(ScoreModel *score_model, QObject *parent = nullptr);
+    ~ScoresheetJournal();
+
+    /**
+     * @brief Write the whole scoresheet to the given file (atomically) and
+     * journal the following changes against it
+     */
+    bool save(const QString &file_name, QString *error_message = nullptr);
+    /**
+     * @brief Journal the following changes against a scoresheet file
+     * matching the current content of the score model
+     */
+    bool open(const QString &file_name, QString *error_message = nullptr);
+    /**
+     * @brief Sync the pending records and stop journaling
+     */
+    void close();
+    bool isOpen() const;
+    const QString &fileName() const;
+    /**
+     * @brief Number of records on top of the snapshot
+     */
+    int recordCount() const;
+
+    /**
+     * @brief Rewrite the snapshot from the score model and empty the journal
+     */
+    bool compact(QString *error_message = nullptr);
+    /**
+     * @brief Store the pending records on disk
+     */
+    bool sync();
+
+    /**
+     * @brief Record that a new snapshot with the given SHA-1 and holding the
+     * first n_records records is about to replace the snapshot file
+     *
+     * The checkpoint is stored on disk when this function returns.
+     */
+    bool checkpoint(const QByteArray &hash, int n_records);
+    /**
+     * @brief Rewrite the journal (atomically) on top of the new snapshot,
+     * once it replaced the snapshot file, keeping the following records
+     */
+    bool rebase(const QByteArray &hash, int n_records);
+
+    /**
+     * @brief Apply the journal of a scoresheet file, if any, to its content
+     *
+     * @param n_records if not null, receives the number of replayed records
+     * @return false if the journal does not match the scoresheet (the
+     * scoresheet is left untouched)
+     */
+    static bool replay(const QString &file_name, ScoresheetData &data,
+                       int *n_records = nullptr,
+                       QString *error_message = nullptr);
+    static QString journalFileName(const QString &file_name);
+
+  signals:
+    /**
+     * @brief Emitted when a record cannot be written: the following changes
+     * are no longer journaled
+     */
+    void writeError(const QString &error_message);
+    /**
+     * @brief Emitted when the journal holds COMPACTION_THRESHOLD records:
+     * the snapshot should be rewritten
+     */
+    void compactionNeeded();
+
+  private slots:
+    void turnResultInserted(int turn_index);
+    void turnResultReplaced(int turn_index);
+    void turnResultDeleted(int turn_index);
+
+  private:
+    /**
+     * @brief Append a record and schedule its sync
+     */
+    void append(char operation, int turn_index);
+
+    ScoreModel *score_model_; /**< Journaled score model */
+    QString file_name_;       /**< Snapshot file, empty if not journaling */
+    QFile journal_;           /**< Opened journal file */
+    QTimer sync_timer_;       /**< Batches the syncs of the records */
+    /** Records (lines) on top of the snapshot */
+    std::vector<QByteArray> records_;
+};
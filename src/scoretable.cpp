@@ -0,0 +1,172 @@
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+
+#include "scoretable.hpp"
+
+/** Number of turns from which score recomputation is split across threads */
+static const size_t PARALLEL_RECOMPUTE_THRESHOLD = 4096;
+
+ScoreTable::ScoreTable(int n_players, int beginning_score)
+    : n_players_(n_players), scores_(n_players, beginning_score) {}
+
+int ScoreTable::nPlayers() const { return n_players_; }
+int ScoreTable::beginningScore() const { return scores_[0]; }
+int ScoreTable::rowCount() const { return scores_.size() / n_players_; }
+int ScoreTable::score(int row, int player) const {
+    return scores_[row * n_players_ + player];
+}
+const std::vector<TurnResult> &ScoreTable::turnResults() const {
+    return turn_results_;
+}
+
+void ScoreTable::reset(int n_players, int beginning_score) {
+    n_players_ = n_players;
+    turn_results_.clear();
+    scores_ = std::vector<int>(n_players, beginning_score);
+}
+
+void ScoreTable::assign(int n_players, int beginning_score,
+                        std::vector<TurnResult> &&turn_results) {
+    n_players_ = n_players;
+    turn_results_ = std::move(turn_results);
+    turn_results.clear();
+    scores_ = std::vector<int>(n_players, beginning_score);
+    recomputeScores();
+}
+
+void ScoreTable::insertTurnResult(int turn_index,
+                                  const TurnResult &turn_result) {
+    const int n_players = n_players_;
+    std::vector<int> score_change = turn_result.computeScoreChange(n_players);
+
+    // The new turn gets row turn_index + 1
+    turn_results_.insert(turn_results_.begin() + turn_index, turn_result);
+    std::vector<int> new_row(scores_.begin() + turn_index * n_players,
+                             scores_.begin() + (turn_index + 1) * n_players);
+    for (int j = 0; j < n_players; j++) {
+        new_row[j] += score_change[j];
+    }
+    scores_.insert(scores_.begin() + (turn_index + 1) * n_players,
+                   new_row.begin(), new_row.end());
+
+    // Following turns are shifted by the score change of the new turn
+    shiftScores(turn_index + 2, score_change);
+}
+
+void ScoreTable::replaceTurnResult(int turn_index,
+                                   const TurnResult &turn_result) {
+    const int n_players = n_players_;
+    std::vector<int> score_change = turn_result.computeScoreChange(n_players);
+    std::vector<int> old_score_change =
+        turn_results_[turn_index].computeScoreChange(n_players);
+    for (int j = 0; j < n_players; j++) {
+        score_change[j] -= old_score_change[j];
+    }
+
+    turn_results_[turn_index] = turn_result;
+    shiftScores(turn_index + 1, score_change);
+}
+
+void ScoreTable::deleteTurnResult(int turn_index) {
+    const int n_players = n_players_;
+    std::vector<int> score_change =
+        turn_results_[turn_index].computeScoreChange(n_players);
+    for (int j = 0; j < n_players; j++) {
+        score_change[j] = -score_change[j];
+    }
+
+    turn_results_.erase(turn_results_.begin() + turn_index);
+    scores_.erase(scores_.begin() + (turn_index + 1) * n_players,
+                  scores_.begin() + (turn_index + 2) * n_players);
+
+    // Following turns no longer include the score change of the deleted turn
+    shiftScores(turn_index + 1, score_change);
+}
+
+void ScoreTable::shiftScores(int first_row,
+                             const std::vector<int> &score_change) {
+    const int n_players = n_players_;
+    const int n_rows = rowCount();
+    for (int i = first_row; i < n_rows; i++) {
+        for (int j = 0; j < n_players; j++) {
+            scores_[i * n_players + j] += score_change[j];
+        }
+    }
+}
+
+void ScoreTable::recomputeScores(int first_turn) {
+    const size_t n_players = static_cast<size_t>(n_players_);
+    const size_t n_turns = turn_results_.size();
+    // Keep the scores up to first_turn and make room for one row per turn
+    scores_.resize(n_players * (n_turns + 1));
+
+    if (n_turns - first_turn < PARALLEL_RECOMPUTE_THRESHOLD) {
+        // Compute each line of score depending on the result of each turn
+        for (size_t i = first_turn; i < n_turns; i++) {
+            std::vector<int> turn_score_change =
+                turn_results_[i].computeScoreChange(static_cast<int>(n_players));
+            for (size_t j = 0; j < n_players; j++) {
+                scores_[(i + 1) * n_players + j] =
+                    scores_[i * n_players + j] + turn_score_change[j];
+            }
+        }
+        return;
+    }
+
+    /* Large sheets: blocked parallel inclusive scan over the turn rows */
+    struct Block {
+        size_t begin; /**< First row of the block (included) */
+        size_t end;   /**< Last row of the block (excluded) */
+    };
+    const size_t n_new_turns = n_turns - first_turn;
+    const size_t n_blocks = std::min<size_t>(
+        n_new_turns,
+        static_cast<size_t>(std::max(1, QThread::idealThreadCount())) * 4);
+    const size_t block_size = (n_new_turns + n_blocks - 1) / n_blocks;
+    std::vector<Block> blocks;
+    for (size_t begin = first_turn + 1; begin <= n_turns;
+         begin += block_size) {
+        blocks.push_back(Block{begin, std::min(begin + block_size, n_turns + 1)});
+    }
+
+    // Each block computes the score changes of its turns and accumulates them
+    // locally, as if the block started from zero
+    QtConcurrent::blockingMap(blocks, [this, n_players](const Block &block) {
+        for (size_t row = block.begin; row < block.end; row++) {
+            std::vector<int> turn_score_change =
+                turn_results_[row - 1].computeScoreChange(
+                    static_cast<int>(n_players));
+            for (size_t j = 0; j < n_players; j++) {
+                scores_[row * n_players + j] =
+                    (row > block.begin ? scores_[(row - 1) * n_players + j]
+                                       : 0) +
+                    turn_score_change[j];
+            }
+        }
+    });
+
+    // Offset of each block: scores before first_turn plus the totals of
+    // previous blocks
+    std::vector<int> offsets(blocks.size() * n_players);
+    for (size_t j = 0; j < n_players; j++) {
+        offsets[j] = scores_[first_turn * n_players + j];
+    }
+    for (size_t b = 1; b < blocks.size(); b++) {
+        for (size_t j = 0; j < n_players; j++) {
+            offsets[b * n_players + j] =
+                offsets[(b - 1) * n_players + j] +
+                scores_[(blocks[b - 1].end - 1) * n_players + j];
+        }
+    }
+
+    // Add the offsets to every row of the blocks
+    QtConcurrent::blockingMap(
+        blocks, [this, n_players, &blocks, &offsets](const Block &block) {
+            const size_t b = &block - blocks.data();
+            for (size_t i = block.begin * n_players; i < block.end * n_players;
+                 i++) {
+                scores_[i] += offsets[b * n_players + i % n_players];
+            }
+        });
+}
\ No newline at end of file
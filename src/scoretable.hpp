@@ -0,0 +1,101 @@
+#pragma once
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "turnresult.hpp"
+
+/**
+ * @brief Turn history of a game and the resulting scores
+ *
+ * This is the scoring logic of the scoresheet, independent from any view:
+ * row 0 holds the initial scores and row i + 1 the scores after turn i. The
+ * turn history modifiers maintain the scores incrementally, only the rows
+ * from the modified turn onwards are updated.
+ */
+class ScoreTable {
+  public:
+    ScoreTable(int n_players = 3, int beginning_score = 30000);
+
+    /* Getters */
+    int nPlayers() const;
+    int beginningScore() const;
+    /**
+     * @brief Number of score rows (number of turns + 1)
+     */
+    int rowCount() const;
+    /**
+     * @brief Score of a player after the given row (0 is the initial score)
+     */
+    int score(int row, int player) const;
+    const std::vector<TurnResult> &turnResults() const;
+
+    /**
+     * @brief Empty the table and change the number of players
+     */
+    void reset(int n_players, int beginning_score);
+    /**
+     * @brief Replace the whole history, moving the turns in, and compute the
+     * scores
+     */
+    void assign(int n_players, int beginning_score,
+                std::vector<TurnResult> &&turn_results);
+
+    /* Turn history modifiers */
+    void insertTurnResult(int turn_index, const TurnResult &turn_result);
+    void replaceTurnResult(int turn_index, const TurnResult &turn_result);
+    void deleteTurnResult(int turn_index);
+
+    /**
+     * @brief Append a range of turn results at the end of the history,
+     * without computing their scores
+     *
+     * The new turns only count in rowCount() once their scores are computed
+     * by recomputeScores(), so that callers can notify the new rows in
+     * between.
+     *
+     * @return the number of appended turns
+     */
+    template <typename InputIt> int appendTurnResults(InputIt first, InputIt last);
+    /**
+     * @brief Construct a turn result in place at the end of the history,
+     * without computing its scores (see appendTurnResults())
+     */
+    template <typename... Args> void emplaceTurnResult(Args &&...args);
+
+    /**
+     * @brief Recompute the scores of the turns from first_turn onwards,
+     * depending on the turn history
+     *
+     * Large histories (such as bulk-loaded sheets) are recomputed in parallel:
+     * the score changes of each turn are computed on the thread pool and the
+     * running totals are obtained with a blocked parallel inclusive scan.
+     */
+    void recomputeScores(int first_turn = 0);
+
+  private:
+    /**
+     * @brief Add the given score changes to every row from first_row to the
+     * last one
+     */
+    void shiftScores(int first_row, const std::vector<int> &score_change);
+
+    int n_players_;                        /**< Number of players */
+    std::vector<TurnResult> turn_results_; /**< Turn results history */
+    /** Saved scores, stored row by row: scores_[i * n_players + j]
+     * corresponds to the score of player j on the i-th row */
+    std::vector<int> scores_;
+};
+
+template <typename InputIt>
+int ScoreTable::appendTurnResults(InputIt first, InputIt last) {
+    const int n_turns = turn_results_.size();
+    // Vector range insertion reserves capacity for forward iterators
+    turn_results_.insert(turn_results_.end(), first, last);
+    return turn_results_.size() - n_turns;
+}
+
+template <typename... Args>
+void ScoreTable::emplaceTurnResult(Args &&...args) {
+    turn_results_.emplace_back(std::forward<Args>(args)...);
+}
@@ -0,0 +1,528 @@
+#include <QDataStream>
+#include <QStringList>
+#include <algorithm>
+
+#include "analysiswriter.hpp"
+#include "seasonstats.hpp"
+
+/** Lowest and highest gains of a session without turns, as in
+ * scoresheet_analyzer.py */
+static const int NO_MIN_GAIN = 10000000;
+static const int NO_MAX_GAIN = 0;
+
+/**
+ * @brief Center the text in a cell of the given width
+ */
+static QString centered(const QString &text, int width) {
+    const int left = (width - text.length()) / 2;
+    return QString(left, ' ') + text +
+           QString(width - text.length() - left, ' ');
+}
+
+/**
+ * @brief Write a table with a line of headers, framed, and its caption
+ * centered below
+ */
+static void writeTable(QTextStream &out, const QString &caption,
+                       const QStringList &headers,
+                       const std::vector<QStringList> &rows) {
+    std::vector<int> widths;
+    for (const QString &header : headers) {
+        widths.push_back(header.length());
+    }
+    for (const QStringList &row : rows) {
+        for (int i = 0; i < row.size(); i++) {
+            widths[i] = std::max(widths[i], static_cast<int>(row[i].length()));
+        }
+    }
+
+    auto write_border = [&](const QString &left, const QString &middle,
+                            const QString &right) {
+        out << left;
+        for (size_t i = 0; i < widths.size(); i++) {
+            out << (i > 0 ? middle : QString())
+                << QString(widths[i] + 2, QChar(0x2500));
+        }
+        out << right << "\n";
+    };
+    auto write_row = [&](const QStringList &row) {
+        for (int i = 0; i < row.size(); i++) {
+            out << QChar(0x2502) << " " << centered(row[i], widths[i]) << " ";
+        }
+        out << QChar(0x2502) << "\n";
+    };
+
+    int table_width = 1;
+    for (const int width : widths) {
+        table_width += width + 3;
+    }
+    write_border(QChar(0x250C), QChar(0x252C), QChar(0x2510));
+    write_row(headers);
+    write_border(QChar(0x251C), QChar(0x253C), QChar(0x2524));
+    for (const QStringList &row : rows) {
+        write_row(row);
+    }
+    write_border(QChar(0x2514), QChar(0x2534), QChar(0x2518));
+    out << QString(std::max(0, (table_width - caption.length()) / 2), ' ')
+        << caption << "\n";
+}
+
+static QString formatRange(int min, double mean, int max) {
+    return QString("(%1, %2, %3)")
+        .arg(min)
+        .arg(mean, 0, 'f', 2)
+        .arg(max);
+}
+
+static QString formatWon(int n_won, int n_sessions) {
+    return QString("%1 (%2%)").arg(n_won).arg(100 * n_won / n_sessions);
+}
+
+static QString formatTsumoProportion(int tsumos, int rons) {
+    if (tsumos + rons == 0) {
+        return "nan %";
+    }
+    return QString("%1 %").arg(100 * tsumos / (tsumos + rons));
+}
+
+SeasonStats::SeasonStats(PlayerRegistry *registry) : registry_(registry) {}
+
+SeasonStats::Session SeasonStats::summarize(const ScoresheetData &data) {
+    Session session;
+    session.player_names.assign(data.player_names.begin(),
+                                data.player_names.begin() + data.n_players);
+    session.players.resize(data.n_players);
+    for (const TurnResult &turn_result : data.turn_results) {
+        const std::vector<int> score_change =
+            turn_result.computeScoreChange(data.n_players);
+        for (int i = 0; i < data.n_players; i++) {
+            PlayerSession &player = session.players[i];
+            player.min_gain = player.n_turns == 0
+                                  ? score_change[i]
+                                  : std::min(player.min_gain, score_change[i]);
+            player.max_gain = player.n_turns == 0
+                                  ? score_change[i]
+                                  : std::max(player.max_gain, score_change[i]);
+            player.gain_sum += score_change[i];
+            player.n_turns++;
+        }
+        if (!turn_result.isDraw() && !turn_result.isManualScore()) {
+            PlayerSession &winner = session.players[turn_result.winner()];
+            if (turn_result.ronVictory()) {
+                winner.rons++;
+            } else {
+                winner.tsumos++;
+            }
+            // The winner also takes the riichi sticks of the other players
+            const bool riichis[4] = {
+                turn_result.riichiPlayer1(), turn_result.riichiPlayer2(),
+                turn_result.riichiPlayer3(), turn_result.riichiPlayer4()};
+            int hand_value = score_change[turn_result.winner()];
+            for (int i = 0; i < data.n_players; i++) {
+                if (riichis[i] && i != turn_result.winner()) {
+                    hand_value -= 1000;
+                }
+            }
+            winner.hand_value_sum += hand_value;
+        }
+    }
+    return session;
+}
+
+QByteArray SeasonStats::encodeSession(const Session &session) {
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << static_cast<qint32>(session.players.size());
+    for (size_t i = 0; i < session.players.size(); i++) {
+        const PlayerSession &player = session.players[i];
+        out << session.player_names[i] << player.n_turns << player.gain_sum
+            << player.min_gain << player.max_gain << player.tsumos
+            << player.rons << player.hand_value_sum;
+    }
+    return bytes;
+}
+
+bool SeasonStats::decodeSession(const QByteArray &bytes, Session &session) {
+    QDataStream in(bytes);
+    qint32 n_players = 0;
+    in >> n_players;
+    if (n_players < 0 || n_players > 4) {
+        return false;
+    }
+    session.player_names.resize(n_players);
+    session.players.resize(n_players);
+    for (int i = 0; i < n_players; i++) {
+        PlayerSession &player = session.players[i];
+        in >> session.player_names[i] >> player.n_turns >> player.gain_sum >>
+            player.min_gain >> player.max_gain >> player.tsumos >>
+            player.rons >> player.hand_value_sum;
+    }
+    return in.status() == QDataStream::Ok && in.atEnd();
+}
+
+void SeasonStats::addSession(const Session &session) {
+    insertSession(n_sessions_, session);
+}
+
+void SeasonStats::insertSession(int index, const Session &session) {
+    for (std::vector<PlayerSession> &player_results : results_) {
+        player_results.insert(player_results.begin() + index,
+                              PlayerSession());
+    }
+    n_sessions_++;
+    setSession(index, session);
+    // The following sessions move to the next parts
+    markChanged(index / PART_SIZE, partCount());
+}
+
+void SeasonStats::replaceSession(int index, const Session &session) {
+    // Remove the previous results, then set the new ones
+    for (std::vector<PlayerSession> &player_results : results_) {
+        player_results[index] = PlayerSession();
+    }
+    setSession(index, session);
+    prunePlayers();
+    markChanged(index / PART_SIZE, index / PART_SIZE + 1);
+}
+
+void SeasonStats::removeSession(int index) {
+    for (std::vector<PlayerSession> &player_results : results_) {
+        player_results.erase(player_results.begin() + index);
+    }
+    n_sessions_--;
+    prunePlayers();
+    markChanged(index / PART_SIZE, partCount());
+}
+
+int SeasonStats::sessionCount() const { return n_sessions_; }
+
+int SeasonStats::partCount() const {
+    return (n_sessions_ + PART_SIZE - 1) / PART_SIZE;
+}
+
+PlayerRegistry &SeasonStats::registry() {
+    return registry_ != nullptr ? *registry_ : own_registry_;
+}
+
+const PlayerRegistry &SeasonStats::registry() const {
+    return registry_ != nullptr ? *registry_ : own_registry_;
+}
+
+int SeasonStats::playerIndex(const QString &name) {
+    const int id = registry().id(name);
+    if (id >= static_cast<int>(players_.size())) {
+        players_.resize(registry().count(), -1);
+    }
+    if (players_[id] < 0) {
+        players_[id] = playerCount();
+        player_ids_.push_back(id);
+        // Absent from the other sessions
+        results_.emplace_back(n_sessions_);
+        part_measures_.emplace_back();
+        markChanged(0, partCount());
+    }
+    return players_[id];
+}
+
+int SeasonStats::playerCount() const {
+    return static_cast<int>(player_ids_.size());
+}
+
+const QString &SeasonStats::playerName(int player) const {
+    return registry().name(player_ids_[player]);
+}
+
+void SeasonStats::setSession(int index, const Session &session) {
+    for (size_t i = 0; i < session.player_names.size(); i++) {
+        PlayerSession &player_session =
+            results_[playerIndex(session.player_names[i])][index];
+        player_session = session.players[i];
+        player_session.named = true;
+    }
+}
+
+void SeasonStats::prunePlayers() {
+    for (int player = playerCount() - 1; player >= 0; player--) {
+        const std::vector<PlayerSession> &player_results = results_[player];
+        if (std::none_of(player_results.begin(), player_results.end(),
+                         [](const PlayerSession &player_session) {
+                             return player_session.named;
+                         })) {
+            player_ids_.erase(player_ids_.begin() + player);
+            results_.erase(results_.begin() + player);
+            part_measures_.erase(part_measures_.begin() + player);
+        }
+    }
+    std::fill(players_.begin(), players_.end(), -1);
+    for (int player = 0; player < playerCount(); player++) {
+        players_[player_ids_[player]] = player;
+    }
+}
+
+void SeasonStats::markChanged(int first_part, int last_part) {
+    changed_parts_.resize(partCount(), true);
+    for (int part = first_part; part < std::min(last_part, partCount());
+         part++) {
+        changed_parts_[part] = true;
+    }
+}
+
+SeasonStats::Measures SeasonStats::measures(int player, int first_session,
+                                            int last_session) const {
+    Measures measures;
+    measures.n_sessions = last_session - first_session;
+    measures.min_gain = NO_MIN_GAIN;
+    bool first_played = true;
+    measures.min_score =
+        REFERENCE_SCORE + results_[player][first_session].gain_sum;
+    measures.max_score = measures.min_score;
+    for (int i = first_session; i < last_session; i++) {
+        const PlayerSession &session = results_[player][i];
+        const int score = REFERENCE_SCORE + session.gain_sum;
+        if (session.n_turns > 0) {
+            measures.present = true;
+            measures.n_played++;
+            measures.min_gain = std::min(measures.min_gain, session.min_gain);
+            measures.max_gain =
+                first_played ? session.max_gain
+                             : std::max(measures.max_gain, session.max_gain);
+            first_played = false;
+        }
+        measures.n_turns += session.n_turns;
+        measures.gain_sum += session.gain_sum;
+        measures.min_score = std::min(measures.min_score, score);
+        measures.max_score = std::max(measures.max_score, score);
+        measures.score_sum += score;
+        if (score >= REFERENCE_SCORE) {
+            measures.n_won++;
+        }
+        measures.tsumos += session.tsumos;
+        measures.rons += session.rons;
+    }
+    if (measures.n_played < measures.n_sessions) {
+        measures.max_gain = first_played
+                                ? NO_MAX_GAIN
+                                : std::max(measures.max_gain, NO_MAX_GAIN);
+    }
+    return measures;
+}
+
+void SeasonStats::updatePartMeasures() const {
+    const int n_parts = partCount();
+    changed_parts_.resize(n_parts, true);
+    for (std::vector<Measures> &player_parts : part_measures_) {
+        player_parts.resize(n_parts);
+    }
+    for (int part = 0; part < n_parts; part++) {
+        if (!changed_parts_[part]) {
+            continue;
+        }
+        const int first = part * PART_SIZE;
+        const int last = std::min(first + PART_SIZE, n_sessions_);
+        for (int player = 0; player < playerCount(); player++) {
+            part_measures_[player][part] = measures(player, first, last);
+        }
+        changed_parts_[part] = false;
+    }
+}
+
+SeasonStats::Measures SeasonStats::totalMeasures(int player) const {
+    // Like in scoresheet_analyzer.py, the extrema and the winning sessions
+    // are taken from the parts the player took part in
+    Measures total;
+    total.n_sessions = n_sessions_;
+    bool first_part = true;
+    for (const Measures &part : part_measures_[player]) {
+        total.n_played += part.n_played;
+        total.n_turns += part.n_turns;
+        total.gain_sum += part.gain_sum;
+        total.score_sum += part.score_sum;
+        total.tsumos += part.tsumos;
+        total.rons += part.rons;
+        if (!part.present) {
+            continue;
+        }
+        total.present = true;
+        total.n_won += part.n_won;
+        if (first_part) {
+            total.min_gain = part.min_gain;
+            total.max_gain = part.max_gain;
+            total.min_score = part.min_score;
+            total.max_score = part.max_score;
+            first_part = false;
+        } else {
+            total.min_gain = std::min(total.min_gain, part.min_gain);
+            total.max_gain = std::max(total.max_gain, part.max_gain);
+            total.min_score = std::min(total.min_score, part.min_score);
+            total.max_score = std::max(total.max_score, part.max_score);
+        }
+    }
+    return total;
+}
+
+void SeasonStats::writeReport(QTextStream &out) const {
+    const QString measure_header = "Mesure \\ Joueurs";
+    updatePartMeasures();
+
+    // Table over all the sessions
+    std::vector<Measures> totals;
+    for (int player = 0; player < playerCount(); player++) {
+        totals.push_back(totalMeasures(player));
+    }
+    std::vector<QStringList> rows(8);
+    rows[0] << "Parties jouées";
+    rows[1] << "Somme des gains";
+    rows[2] << "Min, moyenne et max des gains";
+    rows[3] << "Min, moyenne et max des scores";
+    rows[4] << "Nbre de parties gagnantes (%)";
+    rows[5] << "Nbre de tsumos";
+    rows[6] << "Nbre de rons";
+    rows[7] << "% de tsumos parmi les victoires";
+    for (const Measures &total : totals) {
+        rows[0] << QString::number(total.n_played);
+        rows[1] << QString::number(total.gain_sum);
+        rows[2] << (total.n_turns > 0
+                        ? formatRange(total.min_gain,
+                                      static_cast<double>(total.gain_sum) /
+                                          total.n_turns,
+                                      total.max_gain)
+                        : QString("-"));
+        rows[3] << (total.present
+                        ? formatRange(total.min_score,
+                                      static_cast<double>(total.score_sum) /
+                                          total.n_sessions,
+                                      total.max_score)
+                        : QString("-"));
+        rows[4] << formatWon(total.n_won, total.n_sessions);
+        rows[5] << QString::number(total.tsumos);
+        rows[6] << QString::number(total.rons);
+        rows[7] << formatTsumoProportion(total.tsumos, total.rons);
+    }
+    QStringList total_headers = QStringList() << measure_header;
+    for (int player = 0; player < playerCount(); player++) {
+        total_headers << playerName(player);
+    }
+    writeTable(out, "Mesures sur toutes les parties", total_headers, rows);
+
+    // Table of every part, with the players who took part in it
+    for (int part_index = 0; part_index < partCount(); part_index++) {
+        const int first = part_index * PART_SIZE;
+        const int last = std::min(first + PART_SIZE, n_sessions_);
+        QStringList headers = QStringList() << measure_header;
+        std::vector<QStringList> part_rows(7);
+        part_rows[0] << "Somme des gains";
+        part_rows[1] << "Min, moyenne et max des gains";
+        part_rows[2] << "Min, moyenne et max des scores";
+        part_rows[3] << "Nbre de parties gagnantes (%)";
+        part_rows[4] << "Nbre de tsumos";
+        part_rows[5] << "Nbre de rons";
+        part_rows[6] << "Prop de tsumos parmi les victoires";
+        for (int player = 0; player < playerCount(); player++) {
+            const Measures &part = part_measures_[player][part_index];
+            if (!part.present) {
+                continue;
+            }
+            headers << playerName(player);
+            part_rows[0] << QString::number(part.gain_sum);
+            part_rows[1] << formatRange(
+                part.min_gain,
+                static_cast<double>(part.gain_sum) / part.n_turns,
+                part.max_gain);
+            part_rows[2] << formatRange(
+                part.min_score,
+                static_cast<double>(part.score_sum) / part.n_sessions,
+                part.max_score);
+            part_rows[3] << formatWon(part.n_won, part.n_sessions);
+            part_rows[4] << QString::number(part.tsumos);
+            part_rows[5] << QString::number(part.rons);
+            part_rows[6] << formatTsumoProportion(part.tsumos, part.rons);
+        }
+        out << "\n";
+        writeTable(out,
+                   QString("Mesures sur les parties %1~%2")
+                       .arg(first + 1)
+                       .arg(last),
+                   headers, part_rows);
+    }
+}
+
+void SeasonStats::writeJson(QByteArray &out) const {
+    updatePartMeasures();
+
+    // Same measures as in the report
+    auto append_player = [&](int player, const Measures &measures) {
+        out.append("{\"name\":");
+        AnalysisWriter::appendJsonString(out, playerName(player).toUtf8());
+        out.append(",\"played\":")
+            .append(QByteArray::number(measures.n_played))
+            .append(",\"turns\":")
+            .append(QByteArray::number(measures.n_turns))
+            .append(",\"gain_sum\":")
+            .append(QByteArray::number(measures.gain_sum));
+        if (measures.n_turns > 0) {
+            out.append(",\"min_gain\":")
+                .append(QByteArray::number(measures.min_gain))
+                .append(",\"mean_gain\":")
+                .append(QByteArray::number(
+                    static_cast<double>(measures.gain_sum) / measures.n_turns,
+                    'f', 2))
+                .append(",\"max_gain\":")
+                .append(QByteArray::number(measures.max_gain));
+        }
+        if (measures.present) {
+            out.append(",\"min_score\":")
+                .append(QByteArray::number(measures.min_score))
+                .append(",\"mean_score\":")
+                .append(QByteArray::number(
+                    static_cast<double>(measures.score_sum) /
+                        measures.n_sessions,
+                    'f', 2))
+                .append(",\"max_score\":")
+                .append(QByteArray::number(measures.max_score));
+        }
+        out.append(",\"won\":")
+            .append(QByteArray::number(measures.n_won))
+            .append(",\"tsumos\":")
+            .append(QByteArray::number(measures.tsumos))
+            .append(",\"rons\":")
+            .append(QByteArray::number(measures.rons))
+            .append('}');
+    };
+
+    out.append("{\"sessions\":")
+        .append(QByteArray::number(n_sessions_))
+        .append(",\"players\":[");
+    for (int player = 0; player < playerCount(); player++) {
+        if (player > 0) {
+            out.append(',');
+        }
+        append_player(player, totalMeasures(player));
+    }
+    out.append("],\"parts\":[");
+    for (int part_index = 0; part_index < partCount(); part_index++) {
+        const int first = part_index * PART_SIZE;
+        const int last = std::min(first + PART_SIZE, n_sessions_);
+        if (part_index > 0) {
+            out.append(',');
+        }
+        out.append("{\"first\":")
+            .append(QByteArray::number(first + 1))
+            .append(",\"last\":")
+            .append(QByteArray::number(last))
+            .append(",\"players\":[");
+        bool first_player = true;
+        for (int player = 0; player < playerCount(); player++) {
+            const Measures &part = part_measures_[player][part_index];
+            if (!part.present) {
+                continue;
+            }
+            if (!first_player) {
+                out.append(',');
+            }
+            append_player(player, part);
+            first_player = false;
+        }
+        out.append("]}");
+    }
+    out.append("]}\n");
+}
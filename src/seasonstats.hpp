@@ -0,0 +1,169 @@
+#pragma once
+#include <QString>
+#include <QTextStream>
+#include <vector>
+
+#include "playerregistry.hpp"
+#include "scoresheetdata.hpp"
+
+/**
+ * @brief Statistics of the players over a season of scoresheets
+ *
+ * The sessions are summarized independently (possibly on several threads)
+ * by summarize(), then added in chronological order. The report is made of
+ * a table over all the sessions and a table for every part of PART_SIZE
+ * sessions, with the measures of scoresheet_analyzer.py (gains, end scores,
+ * winning sessions, tsumos and rons).
+ *
+ * Sessions can also be inserted, replaced or removed afterwards: the
+ * measures of each part are kept, and only the parts whose sessions changed
+ * are measured again.
+ *
+ * The players are identified by their id in a PlayerRegistry, so that the
+ * sessions recorded under an alias of a player count for that player, who is
+ * reported under its registered name.
+ */
+class SeasonStats {
+  public:
+    static const int PART_SIZE = 25;
+    /** End score of a session above which it is won, and end score of the
+     * sessions a player did not play */
+    static const int REFERENCE_SCORE = 30000;
+
+    /**
+     * @param registry resolves the player names and receives the new
+     * players; if null, each name is a distinct player
+     */
+    explicit SeasonStats(PlayerRegistry *registry = nullptr);
+
+    /**
+     * @brief Results of a player in a session
+     */
+    struct PlayerSession {
+        int n_turns = 0;  /**< Number of turns played (0 if absent) */
+        int gain_sum = 0; /**< Sum of the score changes */
+        int min_gain = 0; /**< Lowest score change of a turn */
+        int max_gain = 0; /**< Highest score change of a turn */
+        int tsumos = 0;   /**< Number of tsumo victories */
+        int rons = 0;     /**< Number of ron victories */
+        /** Sum of the points of the victories, without the riichi sticks */
+        int hand_value_sum = 0;
+        bool named = false; /**< Whether the player is in the session */
+    };
+    /**
+     * @brief Results of the players of a session
+     */
+    struct Session {
+        std::vector<QString> player_names;
+        std::vector<PlayerSession> players;
+    };
+
+    /**
+     * @brief Summarize the results of the players of a scoresheet
+     */
+    static Session summarize(const ScoresheetData &data);
+    /**
+     * @brief Serialize a session summary (e.g. to cache it)
+     */
+    static QByteArray encodeSession(const Session &session);
+    /**
+     * @brief Deserialize a session summary written by encodeSession()
+     *
+     * @return false if the bytes do not hold a session summary
+     */
+    static bool decodeSession(const QByteArray &bytes, Session &session);
+
+    /**
+     * @brief Add the next session of the season
+     */
+    void addSession(const Session &session);
+    /**
+     * @brief Insert a session before the given one
+     */
+    void insertSession(int index, const Session &session);
+    /**
+     * @brief Replace the results of a session
+     */
+    void replaceSession(int index, const Session &session);
+    /**
+     * @brief Remove a session, and the players who are not in any other one
+     */
+    void removeSession(int index);
+
+    int sessionCount() const;
+
+    /**
+     * @brief Write the table over all the sessions then the table of every
+     * part
+     */
+    void writeReport(QTextStream &out) const;
+    /**
+     * @brief Write the measures over all the sessions and over every part as
+     * a single line of JSON
+     */
+    void writeJson(QByteArray &out) const;
+
+  private:
+    /**
+     * @brief Measures of a player over a range of sessions
+     */
+    struct Measures {
+        bool present = false; /**< Whether a turn was played in the range */
+        int n_sessions = 0;   /**< Number of sessions in the range */
+        int n_played = 0;     /**< Number of sessions with turns played */
+        int n_turns = 0;
+        qint64 gain_sum = 0;
+        int min_gain = 0;
+        int max_gain = 0;
+        int min_score = 0;
+        qint64 score_sum = 0;
+        int max_score = 0;
+        int n_won = 0;
+        int tsumos = 0;
+        int rons = 0;
+    };
+
+    int partCount() const;
+    Measures measures(int player, int first_session, int last_session) const;
+    /**
+     * @brief Measure again the parts whose sessions changed
+     */
+    void updatePartMeasures() const;
+    Measures totalMeasures(int player) const;
+
+    PlayerRegistry &registry();
+    const PlayerRegistry &registry() const;
+    /**
+     * @brief Index of the player of a name or an alias, added if unknown
+     */
+    int playerIndex(const QString &name);
+    int playerCount() const;
+    const QString &playerName(int player) const;
+    /**
+     * @brief Set the results of the players of a session (a player named
+     * twice in the session keeps the results of the last seat)
+     */
+    void setSession(int index, const Session &session);
+    /**
+     * @brief Remove the players who are not in any session
+     */
+    void prunePlayers();
+    /**
+     * @brief Mark the parts in [first_part, last_part) as changed
+     */
+    void markChanged(int first_part, int last_part);
+
+    PlayerRegistry *registry_;   /**< Registry given, may be null */
+    PlayerRegistry own_registry_; /**< Registry used if none is given */
+    std::vector<int> player_ids_; /**< Players, by first appearance */
+    /** Index of the player of each registry id, -1 if not in the season,
+     * so that no name is hashed once registered */
+    std::vector<int> players_;
+    /** Results of each player (outer) in each session (inner) */
+    std::vector<std::vector<PlayerSession>> results_;
+    int n_sessions_ = 0;
+    /** Measures of each player (outer) over each part (inner) */
+    mutable std::vector<std::vector<Measures>> part_measures_;
+    /** Whether each part changed since it was last measured */
+    mutable std::vector<bool> changed_parts_;
+};
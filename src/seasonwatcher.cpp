@@ -0,0 +1,188 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <algorithm>
+#include <iostream>
+
+#include "seasonwatcher.hpp"
+
+bool SeasonWatcher::FileStamp::operator==(const FileStamp &other) const {
+    return last_modified == other.last_modified && size == other.size;
+}
+
+SeasonWatcher::SeasonWatcher(const QString &directory,
+                             AnalysisWriter::Format format,
+                             PlayerRegistry *registry, QObject *parent)
+    : QObject(parent), directory_(directory), format_(format),
+      stats_(registry) {
+    delay_timer_.setSingleShot(true);
+    delay_timer_.setInterval(REFRESH_DELAY_MS);
+    connect(&delay_timer_, &QTimer::timeout, this, &SeasonWatcher::refresh);
+    connect(&watcher_, &QFileSystemWatcher::directoryChanged, this,
+            &SeasonWatcher::schedule);
+    connect(&watcher_, &QFileSystemWatcher::fileChanged, this,
+            &SeasonWatcher::schedule);
+}
+
+bool SeasonWatcher::start(QString *error_message) {
+    if (!QFileInfo(directory_).isDir() || !watcher_.addPath(directory_)) {
+        if (error_message != nullptr) {
+            *error_message = "Can't watch the directory " + directory_;
+        }
+        return false;
+    }
+    refresh();
+    if (files_.empty()) {
+        writeStats();
+    }
+    return true;
+}
+
+void SeasonWatcher::schedule() { delay_timer_.start(); }
+
+SeasonWatcher::Summary SeasonWatcher::summarize(const Summary &file) {
+    Summary summary = file;
+    QFile scoresheet_file(file.file_name);
+    if (!scoresheet_file.open(QIODevice::ReadOnly)) {
+        summary.error_message = "Error when opening scoresheet file (" +
+                                scoresheet_file.errorString() + ")";
+        return summary;
+    }
+    const QByteArray content = scoresheet_file.readAll();
+    ScoresheetData data;
+    QString parse_error;
+    if (!ScoresheetData::read(content.constData(),
+                              content.constData() + content.size(), data,
+                              &parse_error)) {
+        summary.error_message =
+            "Error when parsing scoresheet file (" + parse_error + ")";
+        return summary;
+    }
+    summary.session = SeasonStats::summarize(data);
+    summary.ok = true;
+    return summary;
+}
+
+void SeasonWatcher::refresh() {
+    const QFileInfoList infos = QDir(directory_).entryInfoList(
+        QStringList() << "*.mss"
+                      << "*.mssb",
+        QDir::Files, QDir::Name);
+    QSet<QString> file_names;
+    for (const QFileInfo &info : infos) {
+        file_names.insert(info.filePath());
+    }
+    bool changed = false;
+
+    // Sessions of the removed scoresheets, from the last one so that the
+    // indices stay valid
+    for (int i = static_cast<int>(files_.size()) - 1; i >= 0; i--) {
+        if (!file_names.contains(files_[i].file_name)) {
+            stats_.removeSession(i);
+            files_.erase(files_.begin() + i);
+            changed = true;
+        }
+    }
+    for (auto failed = failed_files_.begin(); failed != failed_files_.end();) {
+        if (file_names.contains(failed.key())) {
+            ++failed;
+        } else {
+            failed = failed_files_.erase(failed);
+        }
+    }
+
+    // Added and modified scoresheets, summarized on the thread pool
+    QSet<QString> watched_files;
+    for (const QString &watched_file : watcher_.files()) {
+        watched_files.insert(watched_file);
+    }
+    std::vector<Summary> modified_files;
+    for (const QFileInfo &info : infos) {
+        const QString file_name = info.filePath();
+        // Saving a file may replace it, which ends its watch
+        if (!watched_files.contains(file_name)) {
+            watcher_.addPath(file_name);
+        }
+        Summary file;
+        file.file_name = file_name;
+        file.stamp = FileStamp{info.lastModified(), info.size()};
+        const auto summarized = std::lower_bound(
+            files_.begin(), files_.end(), file_name,
+            [](const SummarizedFile &summarized_file, const QString &name) {
+                return summarized_file.file_name < name;
+            });
+        const auto failed = failed_files_.constFind(file_name);
+        const bool unchanged = summarized != files_.end() &&
+                               summarized->file_name == file_name &&
+                               summarized->stamp == file.stamp;
+        const bool still_failed = failed != failed_files_.constEnd() &&
+                                  failed.value() == file.stamp;
+        if (unchanged || still_failed) {
+            continue;
+        }
+        modified_files.push_back(file);
+    }
+    const QFuture<Summary> summaries =
+        QtConcurrent::mapped(modified_files, &SeasonWatcher::summarize);
+
+    // Only the parts of the season whose sessions changed are measured again
+    for (int i = 0; i < static_cast<int>(modified_files.size()); i++) {
+        const Summary summary = summaries.resultAt(i);
+        const auto summarized = std::lower_bound(
+            files_.begin(), files_.end(), summary.file_name,
+            [](const SummarizedFile &summarized_file, const QString &name) {
+                return summarized_file.file_name < name;
+            });
+        const int index = summarized - files_.begin();
+        const bool known = summarized != files_.end() &&
+                           summarized->file_name == summary.file_name;
+        if (!summary.ok) {
+            std::cerr << summary.file_name.toStdString() << ": "
+                      << summary.error_message.toStdString() << std::endl;
+            failed_files_.insert(summary.file_name, summary.stamp);
+            if (known) {
+                stats_.removeSession(index);
+                files_.erase(summarized);
+                changed = true;
+            }
+            continue;
+        }
+        failed_files_.remove(summary.file_name);
+        if (known) {
+            stats_.replaceSession(index, summary.session);
+            summarized->stamp = summary.stamp;
+        } else {
+            stats_.insertSession(index, summary.session);
+            files_.insert(summarized,
+                          SummarizedFile{summary.file_name, summary.stamp});
+        }
+        changed = true;
+    }
+
+    if (changed) {
+        writeStats();
+    }
+}
+
+void SeasonWatcher::writeStats() const {
+    if (format_ == AnalysisWriter::Format::JSONL) {
+        QByteArray json;
+        stats_.writeJson(json);
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+        out.write(json);
+        return;
+    }
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+    if (stats_.sessionCount() == 0) {
+        out << "No scoresheet to summarize\n";
+    } else {
+        stats_.writeReport(out);
+    }
+    out << "\n";
+    out.flush();
+}
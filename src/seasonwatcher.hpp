@@ -0,0 +1,102 @@
+#pragma once
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <vector>
+
+#include "analysiswriter.hpp"
+#include "seasonstats.hpp"
+
+/**
+ * @brief Statistics of a directory of scoresheets, kept up to date while the
+ * scoresheets are added, edited or removed
+ *
+ * The scoresheets are the sessions of the season, in the order of their
+ * names. When the directory or one of its scoresheets changes (debounced by
+ * REFRESH_DELAY_MS), only the added and modified scoresheets are parsed
+ * again, their sessions are replaced in the statistics, and the report (or
+ * its JSON line) is written again to the standard output.
+ */
+class SeasonWatcher : public QObject {
+    Q_OBJECT
+  public:
+    static const int REFRESH_DELAY_MS = 100; /**< Delay after a change */
+
+    /**
+     * @param format TEXT for the report, JSONL for a JSON line per refresh
+     * @param registry resolves the player names, may be null (see
+     * SeasonStats)
+     */
+    SeasonWatcher(const QString &directory, AnalysisWriter::Format format,
+                  PlayerRegistry *registry = nullptr,
+                  QObject *parent = nullptr);
+
+    /**
+     * @brief Watch the directory, after writing the statistics of its
+     * current scoresheets
+     *
+     * @return false if the directory can't be watched
+     */
+    bool start(QString *error_message = nullptr);
+
+  private slots:
+    /**
+     * @brief Refresh once no change happened for REFRESH_DELAY_MS
+     */
+    void schedule();
+    /**
+     * @brief Summarize the added and modified scoresheets, and write the
+     * statistics if any session changed
+     */
+    void refresh();
+
+  private:
+    /**
+     * @brief Version of a scoresheet file, to tell whether it was modified
+     */
+    struct FileStamp {
+        QDateTime last_modified;
+        qint64 size;
+
+        bool operator==(const FileStamp &other) const;
+    };
+    /**
+     * @brief Scoresheet whose session is in the statistics
+     */
+    struct SummarizedFile {
+        QString file_name; /**< Name in the directory */
+        FileStamp stamp;
+    };
+    /**
+     * @brief Summary of a scoresheet, or the reason it failed
+     */
+    struct Summary {
+        QString file_name;
+        FileStamp stamp;
+        bool ok = false;
+        QString error_message;
+        SeasonStats::Session session;
+    };
+
+    /**
+     * @brief Read and summarize a scoresheet, run on the thread pool
+     */
+    static Summary summarize(const Summary &file);
+    /**
+     * @brief Write the report or the JSON line, and flush it
+     */
+    void writeStats() const;
+
+    QString directory_;
+    AnalysisWriter::Format format_;
+    QFileSystemWatcher watcher_;
+    QTimer delay_timer_; /**< Debounces the changes */
+    /** Scoresheets in the statistics, sorted by name like their sessions */
+    std::vector<SummarizedFile> files_;
+    /** Scoresheets that failed, only retried once modified */
+    QHash<QString, FileStamp> failed_files_;
+    SeasonStats stats_;
+};
@@ -135,10 +135,11 @@ ShowDetailDialog::ShowDetailDialog(QWidget *parent,
 
     if (turn_result.hand() != nullptr) {
         QGroupBox *hand_details = new QGroupBox(tr("Hand details"));
-        QLabel *hand_score =
-            new QLabel(turn_result.hand()->computeScore().toString());
+        QLabel *hand_score = new QLabel(QString::fromStdString(
+            turn_result.hand()->computeScore().toString()));
 
-        QLabel *hand_draw = new QLabel(turn_result.hand()->toUTF8Symbols());
+        QLabel *hand_draw = new QLabel(
+            QString::fromStdString(turn_result.hand()->toUTF8Symbols()));
         hand_draw->setAlignment(Qt::AlignCenter);
         hand_draw->setStyleSheet("font-size: 48pt");
         QVBoxLayout *hand_layout = new QVBoxLayout;
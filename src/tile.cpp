@@ -1,12 +1,19 @@
 #include "tile.hpp"
 
 Tile::Tile(char suit, int value) : suit_(suit), value_(value) {}
-Tile::Tile(const QString &descr) {
-    suit_ = descr[1].unicode();
-    value_ = descr[0].digitValue();
+bool Tile::fromString(std::string_view str, Tile &tile) {
+    if (str.size() != 2 || str[0] < '1' || str[0] > '9' ||
+        (str[1] != BAMBOO && str[1] != CHARACTER && str[1] != DOT &&
+         str[1] != HONOR)) {
+        return false;
+    }
+    tile = Tile(str[1], str[0] - '0');
+    return true;
+}
+std::string Tile::toString() const {
+    return {static_cast<char>('0' + value_), suit_};
 }
-QString Tile::toString() const { return QString::number(value_) + suit_; }
-QString Tile::toUTF8() const {
+std::string Tile::toUTF8() const {
     char32_t code = 0x1F000; // 1F000 is the base for Mahjong tiles in Unicode
     if (suit_ == HONOR) {
         if (value_ <= 4) {
@@ -21,8 +28,11 @@ QString Tile::toUTF8() const {
     } else {
         code += 24 + value_;
     }
-    char32_t tile[1] = {code};
-    return QString::fromUcs4(tile, 1);
+    // Mahjong tiles are outside of the BMP, they take 4 bytes in UTF-8
+    return {static_cast<char>(0xF0 | (code >> 18)),
+            static_cast<char>(0x80 | ((code >> 12) & 0x3F)),
+            static_cast<char>(0x80 | ((code >> 6) & 0x3F)),
+            static_cast<char>(0x80 | (code & 0x3F))};
 }
 
 char Tile::suit() const { return suit_; }
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <QString>
+#include <string>
+#include <string_view>
 
 static const char BAMBOO = 's';
 static const char CHARACTER = 'm';
@@ -20,9 +21,17 @@ enum class HonorValue {
 class Tile {
   public:
     Tile(char suit = BAMBOO, int value = 1);
-    Tile(const QString &descr);
-    QString toString() const;
-    QString toUTF8() const;
+    /**
+     * @brief Parse a tile written as its value then its suit (e.g. 5p)
+     *
+     * @return false if the string is not exactly a tile
+     */
+    static bool fromString(std::string_view str, Tile &tile);
+    std::string toString() const;
+    /**
+     * @brief Unicode symbol of the tile, encoded in UTF-8
+     */
+    std::string toUTF8() const;
     char suit() const;
     int value() const;
     bool isHonor() const;
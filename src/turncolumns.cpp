@@ -0,0 +1,249 @@
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+
+#include "handdictionary.hpp"
+#include "turncolumns.hpp"
+
+/** Number of turns from which repricing is split across threads */
+static const int PARALLEL_REPRICE_THRESHOLD = 1 << 16;
+
+void TurnColumns::addGame(const ScoresheetData &data) {
+    const int game = gameCount();
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        game_players_.push_back(
+            seat < data.n_players ? playerIndex(data.player_names[seat]) : -1);
+    }
+
+    const int first_turn = turnCount();
+    const size_t n_turns = first_turn + data.turn_results.size();
+    game_ids_.reserve(n_turns);
+    turn_indices_.reserve(n_turns);
+    player_counts_.reserve(n_turns);
+    east_players_.reserve(n_turns);
+    outcomes_.reserve(n_turns);
+    winners_.reserve(n_turns);
+    losers_.reserve(n_turns);
+    fu_scores_.reserve(n_turns);
+    fan_scores_.reserve(n_turns);
+    yaku_masks_.reserve(n_turns);
+    riichi_masks_.reserve(n_turns);
+    for (std::vector<qint32> &score_changes : score_changes_) {
+        score_changes.reserve(n_turns);
+    }
+
+    for (size_t turn = 0; turn < data.turn_results.size(); turn++) {
+        const TurnResult &result = data.turn_results[turn];
+        const TurnOutcome outcome = result.outcome();
+        const bool victory =
+            outcome == TurnOutcome::TSUMO || outcome == TurnOutcome::RON;
+        game_ids_.push_back(game);
+        turn_indices_.push_back(turn);
+        player_counts_.push_back(data.n_players);
+        east_players_.push_back(result.eastPlayer());
+        outcomes_.push_back(outcome);
+        winners_.push_back(victory ? result.winner() : NO_PLAYER);
+        losers_.push_back(outcome == TurnOutcome::RON ? result.loser()
+                                                      : NO_PLAYER);
+        // Negative scores pay like 0 in the tables
+        const int fu = std::min(std::max(result.fuScore(), 0), 0xFFFF);
+        const int fan = std::min(std::max(result.fanScore(), 0), 0xFFFF);
+        fu_scores_.push_back(victory ? fu : 0);
+        fan_scores_.push_back(victory ? fan : 0);
+        yaku_masks_.push_back(
+            victory && result.hand() != nullptr
+                ? HandDictionary::instance().score(*result.hand()).yakuMask()
+                : 0);
+        quint8 riichi_mask = 0;
+        if (victory) {
+            const bool riichis[MAX_PLAYERS] = {
+                result.riichiPlayer1(), result.riichiPlayer2(),
+                result.riichiPlayer3(), result.riichiPlayer4()};
+            for (int seat = 0; seat < data.n_players; seat++) {
+                riichi_mask |= riichis[seat] ? 1 << seat : 0;
+            }
+        }
+        riichi_masks_.push_back(riichi_mask);
+        // The score changes of the victories are computed below
+        const std::vector<int> score_change =
+            victory ? std::vector<int>()
+                    : result.computeScoreChange(data.n_players);
+        for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+            score_changes_[seat].push_back(
+                seat < static_cast<int>(score_change.size())
+                    ? score_change[seat]
+                    : 0);
+        }
+    }
+    qint32 *const score_changes[MAX_PLAYERS] = {
+        score_changes_[0].data(), score_changes_[1].data(),
+        score_changes_[2].data(), score_changes_[3].data()};
+    VictoryPayments::computeScoreChanges(
+        victoryColumns(fu_scores_.data(), fan_scores_.data()), first_turn,
+        turnCount(), score_changes);
+    game_begins_.push_back(turnCount());
+}
+
+void TurnColumns::clear() { *this = TurnColumns(); }
+
+int TurnColumns::gameCount() const { return game_begins_.size() - 1; }
+int TurnColumns::turnCount() const { return outcomes_.size(); }
+int TurnColumns::gameBegin(int game) const { return game_begins_[game]; }
+const QStringList &TurnColumns::playerNames() const { return player_names_; }
+int TurnColumns::gamePlayer(int game, int seat) const {
+    return game_players_[game * MAX_PLAYERS + seat];
+}
+
+const std::vector<quint32> &TurnColumns::gameIds() const { return game_ids_; }
+const std::vector<quint32> &TurnColumns::turnIndices() const {
+    return turn_indices_;
+}
+const std::vector<quint8> &TurnColumns::playerCounts() const {
+    return player_counts_;
+}
+const std::vector<quint8> &TurnColumns::eastPlayers() const {
+    return east_players_;
+}
+const std::vector<TurnOutcome> &TurnColumns::outcomes() const {
+    return outcomes_;
+}
+const std::vector<quint8> &TurnColumns::winners() const { return winners_; }
+const std::vector<quint8> &TurnColumns::losers() const { return losers_; }
+const std::vector<quint16> &TurnColumns::fuScores() const {
+    return fu_scores_;
+}
+const std::vector<quint16> &TurnColumns::fanScores() const {
+    return fan_scores_;
+}
+const std::vector<quint32> &TurnColumns::yakuMasks() const {
+    return yaku_masks_;
+}
+const std::vector<quint8> &TurnColumns::riichiMasks() const {
+    return riichi_masks_;
+}
+const std::vector<qint32> &TurnColumns::scoreChanges(int seat) const {
+    return score_changes_[seat];
+}
+
+std::vector<double> TurnColumns::averageRonValues() const {
+    std::vector<qint64> value_sums(player_names_.size(), 0);
+    std::vector<int> n_rons(player_names_.size(), 0);
+    const TurnOutcome *outcomes = outcomes_.data();
+    const quint8 *winners = winners_.data();
+    const quint8 *riichi_masks = riichi_masks_.data();
+    for (int game = 0; game < gameCount(); game++) {
+        const int begin = game_begins_[game];
+        const int end = game_begins_[game + 1];
+        for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+            const int player = gamePlayer(game, seat);
+            if (player < 0) {
+                continue;
+            }
+            // Branchless, so that the loop is vectorized
+            const qint32 *score_changes = score_changes_[seat].data();
+            const quint8 other_seats = ~(1 << seat);
+            qint64 value_sum = 0;
+            int n_seat_rons = 0;
+            for (int turn = begin; turn < end; turn++) {
+                const bool ron = (outcomes[turn] == TurnOutcome::RON) &
+                                 (winners[turn] == seat);
+                const int riichi_sticks =
+                    1000 * riichiCount(riichi_masks[turn] & other_seats);
+                value_sum += ron ? score_changes[turn] - riichi_sticks : 0;
+                n_seat_rons += ron;
+            }
+            value_sums[player] += value_sum;
+            n_rons[player] += n_seat_rons;
+        }
+    }
+
+    std::vector<double> average_values(player_names_.size(), 0.0);
+    for (int player = 0; player < player_names_.size(); player++) {
+        if (n_rons[player] > 0) {
+            average_values[player] =
+                static_cast<double>(value_sums[player]) / n_rons[player];
+        }
+    }
+    return average_values;
+}
+
+std::vector<double> TurnColumns::dealInRates() const {
+    std::vector<double> rates(MAX_PLAYERS, 0.0);
+    const int n_turns = turnCount();
+    const TurnOutcome *outcomes = outcomes_.data();
+    const quint8 *losers = losers_.data();
+    const quint8 *player_counts = player_counts_.data();
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        int n_deal_ins = 0;
+        int n_played = 0;
+        for (int turn = 0; turn < n_turns; turn++) {
+            n_deal_ins += (outcomes[turn] == TurnOutcome::RON) &
+                          (losers[turn] == seat);
+            n_played += player_counts[turn] > seat;
+        }
+        if (n_played > 0) {
+            rates[seat] = static_cast<double>(n_deal_ins) / n_played;
+        }
+    }
+    return rates;
+}
+
+bool TurnColumns::repriceVictories(
+    const std::vector<quint16> &fu_scores,
+    const std::vector<quint16> &fan_scores,
+    std::vector<qint32> score_changes[MAX_PLAYERS]) const {
+    const int n_turns = turnCount();
+    // The kernel reads the scores of every turn
+    if (static_cast<int>(fu_scores.size()) != n_turns ||
+        static_cast<int>(fan_scores.size()) != n_turns) {
+        return false;
+    }
+    qint32 *changes[MAX_PLAYERS];
+    for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+        // Draws and manual scores are unchanged
+        score_changes[seat] = score_changes_[seat];
+        changes[seat] = score_changes[seat].data();
+    }
+    const VictoryPayments::Turns turns =
+        victoryColumns(fu_scores.data(), fan_scores.data());
+    if (n_turns < PARALLEL_REPRICE_THRESHOLD) {
+        VictoryPayments::computeScoreChanges(turns, 0, n_turns, changes);
+        return true;
+    }
+
+    // Large corpora are split in ranges of turns priced on the thread pool
+    const int n_ranges = std::max(1, QThread::idealThreadCount()) * 4;
+    const int range_size = (n_turns + n_ranges - 1) / n_ranges;
+    std::vector<int> range_begins;
+    for (int begin = 0; begin < n_turns; begin += range_size) {
+        range_begins.push_back(begin);
+    }
+    QtConcurrent::blockingMap(range_begins, [&](const int &begin) {
+        VictoryPayments::computeScoreChanges(
+            turns, begin, std::min(begin + range_size, n_turns), changes);
+    });
+    return true;
+}
+
+int TurnColumns::riichiCount(quint8 riichi_mask) {
+    return (riichi_mask & 1) + ((riichi_mask >> 1) & 1) +
+           ((riichi_mask >> 2) & 1) + ((riichi_mask >> 3) & 1);
+}
+
+VictoryPayments::Turns
+TurnColumns::victoryColumns(const quint16 *fu_scores,
+                            const quint16 *fan_scores) const {
+    return VictoryPayments::Turns{
+        player_counts_.data(), east_players_.data(), outcomes_.data(),
+        winners_.data(),       losers_.data(),       fu_scores,
+        fan_scores,            riichi_masks_.data()};
+}
+
+int TurnColumns::playerIndex(const QString &name) {
+    auto player = players_.find(name);
+    if (player == players_.end()) {
+        player = players_.insert(name, player_names_.size());
+        player_names_ << name;
+    }
+    return player.value();
+}
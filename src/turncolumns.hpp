@@ -0,0 +1,137 @@
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+#include <vector>
+
+#include "scoresheetdata.hpp"
+#include "victorypayments.hpp"
+
+/**
+ * @brief Turns of many games stored column by column, for corpus analytics
+ *
+ * Each field of the turns (game, turn index, outcome, winner, loser, fu,
+ * fan, yakus, riichis and score change of each seat) is a separate
+ * contiguous array, so that a query only reads the columns it needs, in
+ * loops simple enough to be vectorized by the compiler. The turns of a game
+ * are contiguous, from gameBegin(game) to gameBegin(game + 1), and the
+ * players are identified across games by their names.
+ *
+ * The score changes of the victories are computed from the columns by
+ * VictoryPayments, a whole game at once.
+ */
+class TurnColumns {
+  public:
+    static const int MAX_PLAYERS = VictoryPayments::MAX_PLAYERS;
+    /** Winner and loser of the turns that have none */
+    static const quint8 NO_PLAYER = 0xFF;
+
+    /**
+     * @brief Append the turns of a game
+     *
+     * The yakus of the victories are computed from their winning hands, when
+     * known.
+     */
+    void addGame(const ScoresheetData &data);
+    void clear();
+
+    int gameCount() const;
+    int turnCount() const;
+    /**
+     * @brief Index of the first turn of a game (turnCount() for gameCount())
+     */
+    int gameBegin(int game) const;
+    /**
+     * @brief Players of all the games, by order of first appearance
+     */
+    const QStringList &playerNames() const;
+    /**
+     * @brief Index in playerNames() of the player of a seat, -1 if none
+     */
+    int gamePlayer(int game, int seat) const;
+
+    /* Columns, with a value per turn */
+    const std::vector<quint32> &gameIds() const;
+    const std::vector<quint32> &turnIndices() const;
+    const std::vector<quint8> &playerCounts() const;
+    const std::vector<quint8> &eastPlayers() const;
+    const std::vector<TurnOutcome> &outcomes() const;
+    /** NO_PLAYER for draws and manual scores */
+    const std::vector<quint8> &winners() const;
+    /** NO_PLAYER unless the turn is a ron */
+    const std::vector<quint8> &losers() const;
+    /** 0 for draws and manual scores */
+    const std::vector<quint16> &fuScores() const;
+    const std::vector<quint16> &fanScores() const;
+    /** HandScore::yakuMask() of the winning hand, 0 if unknown */
+    const std::vector<quint32> &yakuMasks() const;
+    /** Bit i is set if the player of seat i is riichi (0 unless victory) */
+    const std::vector<quint8> &riichiMasks() const;
+    /** Score changes of the player of a seat (0 if no player) */
+    const std::vector<qint32> &scoreChanges(int seat) const;
+
+    /* Queries */
+    /**
+     * @brief Average points won by each player (by index in playerNames())
+     * with a ron, riichi sticks excluded, 0 if none
+     */
+    std::vector<double> averageRonValues() const;
+    /**
+     * @brief Proportion of the turns played in each seat which ended by a ron
+     * paid by that seat
+     */
+    std::vector<double> dealInRates() const;
+    /**
+     * @brief Score changes of every turn if the victories had the given fu
+     * and fan scores (e.g. to price them with other rules)
+     *
+     * @param fu_scores fu score of each turn (ignored for draws and manual
+     * scores)
+     * @param fan_scores fan score of each turn
+     * @param score_changes receives the score changes of each seat
+     * @return false (leaving score_changes as is) if there isn't a fu and a
+     * fan score per turn
+     */
+    bool repriceVictories(const std::vector<quint16> &fu_scores,
+                          const std::vector<quint16> &fan_scores,
+                          std::vector<qint32> score_changes[MAX_PLAYERS]) const;
+
+    /**
+     * @brief Number of riichi players in a riichi mask
+     */
+    static int riichiCount(quint8 riichi_mask);
+
+  private:
+    /**
+     * @brief Columns read by VictoryPayments, with the given fu and fan
+     * scores
+     */
+    VictoryPayments::Turns victoryColumns(const quint16 *fu_scores,
+                                          const quint16 *fan_scores) const;
+    /**
+     * @brief Index of a player, added if unknown
+     */
+    int playerIndex(const QString &name);
+
+    QStringList player_names_;    /**< Players, by first appearance */
+    QHash<QString, int> players_; /**< Index of each player */
+    /** First turn of each game, and the number of turns at the end */
+    std::vector<int> game_begins_ = {0};
+    /** Player of each seat of each game: game_players_[game * MAX_PLAYERS +
+     * seat], -1 if none */
+    std::vector<int> game_players_;
+
+    std::vector<quint32> game_ids_;
+    std::vector<quint32> turn_indices_;
+    std::vector<quint8> player_counts_;
+    std::vector<quint8> east_players_;
+    std::vector<TurnOutcome> outcomes_;
+    std::vector<quint8> winners_;
+    std::vector<quint8> losers_;
+    std::vector<quint16> fu_scores_;
+    std::vector<quint16> fan_scores_;
+    std::vector<quint32> yaku_masks_;
+    std::vector<quint8> riichi_masks_;
+    std::vector<qint32> score_changes_[MAX_PLAYERS];
+};
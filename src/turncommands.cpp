@@ -0,0 +1,49 @@
+#include <QObject>
+
+#include "turncommands.hpp"
+
+AddTurnCommand::AddTurnCommand(ScoreModel *score_model,
+                               const TurnResult &turn_result,
+                               QUndoCommand *parent)
+    : QUndoCommand(parent), score_model_(score_model),
+      turn_result_(turn_result),
+      turn_index_(score_model->turnResults().size()) {
+    setText(QObject::tr("add turn %1").arg(turn_index_ + 1));
+}
+
+void AddTurnCommand::undo() { score_model_->deleteTurnResult(turn_index_); }
+
+void AddTurnCommand::redo() {
+    score_model_->insertTurnResult(turn_index_, turn_result_);
+}
+
+DeleteTurnCommand::DeleteTurnCommand(ScoreModel *score_model, int turn_index,
+                                     QUndoCommand *parent)
+    : QUndoCommand(parent), score_model_(score_model),
+      turn_result_(score_model->turnResults().at(turn_index)),
+      turn_index_(turn_index) {
+    setText(QObject::tr("delete turn %1").arg(turn_index_ + 1));
+}
+
+void DeleteTurnCommand::undo() {
+    score_model_->insertTurnResult(turn_index_, turn_result_);
+}
+
+void DeleteTurnCommand::redo() { score_model_->deleteTurnResult(turn_index_); }
+
+EditTurnCommand::EditTurnCommand(ScoreModel *score_model, int turn_index,
+                                 const TurnResult &turn_result,
+                                 QUndoCommand *parent)
+    : QUndoCommand(parent), score_model_(score_model),
+      old_turn_result_(score_model->turnResults().at(turn_index)),
+      new_turn_result_(turn_result), turn_index_(turn_index) {
+    setText(QObject::tr("edit turn %1").arg(turn_index_ + 1));
+}
+
+void EditTurnCommand::undo() {
+    score_model_->replaceTurnResult(turn_index_, old_turn_result_);
+}
+
+void EditTurnCommand::redo() {
+    score_model_->replaceTurnResult(turn_index_, new_turn_result_);
+}
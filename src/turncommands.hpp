@@ -0,0 +1,58 @@
+#pragma once
+#include <QUndoCommand>
+
+#include "scoremodel.hpp"
+#include "turnresult.hpp"
+
+/**
+ * @brief Undoable command adding a turn result at the end of the scoresheet
+ */
+class AddTurnCommand : public QUndoCommand {
+  public:
+    AddTurnCommand(ScoreModel *score_model, const TurnResult &turn_result,
+                   QUndoCommand *parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+  private:
+    ScoreModel *score_model_; /**< The scoresheet model */
+    TurnResult turn_result_;  /**< The added turn result */
+    int turn_index_;          /**< Index of the added turn */
+};
+
+/**
+ * @brief Undoable command deleting a turn result of the scoresheet
+ */
+class DeleteTurnCommand : public QUndoCommand {
+  public:
+    DeleteTurnCommand(ScoreModel *score_model, int turn_index,
+                      QUndoCommand *parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+  private:
+    ScoreModel *score_model_; /**< The scoresheet model */
+    TurnResult turn_result_;  /**< The deleted turn result */
+    int turn_index_;          /**< Index of the deleted turn */
+};
+
+/**
+ * @brief Undoable command replacing a turn result of the scoresheet
+ */
+class EditTurnCommand : public QUndoCommand {
+  public:
+    EditTurnCommand(ScoreModel *score_model, int turn_index,
+                    const TurnResult &turn_result,
+                    QUndoCommand *parent = nullptr);
+
+    void undo() override;
+    void redo() override;
+
+  private:
+    ScoreModel *score_model_;    /**< The scoresheet model */
+    TurnResult old_turn_result_; /**< The turn result before edition */
+    TurnResult new_turn_result_; /**< The turn result after edition */
+    int turn_index_;             /**< Index of the edited turn */
+};
@@ -1,4 +1,5 @@
 #include "turnresult.hpp"
+#include "victorypayments.hpp"
 #include "winning_hand.hpp"
 #include <iostream>
 
@@ -12,58 +13,16 @@ TurnResult::TurnResult(int _east_player, int _winner, int _ron_victory,
       riichi_player_4(_riichi_player_4), fu_score_(_fu_score),
       fan_score_(_fan_score), hand_(hand) {}
 
-TurnResult::TurnResult(const std::vector<int> &scores)
-    : ron_victory_(2), scores_(scores), hand_(nullptr) {}
-
-TurnResult::TurnResult(const std::vector<bool> &players_tenpai)
-    : ron_victory_(3), players_tenpai_(players_tenpai), hand_(nullptr) {}
-
-TurnResult::TurnResult(int n_players, QString *description) : TurnResult() {
-    QTextStream in(description);
-
-    int r1, r2, r3, r4;
-
-    in >> east_player_ >> winner_ >> ron_victory_;
-    if (ron_victory_ <= 1) {
-        in >> loser_ >> r1 >> r2 >> r3 >> r4 >> fu_score_ >> fan_score_;
-
-        riichi_player_1 = r1 != 0;
-        riichi_player_2 = r2 != 0;
-        riichi_player_3 = r3 != 0;
-        riichi_player_4 = r4 != 0;
+TurnResult::TurnResult(const std::vector<int> &scores, int _east_player,
+                       int _winner)
+    : TurnResult(_east_player, _winner, 2) {
+    scores_ = scores;
+}
 
-        QString hand_string;
-        in >> hand_string;
-        if (hand_string.length() > 0) {
-            hand_ = new WinningHand(hand_string,
-                                    (winner_ == 0 && riichi_player_1) ||
-                                        (winner_ == 1 && riichi_player_2) ||
-                                        (winner_ == 2 && riichi_player_3) ||
-                                        (winner_ == 3 && riichi_player_4),
-                                    ron_victory_ == 1);
-        }
-    } else if (ron_victory_ == 2) { // Manual result
-        if (n_players == 3) {
-            scores_ = std::vector<int>(3, 0);
-            in >> scores_[0] >> scores_[1] >> scores_[2];
-        } else if (n_players == 4) {
-            scores_ = std::vector<int>(4, 0);
-            in >> scores_[0] >> scores_[1] >> scores_[2] >> scores_[3];
-        }
-    } else if (ron_victory_ == 3) { // Draw
-        int temp = 0;
-        players_tenpai_ = std::vector<bool>(n_players, false);
-        in >> temp;
-        players_tenpai_[0] = (temp == 1);
-        in >> temp;
-        players_tenpai_[1] = (temp == 1);
-        in >> temp;
-        players_tenpai_[2] = (temp == 1);
-        if (n_players == 4) {
-            in >> temp;
-            players_tenpai_[3] = (temp == 1);
-        }
-    }
+TurnResult::TurnResult(const std::vector<bool> &players_tenpai,
+                       int _east_player, int _winner)
+    : TurnResult(_east_player, _winner, 3) {
+    players_tenpai_ = players_tenpai;
 }
 
 std::vector<int> TurnResult::computeScoreChange(int n_players) const {
@@ -163,7 +122,7 @@ void TurnResult::writeToTextStream(QTextStream &out) const {
             << riichi_player_3 << " " << riichi_player_4 << " " << fu_score_
             << " " << fan_score_;
         if (hand_ != nullptr) {
-            out << " " << hand_->toString();
+            out << " " << hand_->toString().c_str();
         }
     } else if (isManualScore()) { // Manual score
         out << east_player_ << " " << winner_ << " " << ron_victory_ << " "
@@ -195,338 +154,34 @@ int TurnResult::fanScore() const { return fan_score_; }
 const WinningHand *TurnResult::hand() const { return hand_; }
 bool TurnResult::isManualScore() const { return (ron_victory_ == 2); }
 bool TurnResult::isDraw() const { return (ron_victory_ == 3); }
+TurnOutcome TurnResult::outcome() const {
+    if (isDraw()) {
+        return TurnOutcome::DRAW;
+    } else if (isManualScore()) {
+        return TurnOutcome::MANUAL;
+    } else if (ron_victory_ == 1) {
+        return TurnOutcome::RON;
+    }
+    return TurnOutcome::TSUMO;
+}
 const std::vector<bool> &TurnResult::playersTenpai() const {
     return players_tenpai_;
 }
+const std::vector<int> &TurnResult::manualScores() const { return scores_; }
 
 int TurnResult::Tabular1(int fu, int fan) {
-    if (fan == 1) {
-        if (fu <= 20) {
-            return 0;
-        } else if (fu == 25) {
-            return 0;
-        } else if (fu <= 30) {
-            return 500;
-        } else if (fu <= 40) {
-            return 700;
-        } else if (fu <= 50) {
-            return 800;
-        } else if (fu <= 60) {
-            return 1000;
-        } else if (fu <= 70) {
-            return 1200;
-        } else if (fu <= 80) {
-            return 1300;
-        } else {
-            return 1500;
-        }
-    } else if (fan == 2) {
-        if (fu <= 20) {
-            return 700;
-        } else if (fu == 25) {
-            return 0;
-        } else if (fu <= 30) {
-            return 1000;
-        } else if (fu <= 40) {
-            return 1300;
-        } else if (fu <= 50) {
-            return 1600;
-        } else if (fu <= 60) {
-            return 2000;
-        } else if (fu <= 70) {
-            return 2300;
-        } else if (fu <= 80) {
-            return 2600;
-        } else {
-            return 2900;
-        }
-    } else if (fan == 3) {
-        if (fu <= 20) {
-            return 1300;
-        } else if (fu == 25) {
-            return 1600;
-        } else if (fu <= 30) {
-            return 2000;
-        } else if (fu <= 40) {
-            return 2600;
-        } else if (fu <= 50) {
-            return 3200;
-        } else if (fu <= 60) {
-            return 3900;
-        } else {
-            return 4000; // Mangan
-        }
-    } else if (fan == 4) {
-        if (fu <= 20) {
-            return 2600;
-        } else if (fu == 25) {
-            return 3200;
-        } else if (fu <= 30) {
-            return 3900;
-        } else {
-            return 4000; // Mangan
-        }
-    } else if (fan == 5) {
-        return 4000; // Mangan
-    } else if (fan <= 7) {
-        return 6000; // Haneman
-    } else if (fan <= 10) {
-        return 8000; // Baiman
-    } else if (fan <= 12) {
-        return 12000;
-    } else if (fan <= 25) {
-        return 16000;
-    } else if (fan <= 38) {
-        return 32000;
-    } else {
-        return 48000;
-    }
+    return VictoryPayments::payment(VictoryPayments::DEALER_TSUMO, fu, fan);
 }
 
 int TurnResult::Tabular2(int fu, int fan) {
-    if (fan == 1) {
-        if (fu <= 20) {
-            return 0;
-        } else if (fu == 25) {
-            return 0;
-        } else if (fu <= 30) {
-            return 1500;
-        } else if (fu <= 40) {
-            return 2000;
-        } else if (fu <= 50) {
-            return 2400;
-        } else if (fu <= 60) {
-            return 2900;
-        } else if (fu <= 70) {
-            return 3400;
-        } else if (fu <= 80) {
-            return 3900;
-        } else {
-            return 4400;
-        }
-    } else if (fan == 2) {
-        if (fu <= 20) {
-            return 2000;
-        } else if (fu == 25) {
-            return 2400;
-        } else if (fu <= 30) {
-            return 2900;
-        } else if (fu <= 40) {
-            return 3900;
-        } else if (fu <= 50) {
-            return 4800;
-        } else if (fu <= 60) {
-            return 5800;
-        } else if (fu <= 70) {
-            return 6800;
-        } else if (fu <= 80) {
-            return 7700;
-        } else {
-            return 8700;
-        }
-    } else if (fan == 3) {
-        if (fu <= 20) {
-            return 3900;
-        } else if (fu == 25) {
-            return 4800;
-        } else if (fu <= 30) {
-            return 5800;
-        } else if (fu <= 40) {
-            return 7700;
-        } else if (fu <= 50) {
-            return 9600;
-        } else if (fu <= 60) {
-            return 11600;
-        } else {
-            return 12000; // Mangan
-        }
-    } else if (fan == 4) {
-        if (fu <= 20) {
-            return 7700;
-        } else if (fu == 25) {
-            return 9600;
-        } else if (fu <= 30) {
-            return 11600;
-        } else {
-            return 12000; // Mangan
-        }
-    } else if (fan == 5) {
-        return 12000; // Mangan
-    } else if (fan <= 7) {
-        return 18000; // Haneman
-    } else if (fan <= 10) {
-        return 24000; // Baiman
-    } else if (fan <= 12) {
-        return 36000;
-    } else if (fan <= 25) {
-        return 48000;
-    } else if (fan <= 38) {
-        return 96000;
-    } else {
-        return 144000;
-    }
+    return VictoryPayments::payment(VictoryPayments::DEALER_RON, fu, fan);
 }
 
 int TurnResult::Tabular3(int fu, int fan) {
-    if (fan == 1) {
-        if (fu <= 20) {
-            return 0;
-        } else if (fu == 25) {
-            return 0;
-        } else if (fu <= 30) {
-            return 300;
-        } else if (fu <= 40) {
-            return 400;
-        } else if (fu <= 50) {
-            return 400;
-        } else if (fu <= 60) {
-            return 500;
-        } else if (fu <= 70) {
-            return 600;
-        } else if (fu <= 80) {
-            return 700;
-        } else {
-            return 800;
-        }
-    } else if (fan == 2) {
-        if (fu <= 20) {
-            return 400;
-        } else if (fu == 25) {
-            return 0;
-        } else if (fu <= 30) {
-            return 500;
-        } else if (fu <= 40) {
-            return 700;
-        } else if (fu <= 50) {
-            return 800;
-        } else if (fu <= 60) {
-            return 1000;
-        } else if (fu <= 70) {
-            return 1200;
-        } else if (fu <= 80) {
-            return 1300;
-        } else {
-            return 1500;
-        }
-    } else if (fan == 3) {
-        if (fu <= 20) {
-            return 700;
-        } else if (fu == 25) {
-            return 800;
-        } else if (fu <= 30) {
-            return 1000;
-        } else if (fu <= 40) {
-            return 1300;
-        } else if (fu <= 50) {
-            return 1600;
-        } else {
-            return 2000; // Mangan
-        }
-    } else if (fan == 4) {
-        if (fu <= 20) {
-            return 1300;
-        } else if (fu == 25) {
-            return 1600;
-        } else {
-            return 2000; // Mangan
-        }
-    } else if (fan == 5) {
-        return 2000; // Mangan
-    } else if (fan <= 7) {
-        return 3000; // Haneman
-    } else if (fan <= 10) {
-        return 4000; // Baiman
-    } else if (fan <= 12) {
-        return 6000;
-    } else if (fan <= 25) {
-        return 8000;
-    } else if (fan <= 38) {
-        return 16000;
-    } else {
-        return 24000;
-    }
+    return VictoryPayments::payment(VictoryPayments::NON_DEALER_TSUMO, fu,
+                                    fan);
 }
 
 int TurnResult::Tabular4(int fu, int fan) {
-    if (fan == 1) {
-        if (fu <= 20) {
-            return 0;
-        } else if (fu == 25) {
-            return 0;
-        } else if (fu <= 30) {
-            return 1000;
-        } else if (fu <= 40) {
-            return 1300;
-        } else if (fu <= 50) {
-            return 1600;
-        } else if (fu <= 60) {
-            return 2000;
-        } else if (fu <= 70) {
-            return 2300;
-        } else if (fu <= 80) {
-            return 2600;
-        } else {
-            return 2900;
-        }
-    } else if (fan == 2) {
-        if (fu <= 20) {
-            return 1600;
-        } else if (fu == 25) {
-            return 1600;
-        } else if (fu <= 30) {
-            return 2000;
-        } else if (fu <= 40) {
-            return 3600;
-        } else if (fu <= 50) {
-            return 3200;
-        } else if (fu <= 60) {
-            return 3900;
-        } else if (fu <= 70) {
-            return 4500;
-        } else if (fu <= 80) {
-            return 5200;
-        } else {
-            return 5800;
-        }
-    } else if (fan == 3) {
-        if (fu <= 20) {
-            return 2800;
-        } else if (fu == 25) {
-            return 3200;
-        } else if (fu <= 30) {
-            return 3900;
-        } else if (fu <= 40) {
-            return 5200;
-        } else if (fu <= 50) {
-            return 6400;
-        } else if (fu <= 60) {
-            return 7700;
-        } else {
-            return 8000; // Mangan
-        }
-    } else if (fan == 4) {
-        if (fu <= 20) {
-            return 5200;
-        } else if (fu == 25) {
-            return 6400;
-        } else if (fu <= 30) {
-            return 7700;
-        } else {
-            return 8000; // Mangan
-        }
-    } else if (fan == 5) {
-        return 8000; // Mangan
-    } else if (fan <= 7) {
-        return 12000; // Haneman
-    } else if (fan <= 10) {
-        return 16000; // Baiman
-    } else if (fan <= 12) {
-        return 24000;
-    } else if (fan <= 25) { // Yakuman
-        return 32000;
-    } else if (fan <= 38) { // Double Yakuman
-        return 64000;
-    } else {
-        return 96000;
-    }
-}
\ No newline at end of file
+    return VictoryPayments::payment(VictoryPayments::NON_DEALER_RON, fu, fan);
+}
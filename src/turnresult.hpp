@@ -4,6 +4,11 @@
 #include <QTextStream>
 #include <vector>
 
+/**
+ * @brief Outcome of a turn (its values are written in the analyses)
+ */
+enum class TurnOutcome : quint8 { TSUMO = 0, RON = 1, MANUAL = 2, DRAW = 3 };
+
 /**
  * @brief Structure that holds the important information about a turn for
  * scoring
@@ -16,15 +21,12 @@ class TurnResult {
                bool _riichi_player_4 = false, int _fu_score = 20,
                int _fan_score = 0, const WinningHand *hand = nullptr);
     /** Manual score constructors */
-    TurnResult(const std::vector<int> &scores);
+    TurnResult(const std::vector<int> &scores, int _east_player = 0,
+               int _winner = 0);
 
     /** Draw turn result constructor */
-    TurnResult(const std::vector<bool> &players_tenpai);
-
-    /**
-     * @brief Construct a new Turn Result object from a descriptive string
-     */
-    TurnResult(int n_players, QString *description);
+    TurnResult(const std::vector<bool> &players_tenpai, int _east_player = 0,
+               int _winner = 0);
 
     /**
      * @brief Compute the score differential for each player after the round
@@ -52,7 +54,9 @@ class TurnResult {
     const WinningHand *hand() const;
     bool isManualScore() const;
     bool isDraw() const;
+    TurnOutcome outcome() const;
     const std::vector<bool> &playersTenpai() const;
+    const std::vector<int> &manualScores() const;
 
   private:
     int east_player_; /**< Number of East player */
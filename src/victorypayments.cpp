@@ -0,0 +1,166 @@
+#include <algorithm>
+
+#include "victorypayments.hpp"
+
+// Rows: 1, 2, 3, 4, 5 (mangan), 6-7 (haneman), 8-10 (baiman), 11-12, 13-25
+// (yakuman), 26-38 and 39+ fan; 0 fan pays like a haneman
+const quint8 VictoryPayments::FAN_ROWS[MAX_FAN + 1] = {
+    5, 0, 1, 2, 3, 4, 5, 5, 6, 6,
+    6, 7, 7, 8, 8, 8, 8, 8, 8, 8,
+    8, 8, 8, 8, 8, 8, 9, 9, 9, 9,
+    9, 9, 9, 9, 9, 9, 9, 9, 9, 10};
+// Columns: 20 fu or less, 25, 30, 40, 50, 60, 70, 80 and above 80
+const quint8 VictoryPayments::FU_COLUMNS[MAX_FU + 1] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 2, 2, 2, 2, 1, 2, 2, 2, 2,
+    2, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 8};
+// clang-format off
+const qint32 VictoryPayments::PAYMENTS[N_TABLES * TABLE_SIZE] = {
+    // DEALER_TSUMO
+    0, 0, 500, 700, 800, 1000, 1200, 1300, 1500,
+    700, 0, 1000, 1300, 1600, 2000, 2300, 2600, 2900,
+    1300, 1600, 2000, 2600, 3200, 3900, 4000, 4000, 4000,
+    2600, 3200, 3900, 4000, 4000, 4000, 4000, 4000, 4000,
+    4000, 4000, 4000, 4000, 4000, 4000, 4000, 4000, 4000,
+    6000, 6000, 6000, 6000, 6000, 6000, 6000, 6000, 6000,
+    8000, 8000, 8000, 8000, 8000, 8000, 8000, 8000, 8000,
+    12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000,
+    16000, 16000, 16000, 16000, 16000, 16000, 16000, 16000, 16000,
+    32000, 32000, 32000, 32000, 32000, 32000, 32000, 32000, 32000,
+    48000, 48000, 48000, 48000, 48000, 48000, 48000, 48000, 48000,
+    // DEALER_RON
+    0, 0, 1500, 2000, 2400, 2900, 3400, 3900, 4400,
+    2000, 2400, 2900, 3900, 4800, 5800, 6800, 7700, 8700,
+    3900, 4800, 5800, 7700, 9600, 11600, 12000, 12000, 12000,
+    7700, 9600, 11600, 12000, 12000, 12000, 12000, 12000, 12000,
+    12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000,
+    18000, 18000, 18000, 18000, 18000, 18000, 18000, 18000, 18000,
+    24000, 24000, 24000, 24000, 24000, 24000, 24000, 24000, 24000,
+    36000, 36000, 36000, 36000, 36000, 36000, 36000, 36000, 36000,
+    48000, 48000, 48000, 48000, 48000, 48000, 48000, 48000, 48000,
+    96000, 96000, 96000, 96000, 96000, 96000, 96000, 96000, 96000,
+    144000, 144000, 144000, 144000, 144000, 144000, 144000, 144000, 144000,
+    // NON_DEALER_TSUMO
+    0, 0, 300, 400, 400, 500, 600, 700, 800,
+    400, 0, 500, 700, 800, 1000, 1200, 1300, 1500,
+    700, 800, 1000, 1300, 1600, 2000, 2000, 2000, 2000,
+    1300, 1600, 2000, 2000, 2000, 2000, 2000, 2000, 2000,
+    2000, 2000, 2000, 2000, 2000, 2000, 2000, 2000, 2000,
+    3000, 3000, 3000, 3000, 3000, 3000, 3000, 3000, 3000,
+    4000, 4000, 4000, 4000, 4000, 4000, 4000, 4000, 4000,
+    6000, 6000, 6000, 6000, 6000, 6000, 6000, 6000, 6000,
+    8000, 8000, 8000, 8000, 8000, 8000, 8000, 8000, 8000,
+    16000, 16000, 16000, 16000, 16000, 16000, 16000, 16000, 16000,
+    24000, 24000, 24000, 24000, 24000, 24000, 24000, 24000, 24000,
+    // NON_DEALER_RON
+    0, 0, 1000, 1300, 1600, 2000, 2300, 2600, 2900,
+    1600, 1600, 2000, 3600, 3200, 3900, 4500, 5200, 5800,
+    2800, 3200, 3900, 5200, 6400, 7700, 8000, 8000, 8000,
+    5200, 6400, 7700, 8000, 8000, 8000, 8000, 8000, 8000,
+    8000, 8000, 8000, 8000, 8000, 8000, 8000, 8000, 8000,
+    12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000, 12000,
+    16000, 16000, 16000, 16000, 16000, 16000, 16000, 16000, 16000,
+    24000, 24000, 24000, 24000, 24000, 24000, 24000, 24000, 24000,
+    32000, 32000, 32000, 32000, 32000, 32000, 32000, 32000, 32000,
+    64000, 64000, 64000, 64000, 64000, 64000, 64000, 64000, 64000,
+    96000, 96000, 96000, 96000, 96000, 96000, 96000, 96000, 96000
+};
+// clang-format on
+
+int VictoryPayments::fanRow(int fan) {
+    return FAN_ROWS[std::min(std::max(fan, 0), MAX_FAN)];
+}
+
+int VictoryPayments::fuColumn(int fu) {
+    return FU_COLUMNS[std::min(std::max(fu, 0), MAX_FU)];
+}
+
+int VictoryPayments::payment(Table table, int fu, int fan) {
+    return PAYMENTS[table * TABLE_SIZE + fanRow(fan) * N_FU_COLUMNS +
+                    fuColumn(fu)];
+}
+
+void VictoryPayments::computeScoreChanges(
+    const Turns &turns, int first, int last,
+    qint32 *const score_changes[MAX_PLAYERS]) {
+    const quint8 *player_counts = turns.player_counts;
+    const quint8 *east_players = turns.east_players;
+    const TurnOutcome *outcomes = turns.outcomes;
+    const quint8 *winners = turns.winners;
+    const quint8 *losers = turns.losers;
+    const quint8 *riichi_masks = turns.riichi_masks;
+
+    // The turns are processed by blocks: the payments of the block are
+    // gathered from the tables first, then the score changes are computed
+    // seat by seat. Every value is computed for every turn and the results
+    // are selected, so that both loops are vectorized.
+    qint32 ron_payments[BLOCK_SIZE];
+    qint32 east_payments[BLOCK_SIZE];
+    qint32 other_payments[BLOCK_SIZE];
+    qint32 tsumo_gains[BLOCK_SIZE];
+    qint32 riichi_gains[BLOCK_SIZE];
+    for (int block = first; block < last; block += BLOCK_SIZE) {
+        const int n_turns = std::min(last - block, BLOCK_SIZE);
+        for (int i = 0; i < n_turns; i++) {
+            const int turn = block + i;
+            const int n_players = player_counts[turn];
+            const bool dealer = winners[turn] == east_players[turn];
+            const int cell = fanRow(turns.fan_scores[turn]) * N_FU_COLUMNS +
+                             fuColumn(turns.fu_scores[turn]);
+            ron_payments[i] =
+                PAYMENTS[(dealer ? DEALER_RON : NON_DEALER_RON) * TABLE_SIZE +
+                         cell];
+            east_payments[i] = PAYMENTS[DEALER_TSUMO * TABLE_SIZE + cell];
+            other_payments[i] =
+                PAYMENTS[(dealer ? DEALER_TSUMO : NON_DEALER_TSUMO) *
+                             TABLE_SIZE +
+                         cell];
+            tsumo_gains[i] =
+                dealer ? (n_players - 1) * other_payments[i]
+                       : east_payments[i] + (n_players - 2) * other_payments[i];
+            const int riichi_mask = riichi_masks[turn];
+            riichi_gains[i] =
+                1000 * ((riichi_mask & 1) + ((riichi_mask >> 1) & 1) +
+                        ((riichi_mask >> 2) & 1) + ((riichi_mask >> 3) & 1));
+        }
+
+        for (int seat = 0; seat < MAX_PLAYERS; seat++) {
+            qint32 *changes = score_changes[seat] + block;
+            for (int i = 0; i < n_turns; i++) {
+                const int turn = block + i;
+                const int ron_payment = ron_payments[i];
+                const int east_payment = east_payments[i];
+                const int other_payment = other_payments[i];
+                const int tsumo_gain = tsumo_gains[i];
+                const int riichi_gain = riichi_gains[i];
+                const int previous_change = changes[i];
+                const TurnOutcome outcome = outcomes[turn];
+                const bool is_winner = winners[turn] == seat;
+                const bool is_loser = losers[turn] == seat;
+                const bool is_east = east_players[turn] == seat;
+                const bool is_riichi = (riichi_masks[turn] >> seat) & 1;
+                const bool is_playing = player_counts[turn] > seat;
+                const bool ron = outcome == TurnOutcome::RON;
+                const bool victory = ron | (outcome == TurnOutcome::TSUMO);
+                const int ron_change =
+                    is_winner ? ron_payment : (is_loser ? -ron_payment : 0);
+                const int tsumo_change =
+                    is_winner ? tsumo_gain
+                              : (is_east ? -east_payment : -other_payment);
+                const int riichi_change =
+                    (is_winner ? riichi_gain : 0) - (is_riichi ? 1000 : 0);
+                const int change =
+                    is_playing
+                        ? (ron ? ron_change : tsumo_change) + riichi_change
+                        : 0;
+                changes[i] = victory ? change : previous_change;
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <QtGlobal>
+
+#include "turnresult.hpp"
+
+/**
+ * @brief Payments of the victories (Miller's fan tables) as lookup tables,
+ * and the score changes of many victories computed at once
+ *
+ * The tables are indexed by a row of fan and a column of fu, both looked up
+ * in small arrays, so that computeScoreChanges() has no branch: its loop
+ * over the turns is vectorized by the compiler, with gathers from the
+ * tables where the target supports them.
+ *
+ * tests/victorypayments_test.cpp checks the tables against the if/else
+ * chains they were generated from, and the kernel against
+ * TurnResult::computeScoreChange().
+ */
+class VictoryPayments {
+  public:
+    static const int MAX_PLAYERS = 4;
+
+    enum Table {
+        /** What each player pays a dealer winning by tsumo, and what the
+         * dealer pays another player winning by tsumo */
+        DEALER_TSUMO,
+        /** What the loser pays a dealer winning by ron */
+        DEALER_RON,
+        /** What the non-dealers pay a non-dealer winning by tsumo */
+        NON_DEALER_TSUMO,
+        /** What the loser pays a non-dealer winning by ron */
+        NON_DEALER_RON,
+        N_TABLES
+    };
+
+    /**
+     * @brief Columns of turns, with a value per turn (see TurnColumns)
+     */
+    struct Turns {
+        const quint8 *player_counts;
+        const quint8 *east_players;
+        const TurnOutcome *outcomes;
+        const quint8 *winners;
+        const quint8 *losers;
+        const quint16 *fu_scores;
+        const quint16 *fan_scores;
+        const quint8 *riichi_masks; /**< Bit i set if seat i is riichi */
+    };
+
+    /**
+     * @brief Entry of a table for the given fu and fan scores
+     */
+    static int payment(Table table, int fu, int fan);
+
+    /**
+     * @brief Compute the score changes of the victories of [first, last),
+     * like TurnResult::computeScoreChange()
+     *
+     * @param score_changes score changes of each seat, the turns which are
+     * not victories are left unchanged
+     */
+    static void computeScoreChanges(const Turns &turns, int first, int last,
+                                    qint32 *const score_changes[MAX_PLAYERS]);
+
+  private:
+    static const int MAX_FAN = 39; /**< Higher fans pay the same */
+    static const int MAX_FU = 81;  /**< Higher fus pay the same */
+    static const int N_FAN_ROWS = 11;
+    static const int N_FU_COLUMNS = 9;
+    static const int TABLE_SIZE = N_FAN_ROWS * N_FU_COLUMNS;
+    /** Number of turns processed at once by computeScoreChanges() */
+    static const int BLOCK_SIZE = 256;
+
+    static int fanRow(int fan);
+    static int fuColumn(int fu);
+
+    /** Row of each fan in the tables */
+    static const quint8 FAN_ROWS[MAX_FAN + 1];
+    /** Column of each fu in the tables */
+    static const quint8 FU_COLUMNS[MAX_FU + 1];
+    /** Entries of each table, row by row */
+    static const qint32 PAYMENTS[N_TABLES * TABLE_SIZE];
+};
@@ -1,14 +1,10 @@
-#include <QDebug>
-#include <QTextStream>
-#include <qdebug.h>
-
 #include "tile.hpp"
 #include "winning_hand.hpp"
 
-const QString RON_MELDED_CHAR = "\"";
-const QString MELDED_CHAR = "'";
+const char RON_MELDED_CHAR[] = "\"";
+const char MELDED_CHAR[] = "'";
 
-QString groupTypeToString(const ClassicGroupType &type) {
+std::string groupTypeToString(const ClassicGroupType &type) {
     if (type == ClassicGroupType::CHII) {
         return "C";
     } else if (type == ClassicGroupType::PON) {
@@ -18,26 +14,7 @@ QString groupTypeToString(const ClassicGroupType &type) {
     }
 }
 
-ClassicGroup::ClassicGroup(const QString &descr) {
-    if (descr[0] == 'C') {
-        type = ClassicGroupType::CHII;
-    } else if (descr[0] == 'P') {
-        type = ClassicGroupType::PON;
-    } else {
-        type = ClassicGroupType::KAN;
-    }
-    tile = Tile(descr.mid(1, 2));
-    if (descr.length() > 3) {
-        if (descr[3] == RON_MELDED_CHAR[0]) {
-            ron_meld = true;
-            melded = true;
-        } else if (descr[3] == MELDED_CHAR[0]) {
-            melded = true;
-        }
-    }
-}
-
-QString ClassicGroup::toString() const {
+std::string ClassicGroup::toString() const {
     return groupTypeToString(type) + tile.toString() +
            (ron_meld ? RON_MELDED_CHAR : (melded ? MELDED_CHAR : ""));
 }
@@ -46,10 +23,10 @@ bool ClassicGroup::isSimple() const {
            ((type != ClassicGroupType::CHII) || (tile.value() < 7));
 }
 
-QString duoToString(const Tile &tile) { return "D" + tile.toString(); }
+std::string duoToString(const Tile &tile) { return "D" + tile.toString(); }
 
-QString ClassicHand::toString() const {
-    QString result;
+std::string ClassicHand::toString() const {
+    std::string result;
     for (const auto &group : groups) {
         result += group.toString() + "-";
     }
@@ -57,66 +34,64 @@ QString ClassicHand::toString() const {
     return result;
 }
 
-ClassicHand::ClassicHand(const QString &descr) {
-    QStringList groups_descr = descr.split('-');
-    int i = 0;
-    for (const auto &group : groups_descr) {
-        if (group[0] == 'D') {
-            duo_tile = Tile(group.mid(1));
-            continue;
-        }
-        groups[i] = ClassicGroup(group);
-        i++;
-    }
-}
-
-HandScore::HandScore() : fu_(20), fan_(0) {}
+HandScore::HandScore() : fu_(20), fan_(0), yaku_mask_(0) {}
 
 int HandScore::totalFu() const { return fu_; }
 int HandScore::totalFan() const { return fan_; }
-const QVector<ValueDetail> &HandScore::fuDetails() const { return fu_details_; }
-const QVector<ValueDetail> &HandScore::yakus() const { return yakus_; }
+const std::vector<ValueDetail> &HandScore::fuDetails() const {
+    return fu_details_;
+}
+const std::vector<ValueDetail> &HandScore::yakus() const { return yakus_; }
+std::uint32_t HandScore::yakuMask() const { return yaku_mask_; }
+static_assert(static_cast<int>(Yaku::DORAS) < 32,
+              "Every yaku must have a bit in the yaku mask");
+std::uint32_t HandScore::yakuBit(Yaku yaku) {
+    return std::uint32_t(1) << static_cast<int>(yaku);
+}
 
-void HandScore::addFu(int fu, const QString &detail) {
+void HandScore::addFu(int fu, std::string_view detail) {
     fu_ += fu;
-    fu_details_.append(ValueDetail{fu, detail});
+    fu_details_.emplace_back(fu, std::string(detail));
 }
-void HandScore::addYaku(int fan, const QString &detail) {
+void HandScore::addYaku(Yaku yaku, int fan, std::string_view detail) {
     fan_ += fan;
-    yakus_.append(ValueDetail{fan, detail});
+    yaku_mask_ |= yakuBit(yaku);
+    yakus_.emplace_back(fan, std::string(detail));
 }
-void HandScore::addBetterYaku(int fan, const QString &detail) {
+void HandScore::addBetterYaku(Yaku yaku, int fan, std::string_view detail) {
     fan_ += fan;
-    yakus_.append(ValueDetail{fan, "<b style=\"color: rgba(8, 95, 150, 1);\">" +
-                                       detail + "</b>"});
+    yaku_mask_ |= yakuBit(yaku);
+    yakus_.emplace_back(fan, "<b style=\"color: rgba(8, 95, 150, 1);\">" +
+                                 std::string(detail) + "</b>");
 }
-void HandScore::addYakuman(const QString &detail, bool doubled) {
+void HandScore::addYakuman(Yaku yaku, std::string_view detail, bool doubled) {
+    yaku_mask_ |= yakuBit(yaku);
     int value = YAKUMAN;
     if (doubled)
         value *= 2;
     fan_ += value;
     if (doubled)
-        yakus_.append(
-            ValueDetail{value, "<b style =\"color: rgb(235, 216, 2);\">" +
-                                   detail + " &mdash; Double Yakuman</b>"});
+        yakus_.emplace_back(value, "<b style =\"color: rgb(235, 216, 2);\">" +
+                                       std::string(detail) +
+                                       " &mdash; Double Yakuman</b>");
     else
-        yakus_.append(
-            ValueDetail{value, "<b style =\"color: rgba(17, 146, 60, 1);\">" +
-                                   detail + " &mdash; Yakuman</b>"});
+        yakus_.emplace_back(value,
+                            "<b style =\"color: rgba(17, 146, 60, 1);\">" +
+                                std::string(detail) + " &mdash; Yakuman</b>");
 }
 
-QString HandScore::toString() const {
-    QString text = "<hr><p><b>Fu:</b> " + QString::number(totalFu()) +
-                   (fu_details_.size() > 0 ? " = 20" : "");
+std::string HandScore::toString() const {
+    std::string text = "<hr><p><b>Fu:</b> " + std::to_string(totalFu()) +
+                       (fu_details_.size() > 0 ? " = 20" : "");
     for (const auto &fu_detail : fu_details_) {
-        text += " + " + QString::number(fu_detail.value);
+        text += " + " + std::to_string(fu_detail.value);
     }
 
-    text += "<br><b>Fan:</b> " + QString::number(totalFan()) +
+    text += "<br><b>Fan:</b> " + std::to_string(totalFan()) +
             "</p>\n<b>Yakus:</b>\n<ul>\n";
     // Add yaku names
     for (const auto &yaku : yakus_) {
-        text += "  <li>" + yaku.detail + " (+" + QString::number(yaku.value) +
+        text += "  <li>" + yaku.detail + " (+" + std::to_string(yaku.value) +
                 ")" + "</li>\n";
     }
     text += "</ul>";
@@ -161,7 +136,7 @@ bool WinningHand::isClosed() const {
 }
 int WinningHand::totalDoras() const { return total_doras_; }
 
-QString WinningHand::windTileToString(const Tile &tile) {
+std::string WinningHand::windTileToString(const Tile &tile) {
     if (!tile.isWind()) {
         return "";
     }
@@ -178,7 +153,7 @@ QString WinningHand::windTileToString(const Tile &tile) {
     return "";
 }
 
-Tile WinningHand::stringToWindTile(const QString &str) {
+Tile WinningHand::stringToWindTile(std::string_view str) {
     if (str == "E") {
         return Tile(HONOR, static_cast<int>(HonorValue::EAST));
     } else if (str == "S") {
@@ -191,8 +166,8 @@ Tile WinningHand::stringToWindTile(const QString &str) {
     return Tile();
 }
 
-QString WinningHand::toString() const {
-    QString result;
+std::string WinningHand::toString() const {
+    std::string result;
     switch (type_) {
     case HandType::CLASSIC:
         result += hand_.classic_hand.toString();
@@ -210,49 +185,57 @@ QString WinningHand::toString() const {
     default:
         return "Unknown";
     }
-    result += "+" + QString(ippatsu_ ? "1" : "0") + "-" +
-              QString::number(total_doras_) + "-" +
+    result += std::string("+") + (ippatsu_ ? "1" : "0") + "-" +
+              std::to_string(total_doras_) + "-" +
               windTileToString(prevailing_wind_) + "-" +
               windTileToString(player_wind_);
     return result;
 }
 
-static char32_t HIDDEN_TILE_CHAR[1] = {0x1F02B};
-static QString HIDDEN_TILE = QString::fromUcs4(HIDDEN_TILE_CHAR, 1);
+// U+1F02B, the back of a tile, encoded in UTF-8
+static const char HIDDEN_TILE[] = "\xF0\x9F\x80\xAB";
 
-QString WinningHand::toUTF8Symbols() const {
-    QString result;
+static std::string repeated(const std::string &str, int times) {
+    std::string result;
+    result.reserve(str.size() * times);
+    for (int i = 0; i < times; i++) {
+        result += str;
+    }
+    return result;
+}
+
+std::string WinningHand::toUTF8Symbols() const {
+    std::string result;
     if (type_ == HandType::CLASSIC) {
         for (const auto &group : hand_.classic_hand.groups) {
             if (group.type == ClassicGroupType::PON) {
-                result += group.tile.toUTF8().repeated(3) + " ";
+                result += repeated(group.tile.toUTF8(), 3) + " ";
             } else if (group.type == ClassicGroupType::KAN) {
                 if (group.melded) {
-                    result += QString(group.tile.toUTF8()).repeated(4) + " ";
+                    result += repeated(group.tile.toUTF8(), 4) + " ";
                 } else {
-                    result += HIDDEN_TILE +
-                              QString(group.tile.toUTF8()).repeated(2) +
+                    result += HIDDEN_TILE + repeated(group.tile.toUTF8(), 2) +
                               HIDDEN_TILE + " ";
                 }
             } else if (group.type == ClassicGroupType::CHII) {
                 result +=
-                    QString(group.tile.toUTF8()) +
+                    group.tile.toUTF8() +
                     Tile(group.tile.suit(), group.tile.value() + 1).toUTF8() +
                     Tile(group.tile.suit(), group.tile.value() + 2).toUTF8() +
                     " ";
             }
         }
-        result += QString(hand_.classic_hand.duo_tile.toUTF8()).repeated(2);
+        result += repeated(hand_.classic_hand.duo_tile.toUTF8(), 2);
     } else if (type_ == HandType::PAIRS) {
         for (const auto &pair : hand_.seven_pairs_hand) {
-            result += QString(pair.toUTF8()).repeated(2) + " ";
+            result += repeated(pair.toUTF8(), 2) + " ";
         }
     } else if (type_ == HandType::ORPHANS) {
         for (const Tile &orphan : ORPHAN_TILES) {
             if (orphan == hand_.duo_orphans_hand)
-                result += QString(orphan.toUTF8()).repeated(2);
+                result += repeated(orphan.toUTF8(), 2);
             else
-                result += QString(orphan.toUTF8());
+                result += orphan.toUTF8();
         }
     }
 
@@ -262,53 +245,6 @@ QString WinningHand::toUTF8Symbols() const {
 const Tile &WinningHand::prevailingWind() const { return prevailing_wind_; }
 const Tile &WinningHand::playerWind() const { return player_wind_; }
 
-WinningHand::WinningHand(const QString &description, bool riichi, bool ron)
-    : riichi_(riichi), ron_(ron) {
-    QString descr = description;
-    descr.replace('+', ' ');
-    QTextStream in(&descr);
-    QString hand_descr;
-    if (descr[0].isLetter()) { // Classic hand
-        type_ = HandType::CLASSIC;
-        in >> hand_descr;
-        hand_.classic_hand = ClassicHand(hand_descr);
-    } else if (descr[0] == '7') { // Seven pairs
-        type_ = HandType::PAIRS;
-        in >> hand_descr;
-        hand_descr.replace('-', ' ');
-        QTextStream in_hand(&hand_descr);
-        QString pair;
-        in_hand >> pair; // Remove 7P prefix
-        for (int i = 0; i < 7; i++) {
-            in_hand >> pair;
-            hand_.seven_pairs_hand[i] = Tile(pair);
-        }
-    } else if (descr[0] == '1') { // Orphans
-        type_ = HandType::ORPHANS;
-        in >> hand_descr;
-        hand_descr.replace('-', ' ');
-        QTextStream in_hand(&hand_descr);
-        QString pair;
-        in_hand >> pair; // Remove 13O prefix
-        in_hand >> pair;
-        hand_.duo_orphans_hand = Tile(pair);
-    }
-    QString infos;
-    in >> infos;
-    infos.replace('-', ' ');
-    QTextStream in2(&infos);
-    int ippatsu;
-    QString prevailing, player;
-    in2 >> ippatsu >> total_doras_ >> prevailing >> player;
-    if (ippatsu != 0) {
-        ippatsu_ = true;
-    } else {
-        ippatsu_ = false;
-    }
-    prevailing_wind_ = stringToWindTile(prevailing);
-    player_wind_ = stringToWindTile(player);
-}
-
 /* Scoring methods */
 ValidityStatus WinningHand::checkValid() const {
     // Ippatsu requires riichi
@@ -365,7 +301,7 @@ HandScore WinningHand::computeScore() const {
                 continue;
             }
             int value = 2;
-            QString expl;
+            std::string expl;
             if (!hand_.classic_hand.groups[i].melded) {
                 value *= 2;
                 expl += "Concealed ";
@@ -394,7 +330,7 @@ HandScore WinningHand::computeScore() const {
 
     // Handle pinfu
     if (type_ == HandType::CLASSIC && score.totalFu() == 20) {
-        score.addYaku(1, "Pinfu");
+        score.addYaku(Yaku::PINFU, 1, "Pinfu");
     }
     if (type_ != HandType::PAIRS && isClosed() && isRon()) {
         score.addFu(10, "Closed Hand won by ron");
@@ -402,13 +338,13 @@ HandScore WinningHand::computeScore() const {
 
     /* Compute fans */
     if (isRiichi()) {
-        score.addYaku(1, "Riichi");
+        score.addYaku(Yaku::RIICHI, 1, "Riichi");
     }
     if (isIppatsu()) {
-        score.addYaku(1, "Ippatsu");
+        score.addYaku(Yaku::IPPATSU, 1, "Ippatsu");
     }
     if (isClosed() && isTsumo() && type_ != HandType::ORPHANS) {
-        score.addYaku(1, "Fully concealed hand");
+        score.addYaku(Yaku::FULLY_CONCEALED_HAND, 1, "Fully concealed hand");
     }
 
     int n_simple = 0, n_dragon_group = 0, n_wind_group = 0,
@@ -416,9 +352,9 @@ HandScore WinningHand::computeScore() const {
         n_dot_group = 0, n_character_group = 0;
 
     if (type_ == HandType::ORPHANS) {
-        score.addYakuman("Thirteen Orphans", false);
+        score.addYakuman(Yaku::THIRTEEN_ORPHANS, "Thirteen Orphans", false);
     } else if (type_ == HandType::PAIRS) {
-        score.addYaku(2, "Seven pairs");
+        score.addYaku(Yaku::SEVEN_PAIRS, 2, "Seven pairs");
         for (const auto &tile : hand_.seven_pairs_hand) {
             if (tile.suit() == BAMBOO) {
                 n_bamboo_group++;
@@ -467,16 +403,18 @@ HandScore WinningHand::computeScore() const {
                     n_group_with_terminal++;
                 }
                 if (group.tile.isDragon()) {
-                    score.addYaku(1, "Dragon pon");
+                    score.addYaku(Yaku::DRAGON_PON, 1, "Dragon pon");
                     n_dragon_group++;
                 }
                 if (group.tile.isWind()) {
                     n_wind_group++;
                     if (group.tile == prevailing_wind_) {
-                        score.addYaku(1, "Prevailing wind pon");
+                        score.addYaku(Yaku::PREVAILING_WIND_PON, 1,
+                                      "Prevailing wind pon");
                     }
                     if (group.tile == player_wind_) {
-                        score.addYaku(1, "Player's wind pon");
+                        score.addYaku(Yaku::PLAYER_WIND_PON, 1,
+                                      "Player's wind pon");
                     }
                 }
             }
@@ -499,28 +437,29 @@ HandScore WinningHand::computeScore() const {
         }
 
         if (n_pon == 4) {
-            score.addYaku(2, "All pon");
+            score.addYaku(Yaku::ALL_PON, 2, "All pon");
         }
         if (n_concealed_pon >= 3) {
-            score.addYaku(2, "Three concealed pon");
+            score.addYaku(Yaku::THREE_CONCEALED_PON, 2, "Three concealed pon");
         }
         if (n_kan == 3) {
-            score.addYaku(2, "Three kan");
+            score.addYaku(Yaku::THREE_KAN, 2, "Three kan");
         } else if (n_kan == 4) {
-            score.addYakuman("Four kan");
+            score.addYakuman(Yaku::FOUR_KAN, "Four kan");
         }
         if (n_dragon_group == 3) {
             if (!hand_.classic_hand.duo_tile.isDragon()) {
-                score.addYakuman("Big Three Dragons");
+                score.addYakuman(Yaku::BIG_THREE_DRAGONS, "Big Three Dragons");
             } else {
-                score.addBetterYaku(4, "Little Three Dragons");
+                score.addBetterYaku(Yaku::LITTLE_THREE_DRAGONS, 4,
+                                    "Little Three Dragons");
             }
         }
         if (n_wind_group == 4) {
             if (!hand_.classic_hand.duo_tile.isWind()) {
-                score.addYakuman("Big Four Winds", true);
+                score.addYakuman(Yaku::BIG_FOUR_WINDS, "Big Four Winds", true);
             } else {
-                score.addYakuman("Little Four Winds");
+                score.addYakuman(Yaku::LITTLE_FOUR_WINDS, "Little Four Winds");
             }
         }
 
@@ -541,9 +480,10 @@ HandScore WinningHand::computeScore() const {
                 }
             }
             if (n_double_chii == 1) {
-                score.addYaku(1, "Double chii");
+                score.addYaku(Yaku::DOUBLE_CHII, 1, "Double chii");
             } else if (n_double_chii == 2) {
-                score.addBetterYaku(3, "Twice double chii");
+                score.addBetterYaku(Yaku::TWICE_DOUBLE_CHII, 3,
+                                    "Twice double chii");
             }
         }
 
@@ -598,14 +538,14 @@ HandScore WinningHand::computeScore() const {
             }
 
             if (three_suit_chii) {
-                score.addYaku(isClosed() ? 2 : 1,
-                              (isClosed() ? "Closed " : "") +
-                                  QString("Three Suit Chii"));
+                score.addYaku(Yaku::THREE_SUIT_CHII, isClosed() ? 2 : 1,
+                              std::string(isClosed() ? "Closed " : "") +
+                                  "Three Suit Chii");
             }
             if (pure_straight) {
-                score.addYaku(isClosed() ? 2 : 1,
-                              (isClosed() ? "Closed " : "") +
-                                  QString("Pure Straight"));
+                score.addYaku(Yaku::PURE_STRAIGHT, isClosed() ? 2 : 1,
+                              std::string(isClosed() ? "Closed " : "") +
+                                  "Pure Straight");
             }
         }
     }
@@ -616,28 +556,34 @@ HandScore WinningHand::computeScore() const {
     if (type_ == HandType::CLASSIC || type_ == HandType::PAIRS) {
         int n_groups = (type_ == HandType::CLASSIC ? 5 : 7);
         if (n_simple == n_groups) {
-            score.addYaku(1, "All simple");
+            score.addYaku(Yaku::ALL_SIMPLE, 1, "All simple");
         }
         if (n_group_with_orphan == n_groups) {
             if (n_dragon_group + n_wind_group == n_groups) {
-                score.addYakuman((type_ == HandType::PAIRS
-                                      ? "Seven Honors Pairs"
-                                      : "All Honors Hand"),
-                                 type_ == HandType::PAIRS);
+                if (type_ == HandType::PAIRS) {
+                    score.addYakuman(Yaku::SEVEN_HONORS_PAIRS,
+                                     "Seven Honors Pairs", true);
+                } else {
+                    score.addYakuman(Yaku::ALL_HONORS_HAND, "All Honors Hand");
+                }
             } else if (n_group_with_terminal == n_groups) {
                 if (n_chii == 0) {
-                    score.addYakuman("All Terminals Hand");
+                    score.addYakuman(Yaku::ALL_TERMINALS_HAND,
+                                     "All Terminals Hand");
                 } else {
-                    score.addYaku(2 + (isClosed() ? 1 : 0),
-                                  (isClosed() ? "Closed" : "Open") +
-                                      QString(" Pure Outside Hand"));
+                    score.addYaku(Yaku::PURE_OUTSIDE_HAND,
+                                  2 + (isClosed() ? 1 : 0),
+                                  std::string(isClosed() ? "Closed" : "Open") +
+                                      " Pure Outside Hand");
                 }
             } else if (n_chii == 0) {
-                score.addYaku(2, "All Terminals and Honors Hand");
+                score.addYaku(Yaku::ALL_TERMINALS_AND_HONORS_HAND, 2,
+                              "All Terminals and Honors Hand");
             } else {
-                score.addYaku(1 + (isClosed() ? 1 : 0),
-                              (isClosed() ? "Closed" : "Open") +
-                                  QString(" Mixed Outside Hand"));
+                score.addYaku(Yaku::MIXED_OUTSIDE_HAND,
+                              1 + (isClosed() ? 1 : 0),
+                              std::string(isClosed() ? "Closed" : "Open") +
+                                  " Mixed Outside Hand");
             }
         }
         if (n_bamboo_group == n_groups || n_dot_group == n_groups ||
@@ -669,24 +615,25 @@ HandScore WinningHand::computeScore() const {
             }
 
             if (nine_gates)
-                score.addYakuman("Nine Gates", false);
+                score.addYakuman(Yaku::NINE_GATES, "Nine Gates", false);
             else
-                score.addBetterYaku((isClosed() ? 6 : 5),
-                                    (isClosed() ? "Closed " : "") +
-                                        QString("Full Flush Hand"));
+                score.addBetterYaku(Yaku::FULL_FLUSH_HAND,
+                                    (isClosed() ? 6 : 5),
+                                    std::string(isClosed() ? "Closed " : "") +
+                                        "Full Flush Hand");
         } else if ((n_bamboo_group + n_character_group + n_dot_group > 0) &&
                    ((n_bamboo_group + n_dragon_group + n_wind_group ==
                      n_groups) ||
                     (n_dot_group + n_dragon_group + n_wind_group == n_groups) ||
                     (n_character_group + n_dragon_group + n_wind_group ==
                      n_groups))) {
-            score.addBetterYaku((isClosed() ? 3 : 2),
-                                (isClosed() ? "Closed " : "") +
-                                    QString("Half Flush Hand"));
+            score.addBetterYaku(Yaku::HALF_FLUSH_HAND, (isClosed() ? 3 : 2),
+                                std::string(isClosed() ? "Closed " : "") +
+                                    "Half Flush Hand");
         }
     }
     if (total_doras_ > 0) {
-        score.addYaku(total_doras_, "Doras");
+        score.addYaku(Yaku::DORAS, total_doras_, "Doras");
     }
 
     return score;
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "tile.hpp"
-#include <QVector>
-#include <qvector.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 enum class HandType { CLASSIC, PAIRS, ORPHANS };
 
@@ -18,22 +21,20 @@ typedef struct ClassicGroup {
                  bool ron_meld_in = false)
         : type(type_in), tile(tile_in), melded(melded_in),
           ron_meld(ron_meld_in) {}
-    ClassicGroup(const QString &descr);
-    QString toString() const;
+    std::string toString() const;
     bool isSimple() const;
 } ClassicGroup;
 
 typedef struct ClassicHand {
     ClassicGroup groups[4];
     Tile duo_tile;
-    QString toString() const;
+    std::string toString() const;
     ClassicHand(const ClassicGroup &first_group,
                 const ClassicGroup &second_group,
                 const ClassicGroup &third_group,
                 const ClassicGroup &fourth_group, const Tile &duo_tile)
         : groups{first_group, second_group, third_group, fourth_group},
           duo_tile(duo_tile) {}
-    ClassicHand(const QString &descr);
 } ClassicHand;
 
 union HandTiles {
@@ -52,18 +53,57 @@ union HandTiles {
 
 typedef struct ValidityStatus {
     bool valid;
-    QString message;
-    ValidityStatus(bool valid_in = true, QString message_in = "")
-        : valid(valid_in), message(message_in) {}
+    std::string message;
+    ValidityStatus(bool valid_in = true, std::string message_in = "")
+        : valid(valid_in), message(std::move(message_in)) {}
 } ValidityStatus;
 
 typedef struct ValueDetail {
     int value;
-    QString detail;
-    ValueDetail(int value_in = 0, const QString &detail_in = "")
-        : value(value_in), detail(detail_in) {}
+    std::string detail;
+    ValueDetail(int value_in = 0, std::string detail_in = "")
+        : value(value_in), detail(std::move(detail_in)) {}
 } ValueDetail;
 
+/**
+ * @brief Yakus that a hand can score, each one being a bit of
+ * HandScore::yakuMask()
+ */
+enum class Yaku {
+    PINFU,
+    RIICHI,
+    IPPATSU,
+    FULLY_CONCEALED_HAND,
+    THIRTEEN_ORPHANS,
+    SEVEN_PAIRS,
+    DRAGON_PON,
+    PREVAILING_WIND_PON,
+    PLAYER_WIND_PON,
+    ALL_PON,
+    THREE_CONCEALED_PON,
+    THREE_KAN,
+    FOUR_KAN,
+    BIG_THREE_DRAGONS,
+    LITTLE_THREE_DRAGONS,
+    BIG_FOUR_WINDS,
+    LITTLE_FOUR_WINDS,
+    DOUBLE_CHII,
+    TWICE_DOUBLE_CHII,
+    THREE_SUIT_CHII,
+    PURE_STRAIGHT,
+    ALL_SIMPLE,
+    SEVEN_HONORS_PAIRS,
+    ALL_HONORS_HAND,
+    ALL_TERMINALS_HAND,
+    PURE_OUTSIDE_HAND,
+    ALL_TERMINALS_AND_HONORS_HAND,
+    MIXED_OUTSIDE_HAND,
+    NINE_GATES,
+    FULL_FLUSH_HAND,
+    HALF_FLUSH_HAND,
+    DORAS
+};
+
 static const int MANGAN = 5;
 static const int YAKUMAN = 13;
 
@@ -73,21 +113,30 @@ class HandScore {
 
     int totalFu() const;
     int totalFan() const;
-    const QVector<ValueDetail> &fuDetails() const;
-    const QVector<ValueDetail> &yakus() const;
-
-    void addFu(int fu, const QString &detail);
-    void addYaku(int fan, const QString &detail);
-    void addBetterYaku(int fan, const QString &detail);
-    void addYakuman(const QString &detail, bool doubled = false);
-
-    QString toString() const;
+    const std::vector<ValueDetail> &fuDetails() const;
+    const std::vector<ValueDetail> &yakus() const;
+    /**
+     * @brief Set of the scored yakus, one bit per Yaku (see yakuBit())
+     */
+    std::uint32_t yakuMask() const;
+    static std::uint32_t yakuBit(Yaku yaku);
+
+    void addFu(int fu, std::string_view detail);
+    void addYaku(Yaku yaku, int fan, std::string_view detail);
+    void addBetterYaku(Yaku yaku, int fan, std::string_view detail);
+    void addYakuman(Yaku yaku, std::string_view detail, bool doubled = false);
+
+    /**
+     * @brief HTML summary of the fu and yakus
+     */
+    std::string toString() const;
 
   private:
     int fu_;
-    QVector<ValueDetail> fu_details_;
+    std::vector<ValueDetail> fu_details_;
     int fan_;
-    QVector<ValueDetail> yakus_;
+    std::vector<ValueDetail> yakus_;
+    std::uint32_t yaku_mask_;
 };
 
 class WinningHand {
@@ -102,8 +151,6 @@ class WinningHand {
     WinningHand(Tile duo_orphans_hand, const Tile &prevailing_wind,
                 const Tile &player_wind, bool riichi = false,
                 bool ippatsu = false, bool ron = false, int total_doras = 0);
-    WinningHand(const QString &description, bool riichi = false,
-                bool ron = false);
 
     HandType type() const;
     HandTiles hand() const;
@@ -114,8 +161,11 @@ class WinningHand {
     bool isClosed() const;
     bool isOpen() const;
     int totalDoras() const;
-    QString toString() const;
-    QString toUTF8Symbols() const;
+    std::string toString() const;
+    /**
+     * @brief Unicode symbols of the tiles of the hand, encoded in UTF-8
+     */
+    std::string toUTF8Symbols() const;
     const Tile &prevailingWind() const;
     const Tile &playerWind() const;
 
@@ -124,8 +174,8 @@ class WinningHand {
     HandScore computeScore() const;
 
     /* String utils */
-    static QString windTileToString(const Tile &tile);
-    static Tile stringToWindTile(const QString &str);
+    static std::string windTileToString(const Tile &tile);
+    static Tile stringToWindTile(std::string_view str);
 
   private:
     HandType type_;
@@ -0,0 +1,464 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "turncolumns.hpp"
+#include "victorypayments.hpp"
+
+/*
+ * Checks of the payment tables and of the score change kernel of
+ * VictoryPayments, against the if/else chains of Miller's fan tables the
+ * tables were generated from and against TurnResult::computeScoreChange()
+ */
+
+static int referenceDealerTsumo(int fu, int fan) {
+    if (fan == 1) {
+        if (fu <= 20) {
+            return 0;
+        } else if (fu == 25) {
+            return 0;
+        } else if (fu <= 30) {
+            return 500;
+        } else if (fu <= 40) {
+            return 700;
+        } else if (fu <= 50) {
+            return 800;
+        } else if (fu <= 60) {
+            return 1000;
+        } else if (fu <= 70) {
+            return 1200;
+        } else if (fu <= 80) {
+            return 1300;
+        } else {
+            return 1500;
+        }
+    } else if (fan == 2) {
+        if (fu <= 20) {
+            return 700;
+        } else if (fu == 25) {
+            return 0;
+        } else if (fu <= 30) {
+            return 1000;
+        } else if (fu <= 40) {
+            return 1300;
+        } else if (fu <= 50) {
+            return 1600;
+        } else if (fu <= 60) {
+            return 2000;
+        } else if (fu <= 70) {
+            return 2300;
+        } else if (fu <= 80) {
+            return 2600;
+        } else {
+            return 2900;
+        }
+    } else if (fan == 3) {
+        if (fu <= 20) {
+            return 1300;
+        } else if (fu == 25) {
+            return 1600;
+        } else if (fu <= 30) {
+            return 2000;
+        } else if (fu <= 40) {
+            return 2600;
+        } else if (fu <= 50) {
+            return 3200;
+        } else if (fu <= 60) {
+            return 3900;
+        } else {
+            return 4000; // Mangan
+        }
+    } else if (fan == 4) {
+        if (fu <= 20) {
+            return 2600;
+        } else if (fu == 25) {
+            return 3200;
+        } else if (fu <= 30) {
+            return 3900;
+        } else {
+            return 4000; // Mangan
+        }
+    } else if (fan == 5) {
+        return 4000; // Mangan
+    } else if (fan <= 7) {
+        return 6000; // Haneman
+    } else if (fan <= 10) {
+        return 8000; // Baiman
+    } else if (fan <= 12) {
+        return 12000;
+    } else if (fan <= 25) {
+        return 16000;
+    } else if (fan <= 38) {
+        return 32000;
+    } else {
+        return 48000;
+    }
+}
+
+static int referenceDealerRon(int fu, int fan) {
+    if (fan == 1) {
+        if (fu <= 20) {
+            return 0;
+        } else if (fu == 25) {
+            return 0;
+        } else if (fu <= 30) {
+            return 1500;
+        } else if (fu <= 40) {
+            return 2000;
+        } else if (fu <= 50) {
+            return 2400;
+        } else if (fu <= 60) {
+            return 2900;
+        } else if (fu <= 70) {
+            return 3400;
+        } else if (fu <= 80) {
+            return 3900;
+        } else {
+            return 4400;
+        }
+    } else if (fan == 2) {
+        if (fu <= 20) {
+            return 2000;
+        } else if (fu == 25) {
+            return 2400;
+        } else if (fu <= 30) {
+            return 2900;
+        } else if (fu <= 40) {
+            return 3900;
+        } else if (fu <= 50) {
+            return 4800;
+        } else if (fu <= 60) {
+            return 5800;
+        } else if (fu <= 70) {
+            return 6800;
+        } else if (fu <= 80) {
+            return 7700;
+        } else {
+            return 8700;
+        }
+    } else if (fan == 3) {
+        if (fu <= 20) {
+            return 3900;
+        } else if (fu == 25) {
+            return 4800;
+        } else if (fu <= 30) {
+            return 5800;
+        } else if (fu <= 40) {
+            return 7700;
+        } else if (fu <= 50) {
+            return 9600;
+        } else if (fu <= 60) {
+            return 11600;
+        } else {
+            return 12000; // Mangan
+        }
+    } else if (fan == 4) {
+        if (fu <= 20) {
+            return 7700;
+        } else if (fu == 25) {
+            return 9600;
+        } else if (fu <= 30) {
+            return 11600;
+        } else {
+            return 12000; // Mangan
+        }
+    } else if (fan == 5) {
+        return 12000; // Mangan
+    } else if (fan <= 7) {
+        return 18000; // Haneman
+    } else if (fan <= 10) {
+        return 24000; // Baiman
+    } else if (fan <= 12) {
+        return 36000;
+    } else if (fan <= 25) {
+        return 48000;
+    } else if (fan <= 38) {
+        return 96000;
+    } else {
+        return 144000;
+    }
+}
+
+static int referenceNonDealerTsumo(int fu, int fan) {
+    if (fan == 1) {
+        if (fu <= 20) {
+            return 0;
+        } else if (fu == 25) {
+            return 0;
+        } else if (fu <= 30) {
+            return 300;
+        } else if (fu <= 40) {
+            return 400;
+        } else if (fu <= 50) {
+            return 400;
+        } else if (fu <= 60) {
+            return 500;
+        } else if (fu <= 70) {
+            return 600;
+        } else if (fu <= 80) {
+            return 700;
+        } else {
+            return 800;
+        }
+    } else if (fan == 2) {
+        if (fu <= 20) {
+            return 400;
+        } else if (fu == 25) {
+            return 0;
+        } else if (fu <= 30) {
+            return 500;
+        } else if (fu <= 40) {
+            return 700;
+        } else if (fu <= 50) {
+            return 800;
+        } else if (fu <= 60) {
+            return 1000;
+        } else if (fu <= 70) {
+            return 1200;
+        } else if (fu <= 80) {
+            return 1300;
+        } else {
+            return 1500;
+        }
+    } else if (fan == 3) {
+        if (fu <= 20) {
+            return 700;
+        } else if (fu == 25) {
+            return 800;
+        } else if (fu <= 30) {
+            return 1000;
+        } else if (fu <= 40) {
+            return 1300;
+        } else if (fu <= 50) {
+            return 1600;
+        } else {
+            return 2000; // Mangan
+        }
+    } else if (fan == 4) {
+        if (fu <= 20) {
+            return 1300;
+        } else if (fu == 25) {
+            return 1600;
+        } else {
+            return 2000; // Mangan
+        }
+    } else if (fan == 5) {
+        return 2000; // Mangan
+    } else if (fan <= 7) {
+        return 3000; // Haneman
+    } else if (fan <= 10) {
+        return 4000; // Baiman
+    } else if (fan <= 12) {
+        return 6000;
+    } else if (fan <= 25) {
+        return 8000;
+    } else if (fan <= 38) {
+        return 16000;
+    } else {
+        return 24000;
+    }
+}
+
+static int referenceNonDealerRon(int fu, int fan) {
+    if (fan == 1) {
+        if (fu <= 20) {
+            return 0;
+        } else if (fu == 25) {
+            return 0;
+        } else if (fu <= 30) {
+            return 1000;
+        } else if (fu <= 40) {
+            return 1300;
+        } else if (fu <= 50) {
+            return 1600;
+        } else if (fu <= 60) {
+            return 2000;
+        } else if (fu <= 70) {
+            return 2300;
+        } else if (fu <= 80) {
+            return 2600;
+        } else {
+            return 2900;
+        }
+    } else if (fan == 2) {
+        if (fu <= 20) {
+            return 1600;
+        } else if (fu == 25) {
+            return 1600;
+        } else if (fu <= 30) {
+            return 2000;
+        } else if (fu <= 40) {
+            return 3600;
+        } else if (fu <= 50) {
+            return 3200;
+        } else if (fu <= 60) {
+            return 3900;
+        } else if (fu <= 70) {
+            return 4500;
+        } else if (fu <= 80) {
+            return 5200;
+        } else {
+            return 5800;
+        }
+    } else if (fan == 3) {
+        if (fu <= 20) {
+            return 2800;
+        } else if (fu == 25) {
+            return 3200;
+        } else if (fu <= 30) {
+            return 3900;
+        } else if (fu <= 40) {
+            return 5200;
+        } else if (fu <= 50) {
+            return 6400;
+        } else if (fu <= 60) {
+            return 7700;
+        } else {
+            return 8000; // Mangan
+        }
+    } else if (fan == 4) {
+        if (fu <= 20) {
+            return 5200;
+        } else if (fu == 25) {
+            return 6400;
+        } else if (fu <= 30) {
+            return 7700;
+        } else {
+            return 8000; // Mangan
+        }
+    } else if (fan == 5) {
+        return 8000; // Mangan
+    } else if (fan <= 7) {
+        return 12000; // Haneman
+    } else if (fan <= 10) {
+        return 16000; // Baiman
+    } else if (fan <= 12) {
+        return 24000;
+    } else if (fan <= 25) { // Yakuman
+        return 32000;
+    } else if (fan <= 38) { // Double Yakuman
+        return 64000;
+    } else {
+        return 96000;
+    }
+}
+
+/**
+ * @brief Check every entry of the tables against the reference payments,
+ * for fu and fan scores beyond both ends of the rows and columns
+ *
+ * @return the number of mismatches
+ */
+static int checkPayments() {
+    int (*const references[VictoryPayments::N_TABLES])(int, int) = {
+        referenceDealerTsumo, referenceDealerRon, referenceNonDealerTsumo,
+        referenceNonDealerRon};
+    int mismatches = 0;
+    for (int table = 0; table < VictoryPayments::N_TABLES; table++) {
+        for (int fan = -1; fan <= 50; fan++) {
+            for (int fu = -1; fu <= 130; fu++) {
+                const int payment = VictoryPayments::payment(
+                    static_cast<VictoryPayments::Table>(table), fu, fan);
+                const int expected = references[table](fu, fan);
+                if (payment != expected) {
+                    std::fprintf(stderr,
+                                 "Table %d, %d fu, %d fan: %d instead of %d\n",
+                                 table, fu, fan, payment, expected);
+                    mismatches++;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * @brief Random game of victories, draws and manual results
+ */
+static ScoresheetData randomGame(std::mt19937 &random, int n_players,
+                                 int n_turns) {
+    ScoresheetData data;
+    data.n_players = n_players;
+    for (int player = 0; player < n_players; player++) {
+        data.player_names.push_back(QString("Player %1").arg(player + 1));
+    }
+    for (int turn = 0; turn < n_turns; turn++) {
+        const int east = random() % n_players;
+        const int winner = random() % n_players;
+        const int kind = random() % 8;
+        if (kind == 0) {
+            std::vector<bool> tenpai(n_players);
+            for (int player = 0; player < n_players; player++) {
+                tenpai[player] = random() % 2;
+            }
+            data.turn_results.emplace_back(tenpai, east, winner);
+            continue;
+        } else if (kind == 1) {
+            std::vector<int> scores(n_players);
+            for (int player = 0; player < n_players; player++) {
+                scores[player] = (static_cast<int>(random() % 81) - 40) * 100;
+            }
+            data.turn_results.emplace_back(scores, east, winner);
+            continue;
+        }
+        const bool ron = kind % 2 == 0;
+        int loser = winner;
+        while (ron && loser == winner) {
+            loser = random() % n_players;
+        }
+        // No riichi of the absent seat of a 3-player game
+        const int riichi_mask = random() % (1 << n_players);
+        data.turn_results.emplace_back(
+            east, winner, ron ? 1 : 0, ron ? loser : 0, riichi_mask & 1,
+            riichi_mask & 2, riichi_mask & 4, riichi_mask & 8,
+            static_cast<int>(random() % 132) - 1,
+            static_cast<int>(random() % 52) - 1);
+    }
+    return data;
+}
+
+/**
+ * @brief Check the score changes of TurnColumns (computed by the kernel for
+ * the victories) against the scoring of each turn
+ *
+ * @return the number of mismatches
+ */
+static int checkKernel() {
+    std::mt19937 random(42);
+    std::vector<ScoresheetData> games;
+    TurnColumns columns;
+    for (int game = 0; game < 200; game++) {
+        games.push_back(randomGame(random, 3 + game % 2, 1000));
+        columns.addGame(games.back());
+    }
+    int mismatches = 0;
+    for (int game = 0; game < columns.gameCount(); game++) {
+        const ScoresheetData &data = games[game];
+        for (size_t turn = 0; turn < data.turn_results.size(); turn++) {
+            const std::vector<int> expected =
+                data.turn_results[turn].computeScoreChange(data.n_players);
+            const int index = columns.gameBegin(game) + static_cast<int>(turn);
+            for (int seat = 0; seat < data.n_players; seat++) {
+                const int score_change = columns.scoreChanges(seat)[index];
+                if (score_change != expected[seat]) {
+                    std::fprintf(stderr,
+                                 "Game %d, turn %d, seat %d: %d instead of "
+                                 "%d\n",
+                                 game, static_cast<int>(turn), seat,
+                                 score_change, expected[seat]);
+                    mismatches++;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+int main() {
+    const int mismatches = checkPayments() + checkKernel();
+    if (mismatches != 0) {
+        std::fprintf(stderr, "%d mismatches\n", mismatches);
+        return 1;
+    }
+    return 0;
+}